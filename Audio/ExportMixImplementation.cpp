@@ -9,6 +9,8 @@
 */
 
 #include <Audio/ExportMixImplementation.h>
+#include <Audio/LoudnessMeter.h>
+#include <Audio/SignalKernels.h>
 #include <Utils/AssortedUtils.h>
 
 namespace jucyaudio
@@ -21,7 +23,8 @@ namespace jucyaudio
                                              [[maybe_unused]] double targetSampleRate, [[maybe_unused]] int targetNumChannels)
             : trackId{id},
               trackInfoPtr{ti},
-              mixTrackDefPtr{mtd}
+              mixTrackDefPtr{mtd},
+              normalizationGain{loudnessNormalizationGain(*ti)}
         {
             juce::File sourceFile{pathToString(trackInfoPtr->filepath)};
             reader.reset(formatManager.createReaderFor(sourceFile));
@@ -236,6 +239,34 @@ namespace jucyaudio
         }
 
 
+        void ExportMixImplementation::meterOutputBlock(const juce::AudioBuffer<float> &masterOutputBlock, int numSamples)
+        {
+            for (int ch = 0; ch < masterOutputBlock.getNumChannels(); ++ch)
+            {
+                const float *samples = masterOutputBlock.getReadPointer(ch);
+                m_outputPeak = std::max(m_outputPeak, peakMagnitude(samples, static_cast<size_t>(numSamples)));
+                m_outputSumOfSquares += sumOfSquares(samples, static_cast<size_t>(numSamples));
+            }
+            m_outputSamplesMetered += static_cast<juce::int64>(numSamples) * masterOutputBlock.getNumChannels();
+        }
+
+        void ExportMixImplementation::logOutputLevels() const
+        {
+            if (m_outputSamplesMetered == 0)
+                return;
+
+            const auto toDb = [](double linear)
+            {
+                return linear > 0.0 ? 20.0 * std::log10(linear) : -144.0;
+            };
+            const double rms = std::sqrt(m_outputSumOfSquares / static_cast<double>(m_outputSamplesMetered));
+            spdlog::info("MTE: Output level: peak {:.2f} dBFS, RMS {:.2f} dBFS", toDb(m_outputPeak), toDb(rms));
+            if (m_outputPeak > 1.0f)
+            {
+                spdlog::warn("MTE: Mix {} clips: peak is {:.2f} dB over full scale", m_mixId, toDb(m_outputPeak));
+            }
+        }
+
         bool ExportMixImplementation::fail(const std::string &errorMessage)
         {
             spdlog::error("MTE: {}", errorMessage);
@@ -324,6 +355,10 @@ namespace jucyaudio
                 spdlog::error("MTE: Failed to read samples for track ID {} from source file: {}", mixTrackDef.trackId, pathToString(trackInfo.filepath));
                 return false;
             }
+            if (activeSource.normalizationGain != 1.0f)
+            {
+                sourceTrackBlock.applyGain(0, (int)numSamplesToReadForThisTrackInBlock, activeSource.normalizationGain);
+            }
 
             // SampleContext for this specific track's contribution within the block
             SampleContext trackContext = overallContext;
@@ -38,6 +38,7 @@ namespace jucyaudio
 
             std::unique_ptr<juce::AudioFormatReader> reader;
             std::unique_ptr<juce::AudioFormatReaderSource> readerSource;
+            float normalizationGain{1.0f}; // Loudness normalization from the analysis pass, applied before the envelope
             // Optional: std::unique_ptr<juce::ResamplingAudioSource> resamplerSource;
             // Add other state needed per active track, e.g., current read position in source file
 
@@ -92,6 +93,10 @@ namespace jucyaudio
                                             const SampleContext &overallContext, // Overall timeline context
                                             juce::AudioBuffer<float> &masterOutputBlock);
 
+            // @brief Accumulate peak and RMS of the rendered mix, block by block, for the end-of-export level report.
+            void meterOutputBlock(const juce::AudioBuffer<float> &masterOutputBlock, int numSamples);
+            void logOutputLevels() const;
+
             const MixExporterProgressCallback m_progressCallback;
             const std::filesystem::path m_targetFilepath;
 
@@ -101,6 +106,9 @@ namespace jucyaudio
             juce::AudioFormatManager m_formatManager;
             std::unique_ptr<juce::AudioFormatWriter> m_writer;
             std::vector<ActiveTrackSource> m_activeSources;
+            float m_outputPeak{0.0f};
+            double m_outputSumOfSquares{0.0};
+            juce::int64 m_outputSamplesMetered{0};
 
             // TBD: Determine Output Format Properties (Sample Rate, Channels)
             //    - Iterate through tracks, find the highest sample rate, max channels, or enforce a standard.
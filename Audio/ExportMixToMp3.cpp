@@ -117,6 +117,7 @@ namespace jucyaudio
                         continue;
                     contributeFromActiveSource(activeSource, context, masterOutputBlock);
                 }
+                meterOutputBlock(masterOutputBlock, static_cast<int>(context.samplesToProcessInThisBlock));
 
                 // --- MP3 Encoding with LAME (NOT using m_writer) ---
                 if (!m_lameFlags || !m_mp3Buffer || !m_outputStream)
@@ -204,6 +205,7 @@ namespace jucyaudio
             m_outputStream->write(id3v1, id3v1bytes);
 
             spdlog::info("MP3 export finished for mix ID: {}", m_mixId);
+            logOutputLevels();
             if (m_progressCallback)
                 m_progressCallback(1.0f, "Export complete.");
 
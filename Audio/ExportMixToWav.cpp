@@ -74,6 +74,7 @@ namespace jucyaudio
                     // No per-block timing needed for the log here, use overall block timing.
                     contributeFromActiveSource(activeSource, context, masterOutputBlock);
                 }
+                meterOutputBlock(masterOutputBlock, (int)context.samplesToProcessInThisBlock);
 
                 // Write the processed masterOutputBlock to the file
                 m_writer->writeFromAudioSampleBuffer(masterOutputBlock, 0, (int)context.samplesToProcessInThisBlock);
@@ -93,6 +94,7 @@ namespace jucyaudio
             m_writer->flush();
             // Writer (and its owned stream) and readers are cleaned up by unique_ptr.
             spdlog::info("Mix export finished for mix ID: {}", m_mixId);
+            logOutputLevels();
             if (m_progressCallback)
                 m_progressCallback(1.0f, "Export complete.");
             return true;
@@ -0,0 +1,260 @@
+#include <Audio/LoudnessMeter.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numbers>
+
+namespace jucyaudio
+{
+    namespace audio
+    {
+        namespace
+        {
+            constexpr double ABSOLUTE_GATE_LUFS = -70.0;
+            constexpr double INTEGRATED_RELATIVE_GATE_LU = -10.0;
+            constexpr double RANGE_RELATIVE_GATE_LU = -20.0;
+            constexpr size_t SUB_BLOCKS_PER_MOMENTARY = 4;   // 400 ms
+            constexpr size_t SUB_BLOCKS_PER_SHORT_TERM = 30; // 3 s
+            constexpr double SILENCE_DB = -144.0;
+
+            // Never boost quiet material by more than this, however low its measured loudness
+            constexpr double MAX_NORMALIZATION_BOOST_DB = 12.0;
+
+            double powerToLufs(double power)
+            {
+                return power > 0.0 ? -0.691 + 10.0 * std::log10(power) : -std::numeric_limits<double>::infinity();
+            }
+
+            double lufsToPower(double lufs)
+            {
+                return std::pow(10.0, (lufs + 0.691) / 10.0);
+            }
+
+            // Mean power of all windows that pass the absolute gate and the relative gate derived from them
+            std::vector<double> gateWindows(const std::vector<double> &windowPowers, double relativeGateLu)
+            {
+                std::vector<double> aboveAbsolute;
+                aboveAbsolute.reserve(windowPowers.size());
+                const double absoluteThreshold = lufsToPower(ABSOLUTE_GATE_LUFS);
+                for (const double power : windowPowers)
+                {
+                    if (power > absoluteThreshold)
+                        aboveAbsolute.push_back(power);
+                }
+                if (aboveAbsolute.empty())
+                    return {};
+
+                double sum = 0.0;
+                for (const double power : aboveAbsolute)
+                    sum += power;
+                const double relativeThreshold = lufsToPower(powerToLufs(sum / aboveAbsolute.size()) + relativeGateLu);
+
+                std::vector<double> gated;
+                gated.reserve(aboveAbsolute.size());
+                for (const double power : aboveAbsolute)
+                {
+                    if (power > relativeThreshold)
+                        gated.push_back(power);
+                }
+                return gated;
+            }
+
+            // Sliding mean over `windowLength` consecutive sub-blocks, advancing one sub-block at a time
+            std::vector<double> slidingWindowPowers(const std::vector<double> &subBlockPowers, size_t windowLength)
+            {
+                std::vector<double> result;
+                if (subBlockPowers.size() < windowLength)
+                    return result;
+                result.reserve(subBlockPowers.size() - windowLength + 1);
+                double running = 0.0;
+                for (size_t i = 0; i < subBlockPowers.size(); ++i)
+                {
+                    running += subBlockPowers[i];
+                    if (i >= windowLength)
+                        running -= subBlockPowers[i - windowLength];
+                    if (i + 1 >= windowLength)
+                        result.push_back(std::max(0.0, running) / windowLength);
+                }
+                return result;
+            }
+        } // namespace
+
+        LoudnessMeter::LoudnessMeter(double sampleRate, int numChannels)
+            : m_sampleRate{sampleRate},
+              m_numChannels{numChannels},
+              m_subBlockSize{std::max<int64_t>(1, static_cast<int64_t>(std::llround(sampleRate * 0.1)))}
+        {
+            // K-weighting pre-filter (BS.1770-4 stage 1: high shelf, stage 2: RLB high-pass), derived for the actual
+            // sample rate rather than the 48 kHz table in the standard.
+            {
+                const double f0 = 1681.974450955533;
+                const double G = 3.999843853973347;
+                const double Q = 0.7071752369554196;
+                const double K = std::tan(std::numbers::pi * f0 / m_sampleRate);
+                const double Vh = std::pow(10.0, G / 20.0);
+                const double Vb = std::pow(Vh, 0.4996667741545416);
+                const double a0 = 1.0 + K / Q + K * K;
+                m_shelf.b0 = (Vh + Vb * K / Q + K * K) / a0;
+                m_shelf.b1 = 2.0 * (K * K - Vh) / a0;
+                m_shelf.b2 = (Vh - Vb * K / Q + K * K) / a0;
+                m_shelf.a1 = 2.0 * (K * K - 1.0) / a0;
+                m_shelf.a2 = (1.0 - K / Q + K * K) / a0;
+            }
+            {
+                const double f0 = 38.13547087602444;
+                const double Q = 0.5003270373238773;
+                const double K = std::tan(std::numbers::pi * f0 / m_sampleRate);
+                const double a0 = 1.0 + K / Q + K * K;
+                m_highpass.b0 = 1.0;
+                m_highpass.b1 = -2.0;
+                m_highpass.b2 = 1.0;
+                m_highpass.a1 = 2.0 * (K * K - 1.0) / a0;
+                m_highpass.a2 = (1.0 - K / Q + K * K) / a0;
+            }
+
+            // Channel weights: L, R, C count once, surround channels +1.5 dB, LFE (4th of a 5.1 layout) is ignored
+            m_channelWeights.resize(std::max(0, numChannels), 1.0);
+            for (int ch = 3; ch < numChannels; ++ch)
+            {
+                m_channelWeights[ch] = (numChannels == 6 && ch == 3) ? 0.0 : 1.41;
+            }
+
+            // True peak: oversample to at least 176.4 kHz with a windowed-sinc polyphase interpolator
+            m_oversampling = m_sampleRate < 96000.0 ? 4 : (m_sampleRate < 192000.0 ? 2 : 1);
+            const int totalTaps = m_oversampling * m_tapsPerPhase;
+            m_interpolator.resize(totalTaps);
+            // Centred on a tap, so phase 0 is the input sample itself (already counted) and the other phases are the
+            // points between samples. The window is centred with it; the one tap past its end would be a zero anyway.
+            const int centre = m_tapsPerPhase / 2 * m_oversampling;
+            for (int n = 0; n < totalTaps; ++n)
+            {
+                const double x = static_cast<double>(n - centre) / m_oversampling;
+                const double sinc = (n == centre) ? 1.0 : std::sin(std::numbers::pi * x) / (std::numbers::pi * x);
+                const double window = 0.5 - 0.5 * std::cos(std::numbers::pi * (n + 1) / (centre + 1));
+                m_interpolator[n] = static_cast<float>(sinc * window);
+            }
+
+            m_channels.resize(std::max(0, numChannels));
+            for (auto &state : m_channels)
+            {
+                // Doubled delay line so each phase can be evaluated over a contiguous range
+                state.history.assign(2 * m_tapsPerPhase, 0.0f);
+            }
+        }
+
+        double LoudnessMeter::kWeight(ChannelState &state, double sample) const
+        {
+            const double shelved = m_shelf.b0 * sample + state.shelfZ1;
+            state.shelfZ1 = m_shelf.b1 * sample - m_shelf.a1 * shelved + state.shelfZ2;
+            state.shelfZ2 = m_shelf.b2 * sample - m_shelf.a2 * shelved;
+
+            const double filtered = m_highpass.b0 * shelved + state.highpassZ1;
+            state.highpassZ1 = m_highpass.b1 * shelved - m_highpass.a1 * filtered + state.highpassZ2;
+            state.highpassZ2 = m_highpass.b2 * shelved - m_highpass.a2 * filtered;
+            return filtered;
+        }
+
+        void LoudnessMeter::updateTruePeak(ChannelState &state, float sample)
+        {
+            m_truePeak = std::max(m_truePeak, std::abs(sample));
+            if (m_oversampling == 1)
+                return;
+
+            state.history[state.historyPos] = sample;
+            state.history[state.historyPos + m_tapsPerPhase] = sample;
+            // Newest sample is at historyPos + taps, oldest at historyPos + 1
+            const float *newest = state.history.data() + state.historyPos + m_tapsPerPhase;
+            for (int phase = 1; phase < m_oversampling; ++phase)
+            {
+                float acc = 0.0f;
+                for (int k = 0; k < m_tapsPerPhase; ++k)
+                {
+                    acc += m_interpolator[phase + m_oversampling * k] * newest[-k];
+                }
+                m_truePeak = std::max(m_truePeak, std::abs(acc));
+            }
+            state.historyPos = (state.historyPos + 1) % m_tapsPerPhase;
+        }
+
+        void LoudnessMeter::finishSubBlock()
+        {
+            m_subBlockPowers.push_back(m_subBlockSum / static_cast<double>(m_subBlockSize));
+            m_subBlockSum = 0.0;
+            m_subBlockFill = 0;
+        }
+
+        void LoudnessMeter::process(const float *const *channelData, int numChannels, int numSamples)
+        {
+            const int channels = std::min(numChannels, m_numChannels);
+            int offset = 0;
+            while (offset < numSamples)
+            {
+                const int chunk = static_cast<int>(std::min<int64_t>(numSamples - offset, m_subBlockSize - m_subBlockFill));
+                for (int ch = 0; ch < channels; ++ch)
+                {
+                    ChannelState &state = m_channels[ch];
+                    const float *samples = channelData[ch] + offset;
+                    double sumOfSquares = 0.0;
+                    for (int i = 0; i < chunk; ++i)
+                    {
+                        const double z = kWeight(state, samples[i]);
+                        sumOfSquares += z * z;
+                        updateTruePeak(state, samples[i]);
+                    }
+                    m_subBlockSum += m_channelWeights[ch] * sumOfSquares;
+                }
+                m_subBlockFill += chunk;
+                offset += chunk;
+                if (m_subBlockFill == m_subBlockSize)
+                {
+                    finishSubBlock();
+                }
+            }
+        }
+
+        LoudnessResult LoudnessMeter::getResult() const
+        {
+            LoudnessResult result;
+            result.truePeakDbtp = m_truePeak > 0.0f ? 20.0 * std::log10(static_cast<double>(m_truePeak)) : SILENCE_DB;
+
+            const auto momentary = gateWindows(slidingWindowPowers(m_subBlockPowers, SUB_BLOCKS_PER_MOMENTARY), INTEGRATED_RELATIVE_GATE_LU);
+            if (momentary.empty())
+            {
+                result.integratedLufs = SILENCE_DB;
+                return result;
+            }
+            double sum = 0.0;
+            for (const double power : momentary)
+                sum += power;
+            result.integratedLufs = powerToLufs(sum / momentary.size());
+            result.valid = true;
+
+            auto shortTerm = gateWindows(slidingWindowPowers(m_subBlockPowers, SUB_BLOCKS_PER_SHORT_TERM), RANGE_RELATIVE_GATE_LU);
+            if (!shortTerm.empty())
+            {
+                std::sort(shortTerm.begin(), shortTerm.end());
+                const auto percentile = [&shortTerm](double p)
+                {
+                    const size_t index = static_cast<size_t>(std::llround(p * (shortTerm.size() - 1)));
+                    return powerToLufs(shortTerm[index]);
+                };
+                result.loudnessRangeLu = percentile(0.95) - percentile(0.10);
+            }
+            return result;
+        }
+
+        float loudnessNormalizationGain(const database::TrackInfo &trackInfo, double targetLufs)
+        {
+            if (!trackInfo.loudness_lufs.has_value())
+                return 1.0f;
+
+            double gainDb = std::min(targetLufs - *trackInfo.loudness_lufs, MAX_NORMALIZATION_BOOST_DB);
+            if (trackInfo.true_peak_db.has_value())
+            {
+                gainDb = std::min(gainDb, LOUDNESS_TRUE_PEAK_CEILING_DBTP - *trackInfo.true_peak_db);
+            }
+            return static_cast<float>(std::pow(10.0, gainDb / 20.0));
+        }
+
+    } // namespace audio
+} // namespace jucyaudio
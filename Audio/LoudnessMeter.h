@@ -0,0 +1,82 @@
+#pragma once
+
+#include <Database/Includes/TrackInfo.h>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace jucyaudio
+{
+    namespace audio
+    {
+        // Target loudness used when normalizing tracks for playback and export (streaming-service convention)
+        constexpr double LOUDNESS_TARGET_LUFS = -14.0;
+
+        // Normalization never pushes the true peak of a track above this ceiling
+        constexpr double LOUDNESS_TRUE_PEAK_CEILING_DBTP = -1.0;
+
+        struct LoudnessResult
+        {
+            double integratedLufs = 0.0; // EBU R128 integrated loudness (LUFS)
+            double loudnessRangeLu = 0.0; // EBU Tech 3342 loudness range (LU)
+            double truePeakDbtp = 0.0;   // ITU-R BS.1770-4 true peak (dBTP)
+            bool valid = false;          // false if the signal never rose above the absolute gate
+        };
+
+        // @brief Incremental ITU-R BS.1770-4 / EBU R128 meter.
+        //
+        // Feed it blocks of planar float samples in any block size; call getResult() at the end. The meter only keeps
+        // one mean-square value per 100 ms of audio, so it can run alongside other analysis on an already-decoded
+        // buffer without holding a second copy of the signal.
+        class LoudnessMeter
+        {
+        public:
+            LoudnessMeter(double sampleRate, int numChannels);
+
+            void process(const float *const *channelData, int numChannels, int numSamples);
+            LoudnessResult getResult() const;
+
+        private:
+            struct Biquad
+            {
+                double b0{1.0}, b1{0.0}, b2{0.0}, a1{0.0}, a2{0.0};
+            };
+
+            struct ChannelState
+            {
+                double shelfZ1{0.0}, shelfZ2{0.0};
+                double highpassZ1{0.0}, highpassZ2{0.0};
+                std::vector<float> history; // true-peak interpolator delay line
+                size_t historyPos{0};
+            };
+
+            double kWeight(ChannelState &state, double sample) const;
+            void updateTruePeak(ChannelState &state, float sample);
+            void finishSubBlock();
+
+            const double m_sampleRate;
+            const int m_numChannels;
+            Biquad m_shelf;
+            Biquad m_highpass;
+            std::vector<ChannelState> m_channels;
+            std::vector<double> m_channelWeights;
+
+            // 100 ms gating sub-blocks: 400 ms momentary blocks overlap by 75%, 3 s short-term windows by 29/30
+            const int64_t m_subBlockSize;
+            int64_t m_subBlockFill{0};
+            double m_subBlockSum{0.0};
+            std::vector<double> m_subBlockPowers;
+
+            // 4x (or 2x at high sample rates) polyphase interpolator for true-peak detection
+            int m_oversampling{4};
+            int m_tapsPerPhase{12};
+            std::vector<float> m_interpolator;
+            float m_truePeak{0.0f};
+        };
+
+        // @brief Linear gain that brings the track to LOUDNESS_TARGET_LUFS without exceeding the true-peak ceiling.
+        // Returns 1.0 for tracks that have not been analyzed yet.
+        float loudnessNormalizationGain(const database::TrackInfo &trackInfo, double targetLufs = LOUDNESS_TARGET_LUFS);
+
+    } // namespace audio
+} // namespace jucyaudio
@@ -0,0 +1,173 @@
+#include <Audio/SignalKernels.h>
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__)
+#define JUCYAUDIO_SIMD_AVX2 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JUCYAUDIO_SIMD_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define JUCYAUDIO_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace jucyaudio
+{
+    namespace audio
+    {
+        namespace
+        {
+            // Float lanes stay accurate over a few thousand samples; longer ranges are split and summed in double
+            constexpr size_t SUM_OF_SQUARES_CHUNK = 4096;
+
+            double sumOfSquaresChunk(const float *samples, size_t count)
+            {
+                size_t i = 0;
+                double sum = 0.0;
+#if JUCYAUDIO_SIMD_AVX2
+                __m256 acc0 = _mm256_setzero_ps();
+                __m256 acc1 = _mm256_setzero_ps();
+                for (; i + 16 <= count; i += 16)
+                {
+                    const __m256 a = _mm256_loadu_ps(samples + i);
+                    const __m256 b = _mm256_loadu_ps(samples + i + 8);
+                    acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(a, a));
+                    acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(b, b));
+                }
+                const __m256 acc = _mm256_add_ps(acc0, acc1);
+                __m128 lanes = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+                lanes = _mm_add_ps(lanes, _mm_movehl_ps(lanes, lanes));
+                lanes = _mm_add_ss(lanes, _mm_shuffle_ps(lanes, lanes, 0x55));
+                sum = _mm_cvtss_f32(lanes);
+#elif JUCYAUDIO_SIMD_SSE2
+                __m128 acc0 = _mm_setzero_ps();
+                __m128 acc1 = _mm_setzero_ps();
+                for (; i + 8 <= count; i += 8)
+                {
+                    const __m128 a = _mm_loadu_ps(samples + i);
+                    const __m128 b = _mm_loadu_ps(samples + i + 4);
+                    acc0 = _mm_add_ps(acc0, _mm_mul_ps(a, a));
+                    acc1 = _mm_add_ps(acc1, _mm_mul_ps(b, b));
+                }
+                __m128 lanes = _mm_add_ps(acc0, acc1);
+                lanes = _mm_add_ps(lanes, _mm_movehl_ps(lanes, lanes));
+                lanes = _mm_add_ss(lanes, _mm_shuffle_ps(lanes, lanes, 0x55));
+                sum = _mm_cvtss_f32(lanes);
+#elif JUCYAUDIO_SIMD_NEON
+                float32x4_t acc0 = vdupq_n_f32(0.0f);
+                float32x4_t acc1 = vdupq_n_f32(0.0f);
+                for (; i + 8 <= count; i += 8)
+                {
+                    const float32x4_t a = vld1q_f32(samples + i);
+                    const float32x4_t b = vld1q_f32(samples + i + 4);
+                    acc0 = vmlaq_f32(acc0, a, a);
+                    acc1 = vmlaq_f32(acc1, b, b);
+                }
+                sum = vaddvq_f32(vaddq_f32(acc0, acc1));
+#endif
+                for (; i < count; ++i)
+                {
+                    sum += static_cast<double>(samples[i]) * samples[i];
+                }
+                return sum;
+            }
+        } // namespace
+
+        double sumOfSquares(const float *samples, size_t count)
+        {
+            double sum = 0.0;
+            for (size_t offset = 0; offset < count; offset += SUM_OF_SQUARES_CHUNK)
+            {
+                sum += sumOfSquaresChunk(samples + offset, std::min(SUM_OF_SQUARES_CHUNK, count - offset));
+            }
+            return sum;
+        }
+
+        float peakMagnitude(const float *samples, size_t count)
+        {
+            size_t i = 0;
+            float peak = 0.0f;
+#if JUCYAUDIO_SIMD_AVX2
+            const __m256 signMask = _mm256_set1_ps(-0.0f);
+            __m256 acc = _mm256_setzero_ps();
+            for (; i + 8 <= count; i += 8)
+            {
+                acc = _mm256_max_ps(acc, _mm256_andnot_ps(signMask, _mm256_loadu_ps(samples + i)));
+            }
+            __m128 lanes = _mm_max_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+            lanes = _mm_max_ps(lanes, _mm_movehl_ps(lanes, lanes));
+            lanes = _mm_max_ss(lanes, _mm_shuffle_ps(lanes, lanes, 0x55));
+            peak = _mm_cvtss_f32(lanes);
+#elif JUCYAUDIO_SIMD_SSE2
+            const __m128 signMask = _mm_set1_ps(-0.0f);
+            __m128 acc = _mm_setzero_ps();
+            for (; i + 4 <= count; i += 4)
+            {
+                acc = _mm_max_ps(acc, _mm_andnot_ps(signMask, _mm_loadu_ps(samples + i)));
+            }
+            acc = _mm_max_ps(acc, _mm_movehl_ps(acc, acc));
+            acc = _mm_max_ss(acc, _mm_shuffle_ps(acc, acc, 0x55));
+            peak = _mm_cvtss_f32(acc);
+#elif JUCYAUDIO_SIMD_NEON
+            float32x4_t acc = vdupq_n_f32(0.0f);
+            for (; i + 4 <= count; i += 4)
+            {
+                acc = vmaxq_f32(acc, vabsq_f32(vld1q_f32(samples + i)));
+            }
+            peak = vmaxvq_f32(acc);
+#endif
+            for (; i < count; ++i)
+            {
+                peak = std::max(peak, std::abs(samples[i]));
+            }
+            return peak;
+        }
+
+        SlidingRms::SlidingRms(int hopSize, int hopsPerWindow)
+            : m_hopSize{std::max(1, hopSize)},
+              m_hopsPerWindow{std::max(1, hopsPerWindow)},
+              m_recentHops(static_cast<size_t>(m_hopsPerWindow), 0.0)
+        {
+        }
+
+        void SlidingRms::process(const float *const *channelData, int numChannels, int numSamples)
+        {
+            m_numChannels = numChannels;
+            int offset = 0;
+            while (offset < numSamples)
+            {
+                const int chunk = std::min(numSamples - offset, m_hopSize - m_hopFill);
+                for (int ch = 0; ch < numChannels; ++ch)
+                {
+                    m_hopSum += sumOfSquares(channelData[ch] + offset, static_cast<size_t>(chunk));
+                }
+                m_hopFill += chunk;
+                offset += chunk;
+                if (m_hopFill == m_hopSize)
+                {
+                    finishHop();
+                }
+            }
+        }
+
+        void SlidingRms::finishHop()
+        {
+            m_recentHops[m_hopsSeen % m_recentHops.size()] = m_hopSum;
+            ++m_hopsSeen;
+            m_hopSum = 0.0;
+            m_hopFill = 0;
+            if (m_hopsSeen < m_recentHops.size() || m_numChannels <= 0)
+                return;
+
+            // Re-add the few hop sums rather than keeping a running difference, which would drift over a long track
+            double windowSum = 0.0;
+            for (const double hopSum : m_recentHops)
+                windowSum += hopSum;
+            const double windowSamples = static_cast<double>(m_hopSize) * m_hopsPerWindow * m_numChannels;
+            m_windowRms.push_back(static_cast<float>(std::sqrt(windowSum / windowSamples)));
+        }
+
+    } // namespace audio
+} // namespace jucyaudio
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace jucyaudio
+{
+    namespace audio
+    {
+        // Vectorized sample kernels shared by track analysis and export metering. The instruction set is chosen at
+        // compile time (AVX2 when the build enables it, otherwise SSE2 on x86-64 and NEON on arm64) with a scalar
+        // fallback for everything else, so results only differ from the scalar loop by float rounding.
+
+        // @brief Sum of x^2 over `count` samples. Lanes accumulate in float over short runs and are folded into a
+        // double, so long buffers do not lose precision.
+        double sumOfSquares(const float *samples, size_t count);
+
+        // @brief Largest |x| over `count` samples, 0 for an empty range.
+        float peakMagnitude(const float *samples, size_t count);
+
+        // @brief Streaming RMS over overlapping windows of `hopsPerWindow` hops.
+        //
+        // Every sample is squared exactly once: each hop's sum of squares (over all channels) is kept and a window
+        // is the sum of the last `hopsPerWindow` hops, so 50% overlap costs nothing extra. Feed planar blocks of any
+        // size; one RMS value is produced per hop once the first window is full. A trailing partial hop is ignored.
+        class SlidingRms
+        {
+        public:
+            SlidingRms(int hopSize, int hopsPerWindow);
+
+            void process(const float *const *channelData, int numChannels, int numSamples);
+
+            // RMS of window k, which starts at sample k * hopSize
+            const std::vector<float> &getWindowRms() const
+            {
+                return m_windowRms;
+            }
+
+        private:
+            void finishHop();
+
+            const int m_hopSize;
+            const int m_hopsPerWindow;
+            int m_numChannels{0};
+            int m_hopFill{0};
+            double m_hopSum{0.0};
+            std::vector<double> m_recentHops; // ring buffer of the last m_hopsPerWindow hop sums
+            size_t m_hopsSeen{0};
+            std::vector<float> m_windowRms;
+        };
+
+    } // namespace audio
+} // namespace jucyaudio
@@ -0,0 +1,64 @@
+#include <Database/AnalysisQueue.h>
+#include <algorithm>
+
+namespace jucyaudio
+{
+    namespace database
+    {
+        void AnalysisQueue::boost(const std::vector<TrackId> &trackIds, AnalysisPriority priority)
+        {
+            const std::lock_guard<std::mutex> lock{m_mutex};
+            const int64_t generation = ++m_generation;
+            size_t position = 0;
+            for (const auto trackId : trackIds)
+            {
+                int level = static_cast<int>(priority);
+                if (const auto it = m_keys.find(trackId); it != m_keys.end())
+                {
+                    level = std::max(level, std::get<0>(it->second));
+                    m_order.erase(it->second);
+                }
+                const Key key{level, generation, position++};
+                m_order.emplace(key, trackId);
+                m_keys[trackId] = key;
+            }
+        }
+
+        std::optional<TrackId> AnalysisQueue::pop()
+        {
+            const std::lock_guard<std::mutex> lock{m_mutex};
+            if (m_order.empty())
+                return std::nullopt;
+
+            const auto it = m_order.begin();
+            const TrackId trackId = it->second;
+            m_order.erase(it);
+            m_keys.erase(trackId);
+            return trackId;
+        }
+
+        void AnalysisQueue::remove(TrackId trackId)
+        {
+            const std::lock_guard<std::mutex> lock{m_mutex};
+            if (const auto it = m_keys.find(trackId); it != m_keys.end())
+            {
+                m_order.erase(it->second);
+                m_keys.erase(it);
+            }
+        }
+
+        void AnalysisQueue::clear()
+        {
+            const std::lock_guard<std::mutex> lock{m_mutex};
+            m_order.clear();
+            m_keys.clear();
+        }
+
+        size_t AnalysisQueue::size() const
+        {
+            const std::lock_guard<std::mutex> lock{m_mutex};
+            return m_order.size();
+        }
+
+    } // namespace database
+} // namespace jucyaudio
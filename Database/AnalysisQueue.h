@@ -0,0 +1,65 @@
+#pragma once
+
+#include <Database/Includes/Constants.h>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace jucyaudio
+{
+    namespace database
+    {
+        /// @brief How urgently a track should be analyzed. Higher values are served first.
+        enum class AnalysisPriority
+        {
+            Background = 0,     ///< Whatever the database hands out when nothing was requested
+            VisibleInTable = 1, ///< Part of a working set or mix currently shown in the data view
+            OpenInEditor = 2    ///< Part of the mix currently open in the mix editor
+        };
+
+        /// @brief Demand-driven queue of tracks the UI wants analyzed ahead of the rest of the library.
+        ///
+        /// The UI boosts the tracks it is showing; the analysis task pops from here before falling back to the
+        /// database's own ordering. Within one priority the most recent boost wins, and within a boost the order of
+        /// the given ids is kept (so the top of a table is analyzed before its bottom). Thread-safe.
+        class AnalysisQueue final
+        {
+        public:
+            /// @brief Queue the tracks at the given priority. Tracks already queued keep the higher of both priorities
+            /// but move to the front of their level.
+            void boost(const std::vector<TrackId> &trackIds, AnalysisPriority priority);
+
+            /// @brief Removes and returns the most urgent track, or std::nullopt if nothing was boosted.
+            std::optional<TrackId> pop();
+
+            void remove(TrackId trackId);
+            void clear();
+            size_t size() const;
+
+        private:
+            // priority (desc), generation (desc), position within the boost (asc)
+            using Key = std::tuple<int, int64_t, size_t>;
+            struct KeyOrder
+            {
+                bool operator()(const Key &a, const Key &b) const
+                {
+                    if (std::get<0>(a) != std::get<0>(b))
+                        return std::get<0>(a) > std::get<0>(b);
+                    if (std::get<1>(a) != std::get<1>(b))
+                        return std::get<1>(a) > std::get<1>(b);
+                    return std::get<2>(a) < std::get<2>(b);
+                }
+            };
+
+            mutable std::mutex m_mutex;
+            std::map<Key, TrackId, KeyOrder> m_order;
+            std::unordered_map<TrackId, Key> m_keys;
+            int64_t m_generation{0};
+        };
+
+    } // namespace database
+} // namespace jucyaudio
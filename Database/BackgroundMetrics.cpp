@@ -0,0 +1,183 @@
+#include <Database/BackgroundMetrics.h>
+#include <Utils/TaskExecutor.h>
+#include <algorithm>
+#include <cassert>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace jucyaudio
+{
+    namespace database
+    {
+        BackgroundMetrics theBackgroundMetrics;
+
+        namespace
+        {
+            constexpr int COUNT_BITS = 24;
+            constexpr uint64_t COUNT_MASK = (uint64_t{1} << COUNT_BITS) - 1;
+
+            double toSeconds(std::chrono::nanoseconds duration)
+            {
+                return std::chrono::duration<double>(duration).count();
+            }
+        } // namespace
+
+        BackgroundMetrics::BackgroundMetrics()
+            : m_startTime{std::chrono::steady_clock::now()}
+        {
+        }
+
+        BackgroundMetrics::Counters &BackgroundMetrics::countersFor(JobType type)
+        {
+            const auto index = static_cast<size_t>(type) - 1;
+            assert(index < m_counters.size());
+            return m_counters[index];
+        }
+
+        const BackgroundMetrics::Counters &BackgroundMetrics::countersFor(JobType type) const
+        {
+            const auto index = static_cast<size_t>(type) - 1;
+            assert(index < m_counters.size());
+            return m_counters[index];
+        }
+
+        int64_t BackgroundMetrics::secondsSinceStart() const
+        {
+            return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - m_startTime).count();
+        }
+
+        void BackgroundMetrics::recordCompleted(JobType type)
+        {
+            Counters &counters = countersFor(type);
+            counters.completed.fetch_add(1, std::memory_order_relaxed);
+
+            const auto second = static_cast<uint64_t>(secondsSinceStart());
+            auto &slot = counters.perSecond[second % RATE_WINDOW_SECONDS];
+            uint64_t current = slot.load(std::memory_order_relaxed);
+            uint64_t updated;
+            do
+            {
+                // A slot still holding an older second starts over at one
+                updated = (current >> COUNT_BITS) == second ? std::min(current + 1, (second << COUNT_BITS) | COUNT_MASK) : (second << COUNT_BITS) | 1;
+            } while (!slot.compare_exchange_weak(current, updated, std::memory_order_relaxed));
+        }
+
+        void BackgroundMetrics::recordFailed(JobType type)
+        {
+            countersFor(type).failures.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void BackgroundMetrics::refreshQueueDepths(const IJobQueue &jobQueue)
+        {
+            for (const auto type : ALL_JOB_TYPES)
+            {
+                Counters &counters = countersFor(type);
+                counters.queueDepth.store(jobQueue.getPendingCount(type), std::memory_order_relaxed);
+                counters.failedJobs.store(jobQueue.getFailedCount(type), std::memory_order_relaxed);
+            }
+        }
+
+        double BackgroundMetrics::ratePerSecond(const Counters &counters, int64_t now, int64_t windowSeconds) const
+        {
+            uint64_t total = 0;
+            for (const auto &slot : counters.perSecond)
+            {
+                const uint64_t value = slot.load(std::memory_order_relaxed);
+                const auto second = static_cast<int64_t>(value >> COUNT_BITS);
+                if (second <= now && second > now - windowSeconds)
+                    total += value & COUNT_MASK;
+            }
+            // Right after startup, average over the time there has been rather than the whole window
+            const int64_t elapsed = std::clamp<int64_t>(now + 1, 1, windowSeconds);
+            return static_cast<double>(total) / static_cast<double>(elapsed);
+        }
+
+        BackgroundMetricsSnapshot BackgroundMetrics::snapshot(const BackgroundMetricsSnapshot *previous) const
+        {
+            BackgroundMetricsSnapshot result;
+            result.takenAt = std::chrono::steady_clock::now();
+            const int64_t now = secondsSinceStart();
+
+            for (const auto type : ALL_JOB_TYPES)
+            {
+                const Counters &counters = countersFor(type);
+                JobTypeMetrics metrics{type};
+                metrics.queueDepth = counters.queueDepth.load(std::memory_order_relaxed);
+                metrics.failedJobs = counters.failedJobs.load(std::memory_order_relaxed);
+                metrics.completed = counters.completed.load(std::memory_order_relaxed);
+                metrics.failures = counters.failures.load(std::memory_order_relaxed);
+                metrics.itemsPerSecond1m = ratePerSecond(counters, now, 60);
+                metrics.itemsPerSecond5m = ratePerSecond(counters, now, RATE_WINDOW_SECONDS);
+
+                // The five minute rate is steadier; fall back to the last minute while it has nothing yet
+                const double rate = metrics.itemsPerSecond5m > 0 ? metrics.itemsPerSecond5m : metrics.itemsPerSecond1m;
+                if (metrics.queueDepth > 0 && rate > 0)
+                {
+                    metrics.eta = std::chrono::seconds{static_cast<int64_t>(static_cast<double>(metrics.queueDepth) / rate)};
+                }
+                result.jobTypes.push_back(metrics);
+            }
+
+            for (const auto &load : theTaskExecutor.getWorkerLoads())
+            {
+                WorkerMetrics worker;
+                worker.pool = load.pool;
+                worker.index = load.index;
+                worker.busy = load.busy;
+                worker.busyTime = load.busyTime;
+
+                auto busySince = std::chrono::nanoseconds::zero();
+                double wallSeconds = toSeconds(result.takenAt - m_startTime);
+                if (previous)
+                {
+                    const auto it = std::find_if(previous->workers.begin(), previous->workers.end(),
+                                                 [&worker](const WorkerMetrics &before)
+                                                 {
+                                                     return before.pool == worker.pool && before.index == worker.index;
+                                                 });
+                    if (it != previous->workers.end())
+                    {
+                        busySince = it->busyTime;
+                        wallSeconds = toSeconds(result.takenAt - previous->takenAt);
+                    }
+                }
+                if (wallSeconds > 0)
+                {
+                    worker.utilization = std::clamp(toSeconds(worker.busyTime - busySince) / wallSeconds, 0.0, 1.0);
+                }
+                result.workers.push_back(worker);
+            }
+            return result;
+        }
+
+        std::string BackgroundMetrics::toJson(const BackgroundMetricsSnapshot &snapshot)
+        {
+            json jobs = json::object();
+            for (const auto &metrics : snapshot.jobTypes)
+            {
+                jobs[getJobTypeName(metrics.type)] = json{{"queue_depth", metrics.queueDepth},
+                                                          {"failed_jobs", metrics.failedJobs},
+                                                          {"completed", metrics.completed},
+                                                          {"failures", metrics.failures},
+                                                          {"items_per_sec_1m", metrics.itemsPerSecond1m},
+                                                          {"items_per_sec_5m", metrics.itemsPerSecond5m},
+                                                          {"eta_seconds", metrics.eta ? json(metrics.eta->count()) : json(nullptr)}};
+            }
+
+            json workers = json::array();
+            for (const auto &worker : snapshot.workers)
+            {
+                workers.push_back(json{{"pool", worker.pool},
+                                       {"index", worker.index},
+                                       {"busy", worker.busy},
+                                       {"utilization", worker.utilization},
+                                       {"busy_seconds", toSeconds(worker.busyTime)}});
+            }
+
+            const auto wallClock = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch());
+            return json{{"timestamp_ms", wallClock.count()}, {"jobs", jobs}, {"workers", workers}}.dump(2);
+        }
+
+    } // namespace database
+} // namespace jucyaudio
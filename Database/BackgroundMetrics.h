@@ -0,0 +1,90 @@
+#pragma once
+
+#include <Database/Includes/IJobQueue.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace jucyaudio
+{
+    namespace database
+    {
+        struct JobTypeMetrics
+        {
+            JobType type;
+            int64_t queueDepth{0};      ///< Jobs still to be done, as of the last refreshQueueDepths()
+            int64_t failedJobs{0};      ///< Jobs given up on, as of the last refreshQueueDepths()
+            int64_t completed{0};       ///< Jobs completed since startup
+            int64_t failures{0};        ///< Failed attempts since startup (including ones that will be retried)
+            double itemsPerSecond1m{0}; ///< Completion rate over the last minute
+            double itemsPerSecond5m{0}; ///< Completion rate over the last five minutes
+            std::optional<std::chrono::seconds> eta{}; ///< Time to drain the queue at the current rate, if there is one
+        };
+
+        struct WorkerMetrics
+        {
+            std::string pool;
+            size_t index{0};
+            bool busy{false};
+            double utilization{0}; ///< Share of wall time spent on jobs since the previous snapshot (or since startup)
+            std::chrono::nanoseconds busyTime{0};
+        };
+
+        struct BackgroundMetricsSnapshot
+        {
+            std::chrono::steady_clock::time_point takenAt;
+            std::vector<JobTypeMetrics> jobTypes;
+            std::vector<WorkerMetrics> workers;
+        };
+
+        /// @brief Live counters for the background job queue and the executor workers.
+        ///
+        /// Writers are the job queue and whoever refreshes the queue depths; the UI takes snapshots. Everything is
+        /// kept in atomics, so snapshot() never blocks on (or delays) a background thread.
+        class BackgroundMetrics final
+        {
+        public:
+            BackgroundMetrics();
+
+            void recordCompleted(JobType type);
+            void recordFailed(JobType type);
+
+            /// @brief Re-reads the queue depths from the database. Call from a background thread after the queue changed.
+            void refreshQueueDepths(const IJobQueue &jobQueue);
+
+            /// @brief Current metrics. Pass the previous snapshot to get worker utilization over the time since; without
+            /// it, utilization is averaged since startup.
+            BackgroundMetricsSnapshot snapshot(const BackgroundMetricsSnapshot *previous = nullptr) const;
+
+            /// @brief Serializes a snapshot for monitoring scripts.
+            static std::string toJson(const BackgroundMetricsSnapshot &snapshot);
+
+        private:
+            static constexpr size_t RATE_WINDOW_SECONDS = 5 * 60;
+
+            // Completions per second over the last RATE_WINDOW_SECONDS. Each slot packs the second it counts
+            // (upper 40 bits) and its count (lower 24 bits), so a slot is reused for a new second in one CAS.
+            struct Counters
+            {
+                std::atomic<int64_t> queueDepth{0};
+                std::atomic<int64_t> failedJobs{0};
+                std::atomic<int64_t> completed{0};
+                std::atomic<int64_t> failures{0};
+                std::array<std::atomic<uint64_t>, RATE_WINDOW_SECONDS> perSecond{};
+            };
+
+            Counters &countersFor(JobType type);
+            const Counters &countersFor(JobType type) const;
+            int64_t secondsSinceStart() const;
+            double ratePerSecond(const Counters &counters, int64_t now, int64_t windowSeconds) const;
+
+            const std::chrono::steady_clock::time_point m_startTime;
+            std::array<Counters, std::size(ALL_JOB_TYPES)> m_counters;
+        };
+
+        extern BackgroundMetrics theBackgroundMetrics;
+    } // namespace database
+} // namespace jucyaudio
@@ -1,12 +1,31 @@
 #include <Database/BackgroundService.h>
 #include <spdlog/spdlog.h> // Assuming spdlog is a core dependency
+#include <Utils/TaskExecutor.h>
+#include <algorithm>
 
 namespace jucyaudio
 {
     namespace database
     {
         BackgroundTaskService theBackgroundTaskService;
-        
+
+        namespace
+        {
+            // Budget sleeps are computed per slice of this much work
+            constexpr auto CPU_BUDGET_SLICE = std::chrono::milliseconds{20};
+
+            // How long pause() waits for a task to reach a checkpoint before giving up
+            constexpr auto PAUSE_TIMEOUT = std::chrono::seconds{2};
+
+            // A task that found nothing to do is retried after 1 s, then 2 s, 4 s, ... up to 5 minutes, unless a
+            // notify() makes it due earlier
+            constexpr auto MIN_IDLE_BACKOFF = std::chrono::seconds{1};
+            constexpr auto MAX_IDLE_BACKOFF = std::chrono::minutes{5};
+
+            // True on the executor worker while it runs a task's processWork()
+            thread_local bool t_inBackgroundTask = false;
+        } // namespace
+
         BackgroundTaskService::~BackgroundTaskService()
         {
             // Ensure stop() is called if the user forgets.
@@ -16,9 +35,9 @@ namespace jucyaudio
             }
 
             // Release our references to the tasks
-            const std::lock_guard<std::mutex> lock(m_tasksMutex);
-            for (auto *task : m_tasks)
-                task->release(REFCOUNT_DEBUG_ARGS);
+            const std::lock_guard<std::mutex> lock(m_conditionMutex);
+            for (const auto &scheduled : m_tasks)
+                scheduled.task->release(REFCOUNT_DEBUG_ARGS);
             m_tasks.clear();
         }
 
@@ -32,8 +51,11 @@ namespace jucyaudio
 
         void BackgroundTaskService::stop()
         {
-            m_shouldExit = true;
-            notify(); // Wake up the thread so it can see the exit flag
+            {
+                const std::lock_guard<std::mutex> lock(m_conditionMutex);
+                m_shouldExit = true;
+            }
+            m_condition.notify_all(); // Wake up the thread so it can see the exit flag, also from a checkpoint
             if (m_thread.joinable())
             {
                 m_thread.join();
@@ -44,82 +66,213 @@ namespace jucyaudio
         {
             if (task)
             {
-                const std::lock_guard<std::mutex> lock(m_tasksMutex);
-                task->retain(REFCOUNT_DEBUG_ARGS);
-                m_tasks.push_back(task);
+                {
+                    const std::lock_guard<std::mutex> lock(m_conditionMutex);
+                    task->retain(REFCOUNT_DEBUG_ARGS);
+                    m_tasks.push_back({task, Clock::now(), Clock::duration::zero()});
+                }
                 notify(); // Wake up to check the new task
             }
         }
 
         void BackgroundTaskService::notify()
         {
-            m_condition.notify_one();
+            {
+                const std::lock_guard<std::mutex> lock(m_conditionMutex);
+                m_wakeRequested = true;
+            }
+            m_condition.notify_all();
         }
 
         void BackgroundTaskService::pause()
         {
+            std::unique_lock<std::mutex> lock(m_conditionMutex);
             m_isPaused = true;
-            for(int i = 0; i < 10 && m_isProcessing; ++i)
+            m_condition.notify_all(); // cut a budget sleep short
+
+            if (t_inBackgroundTask)
+                return; // a task pausing the service parks at its next checkpoint
+
+            if (!m_parkedCondition.wait_for(lock, PAUSE_TIMEOUT,
+                                            [this]
+                                            {
+                                                return !m_isProcessing || m_isParked || !m_thread.joinable();
+                                            }))
             {
-                std::this_thread::sleep_for(std::chrono::milliseconds(100)); // Wait for current task to finish
+                spdlog::warn("BackgroundTaskService: task did not reach a checkpoint within {} ms",
+                             std::chrono::duration_cast<std::chrono::milliseconds>(PAUSE_TIMEOUT).count());
             }
         }
 
         void BackgroundTaskService::resume()
         {
-            m_isPaused = false;
-            notify();
+            {
+                const std::lock_guard<std::mutex> lock(m_conditionMutex);
+                m_isPaused = false;
+            }
+            m_condition.notify_all();
         }
 
-        void BackgroundTaskService::run()
+        void BackgroundTaskService::setCpuBudget(int percent)
         {
-            while (!m_shouldExit)
-            {
-                std::this_thread::sleep_for(std::chrono::milliseconds(500)); // Simulate work
-                
-                // --- Wait for work or notification ---
-                {
-                    std::unique_lock<std::mutex> lock(m_conditionMutex);
-                    // The condition variable waits until notify() is called OR the timeout elapses.
-                    // We add a predicate to handle spurious wakeups.
-                    m_condition.wait_for(lock, std::chrono::seconds(5),
-                                         [this]
-                                         {
-                                             // Wake up if we are exiting or have been notified.
-                                             return m_shouldExit.load() || !m_tasks.empty();
-                                         });
-                }
+            m_cpuBudgetPercent = std::clamp(percent, 1, 100);
+            spdlog::info("BackgroundTaskService: CPU budget set to {}%", m_cpuBudgetPercent.load());
+        }
+
+        bool BackgroundTaskService::checkpoint()
+        {
+            std::unique_lock<std::mutex> lock(m_conditionMutex);
 
-                if (m_shouldExit)
-                    break;
+            const auto busy = std::chrono::steady_clock::now() - m_sliceStart;
+            const int budget = m_cpuBudgetPercent;
+            if (busy >= CPU_BUDGET_SLICE && budget < 100)
+            {
+                const auto rest = busy * (100 - budget) / budget;
+                m_condition.wait_for(lock, rest,
+                                     [this]
+                                     {
+                                         return m_shouldExit.load() || m_isPaused.load();
+                                     });
+                m_sliceStart = std::chrono::steady_clock::now();
+            }
+            if (m_isPaused && !m_shouldExit)
+            {
+                park(lock);
+            }
+            return !m_shouldExit;
+        }
 
-                // If paused, just loop back and wait again.
-                if (m_isPaused)
-                    continue;
+        // Blocks the worker in the middle of a task until resume() or stop(). The task's own stack holds its progress,
+        // so it carries on from the same block afterwards.
+        void BackgroundTaskService::park(std::unique_lock<std::mutex> &lock)
+        {
+            m_isParked = true;
+            m_parkedCondition.notify_all();
+            m_condition.wait(lock,
+                             [this]
+                             {
+                                 return m_shouldExit.load() || !m_isPaused.load();
+                             });
+            m_isParked = false;
+            m_sliceStart = std::chrono::steady_clock::now();
+        }
 
-                // --- Round-robin through all registered tasks ---
-                m_isProcessing = true;
-                std::vector<IBackgroundTask *> tasksCopy;
+        BackgroundTaskService::ScheduledTask *BackgroundTaskService::nextDueTask(Clock::time_point now, std::optional<Clock::time_point> &nextWake)
+        {
+            ScheduledTask *due = nullptr;
+            nextWake.reset();
+            for (auto &scheduled : m_tasks)
+            {
+                if (scheduled.nextRun <= now)
                 {
-                    const std::lock_guard<std::mutex> lock(m_tasksMutex);
-                    tasksCopy = m_tasks;
+                    // Oldest due time first, so tasks that keep reporting more work take turns
+                    if (!due || scheduled.nextRun < due->nextRun)
+                        due = &scheduled;
                 }
-                for (auto *task : tasksCopy)
+                else if (!nextWake || scheduled.nextRun < *nextWake)
                 {
-                    if (m_shouldExit || m_isPaused)
-                        break;
+                    nextWake = scheduled.nextRun;
+                }
+            }
+            return due;
+        }
 
-                    try
-                    {
-                        task->processWork();
-                        std::this_thread::sleep_for(std::chrono::milliseconds(500)); // Simulate work
-                    }
-                    catch (const std::exception &e)
+        void BackgroundTaskService::reschedule(IBackgroundTask *task, const BackgroundTaskStatus &status)
+        {
+            const auto it = std::find_if(m_tasks.begin(), m_tasks.end(),
+                                         [task](const ScheduledTask &scheduled)
+                                         {
+                                             return scheduled.task == task;
+                                         });
+            if (it == m_tasks.end())
+                return;
+
+            const auto now = Clock::now();
+            if (status.hasMoreWork)
+            {
+                it->backoff = Clock::duration::zero();
+                it->nextRun = now;
+            }
+            else if (status.nextWakeTime.has_value())
+            {
+                it->nextRun = *status.nextWakeTime;
+            }
+            else
+            {
+                it->backoff = std::clamp<Clock::duration>(it->backoff * 2, MIN_IDLE_BACKOFF, MAX_IDLE_BACKOFF);
+                it->nextRun = now + it->backoff;
+            }
+        }
+
+        // Blocks until a task is due, notify() is called or the service stops; there are no periodic wakeups beyond the
+        // due times the tasks asked for.
+        void BackgroundTaskService::run()
+        {
+            while (true)
+            {
+                IBackgroundTask *task = nullptr;
+                {
+                    std::unique_lock<std::mutex> lock(m_conditionMutex);
+                    while (!m_shouldExit)
                     {
-                        spdlog::error("Task '{}' threw an exception: {}", task->m_taskName, e.what());
+                        if (m_wakeRequested)
+                        {
+                            m_wakeRequested = false;
+                            for (auto &scheduled : m_tasks)
+                            {
+                                scheduled.nextRun = std::min(scheduled.nextRun, Clock::now());
+                                scheduled.backoff = Clock::duration::zero();
+                            }
+                        }
+
+                        std::optional<Clock::time_point> nextWake;
+                        if (!m_isPaused)
+                        {
+                            if (auto *scheduled = nextDueTask(Clock::now(), nextWake))
+                            {
+                                task = scheduled->task;
+                                break;
+                            }
+                        }
+
+                        if (m_isPaused || !nextWake)
+                            m_condition.wait(lock);
+                        else
+                            m_condition.wait_until(lock, *nextWake);
                     }
+                    if (m_shouldExit)
+                        break;
+
+                    m_isProcessing = true;
+                    m_sliceStart = Clock::now();
+                }
+
+                // The work itself runs on the executor's idle-priority background worker, so it shares the machine with
+                // scans and exports instead of adding a thread of its own. This thread only schedules.
+                BackgroundTaskStatus status;
+                theTaskExecutor
+                    .submit(TaskLane::Cpu, TaskPriority::Background,
+                            [task, &status]()
+                            {
+                                t_inBackgroundTask = true;
+                                try
+                                {
+                                    status = task->processWork();
+                                }
+                                catch (const std::exception &e)
+                                {
+                                    spdlog::error("Task '{}' threw an exception: {}", task->m_taskName, e.what());
+                                }
+                                t_inBackgroundTask = false;
+                            })
+                    .wait();
+
+                {
+                    const std::lock_guard<std::mutex> lock(m_conditionMutex);
+                    reschedule(task, status);
+                    m_isProcessing = false;
                 }
-                m_isProcessing = true;
+                m_parkedCondition.notify_all();
             }
             spdlog::info("BackgroundTaskService thread finished.");
         }
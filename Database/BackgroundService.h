@@ -2,8 +2,10 @@
 
 #include <Database/Includes/IBackgroundTask.h>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
+#include <optional>
 #include <thread>
 #include <vector>
 
@@ -26,28 +28,57 @@ namespace jucyaudio
 
             void registerTask(IBackgroundTask *task); // Task is retained
 
-            // Wakes up the thread if it's sleeping.
+            // Tells the scheduler new work may exist: every task becomes due again and its backoff is reset.
             void notify();
 
-            // Pauses execution AFTER the current task is finished.
+            // Pauses execution. Returns once the running task has finished or parked at its next checkpoint(),
+            // which with well-behaved tasks is within a few tens of milliseconds.
             void pause();
-            // Resumes execution.
+            // Resumes execution; a parked task continues exactly where it stopped.
             void resume();
 
+            // Share of one core that tasks may use, 1-100. Enforced in checkpoint() by sleeping after each slice of
+            // work, so busy / (busy + sleep) stays at the budget.
+            void setCpuBudget(int percent);
+
+            // Cooperative preemption point for long-running work. Tasks call this between blocks from inside
+            // processWork(). It throttles to the CPU budget and blocks for as long as the service is paused.
+            // Returns false if the service is shutting down; the task should then abandon its work.
+            bool checkpoint();
+
         private:
+            using Clock = std::chrono::steady_clock;
+
+            struct ScheduledTask
+            {
+                IBackgroundTask *task;
+                Clock::time_point nextRun;
+                Clock::duration backoff; // zero until the task reports it found nothing
+            };
+
             // The main thread loop function.
             void run();
+            void park(std::unique_lock<std::mutex> &lock);
+
+            // Earliest-due task that is ready now, or nullptr; `nextWake` receives the earliest future due time, if any.
+            // Called with m_conditionMutex held.
+            ScheduledTask *nextDueTask(Clock::time_point now, std::optional<Clock::time_point> &nextWake);
+            void reschedule(IBackgroundTask *task, const BackgroundTaskStatus &status);
 
             std::thread m_thread;
             std::atomic<bool> m_shouldExit{false};
 
-            std::vector<IBackgroundTask *> m_tasks;
-            std::mutex m_tasksMutex; // Replaces juce::CriticalSection
-
             std::condition_variable m_condition; // Replaces juce::WaitableEvent
-            std::mutex m_conditionMutex;
+            std::mutex m_conditionMutex;         // guards m_tasks, the flags below and the wait
+            std::vector<ScheduledTask> m_tasks;
+            bool m_wakeRequested{false};
             std::atomic<bool> m_isPaused{false};
             std::atomic<bool> m_isProcessing{false};
+            std::atomic<bool> m_isParked{false};
+            std::condition_variable m_parkedCondition; // signalled when the worker parks or finishes a round
+
+            std::atomic<int> m_cpuBudgetPercent{100};
+            std::chrono::steady_clock::time_point m_sliceStart; // worker thread only
         };
 
         extern BackgroundTaskService theBackgroundTaskService;
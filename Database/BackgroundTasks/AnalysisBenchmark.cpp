@@ -0,0 +1,421 @@
+#include <Database/BackgroundTasks/AnalysisBenchmark.h>
+#include <Database/BackgroundTasks/AudioAnalyzer.h>
+#include <Utils/AssortedUtils.h>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <numbers>
+#include <optional>
+#include <random>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#else
+#include <unistd.h>
+#endif
+
+using json = nlohmann::json;
+
+namespace jucyaudio
+{
+    namespace database
+    {
+        namespace background_tasks
+        {
+            namespace
+            {
+                constexpr double BENCHMARK_SAMPLE_RATE = 44100.0;
+                constexpr int BENCHMARK_CHANNELS = 2;
+                constexpr const char *BASELINE_FILENAME = "analysis_benchmark_baseline.json";
+                constexpr const char *LATEST_FILENAME = "analysis_benchmark_latest.json";
+
+                // Regression thresholds relative to the baseline
+                constexpr double MAX_REALTIME_FACTOR_DROP = 0.10; // 10% slower
+                constexpr double MAX_BPM_ERROR_INCREASE = 0.5;    // BPM
+                constexpr double MAX_SECTION_ERROR_INCREASE = 1.0; // seconds
+                constexpr double MAX_MEMORY_INCREASE = 0.25;       // 25% more...
+                constexpr double MIN_MEMORY_INCREASE_MB = 16.0;    // ...and at least this much, so allocator noise is no regression
+
+                struct BenchmarkCase
+                {
+                    std::string name;
+                    double durationSeconds;
+                    std::function<double(double)> tempoAt; // ground-truth BPM at a given time
+                    std::optional<double> introEnd;        // ground-truth intro end (seconds), if the signal has one
+                    std::optional<double> outroStart;      // ground-truth outro start (seconds), if the signal has one
+                };
+
+                std::vector<BenchmarkCase> createBenchmarkCases()
+                {
+                    const auto constant = [](double bpm)
+                    {
+                        return [bpm](double)
+                        {
+                            return bpm;
+                        };
+                    };
+                    return {
+                        {"click_90", 60.0, constant(90.0), std::nullopt, std::nullopt},
+                        {"click_120", 60.0, constant(120.0), std::nullopt, std::nullopt},
+                        {"click_128", 60.0, constant(128.0), std::nullopt, std::nullopt},
+                        {"click_174", 60.0, constant(174.0), std::nullopt, std::nullopt},
+                        {"ramp_120_to_130", 90.0,
+                         [](double t)
+                         {
+                             return 120.0 + 10.0 * t / 90.0;
+                         },
+                         std::nullopt, std::nullopt},
+                        {"intro_outro_124", 120.0, constant(124.0), 16.0, 100.0},
+                    };
+                }
+
+                // Quiet sections are 30 dB down from the body of the track
+                double sectionGain(const BenchmarkCase &benchmarkCase, double t)
+                {
+                    const bool inIntro = benchmarkCase.introEnd.has_value() && t < *benchmarkCase.introEnd;
+                    const bool inOutro = benchmarkCase.outroStart.has_value() && t >= *benchmarkCase.outroStart;
+                    return (inIntro || inOutro) ? 0.0316 : 1.0;
+                }
+
+                // Click track with a kick on every beat, a short bright click on top and a sustained pad underneath so
+                // the energy-based section detection sees a continuous signal, plus a fixed-seed noise floor.
+                juce::AudioBuffer<float> synthesize(const BenchmarkCase &benchmarkCase)
+                {
+                    const int numSamples = static_cast<int>(benchmarkCase.durationSeconds * BENCHMARK_SAMPLE_RATE);
+                    juce::AudioBuffer<float> buffer{BENCHMARK_CHANNELS, numSamples};
+                    buffer.clear();
+                    float *left = buffer.getWritePointer(0);
+
+                    std::mt19937 random{0x6a756379};
+                    std::uniform_real_distribution<float> noise{-0.001f, 0.001f};
+                    for (int i = 0; i < numSamples; ++i)
+                    {
+                        const double t = i / BENCHMARK_SAMPLE_RATE;
+                        const double pad = 0.1 * std::sin(2.0 * std::numbers::pi * 110.0 * t);
+                        left[i] = static_cast<float>(pad * sectionGain(benchmarkCase, t)) + noise(random);
+                    }
+
+                    const int clickLength = static_cast<int>(0.08 * BENCHMARK_SAMPLE_RATE);
+                    for (double beat = 0.0; beat < benchmarkCase.durationSeconds; beat += 60.0 / benchmarkCase.tempoAt(beat))
+                    {
+                        const int start = static_cast<int>(beat * BENCHMARK_SAMPLE_RATE);
+                        const double gain = sectionGain(benchmarkCase, beat);
+                        for (int j = 0; j < clickLength && start + j < numSamples; ++j)
+                        {
+                            const double t = j / BENCHMARK_SAMPLE_RATE;
+                            const double kick = 0.7 * std::sin(2.0 * std::numbers::pi * 60.0 * t) * std::exp(-t * 40.0);
+                            const double click = 0.3 * std::sin(2.0 * std::numbers::pi * 2000.0 * t) * std::exp(-t * 300.0);
+                            left[start + j] += static_cast<float>((kick + click) * gain);
+                        }
+                    }
+                    buffer.copyFrom(1, 0, buffer, 0, 0, numSamples);
+                    return buffer;
+                }
+
+                // Current resident set of the process. Sampled before and during the analysis of a case, so the
+                // difference is what the analysis itself holds, not the library, the column index or the UI.
+                double residentMegabytes()
+                {
+#if defined(_WIN32)
+                    PROCESS_MEMORY_COUNTERS counters{};
+                    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+                        return counters.WorkingSetSize / (1024.0 * 1024.0);
+                    return 0.0;
+#elif defined(__APPLE__)
+                    mach_task_basic_info info{};
+                    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+                    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS)
+                        return 0.0;
+                    return info.resident_size / (1024.0 * 1024.0);
+#else
+                    // Second field of statm: resident pages
+                    std::ifstream statm{"/proc/self/statm"};
+                    long totalPages = 0;
+                    long residentPages = 0;
+                    if (!(statm >> totalPages >> residentPages))
+                        return 0.0;
+                    return residentPages * static_cast<double>(sysconf(_SC_PAGESIZE)) / (1024.0 * 1024.0);
+#endif
+                }
+
+                json timingsToJson(const AnalysisStageTimings &timings)
+                {
+                    return json{{"beat_tracking_ms", timings.beatTrackingMs}, {"tempo_map_ms", timings.tempoMapMs},
+                                {"energy_frames_ms", timings.energyFramesMs}, {"intro_outro_ms", timings.introOutroMs},
+                                {"loudness_ms", timings.loudnessMs}};
+                }
+
+                // An expected section that was not detected counts as an error of its full distance from the track edge
+                std::optional<double> sectionError(std::optional<double> expected, bool detected, double detectedValue, double missedError)
+                {
+                    if (!expected.has_value())
+                        return std::nullopt;
+                    return detected ? std::abs(detectedValue - *expected) : missedError;
+                }
+
+                // Returns std::nullopt if the user cancelled in the middle of the case
+                std::optional<json> runCase(const BenchmarkCase &benchmarkCase, AnalysisStageTimings &totalTimings, double &totalAnalysisMs,
+                                            std::atomic<bool> &shouldCancel)
+                {
+                    const auto buffer = synthesize(benchmarkCase);
+
+                    // The analyzer's own memory: the most resident at any checkpoint over what was resident before it
+                    // started. The input buffer is already allocated, so it does not count.
+                    const double memoryBefore = residentMegabytes();
+                    double memoryPeak = memoryBefore;
+                    AnalysisStageTimings timings;
+                    const auto start = std::chrono::steady_clock::now();
+                    const auto analyzed = analyzeAudioBuffer(buffer, BENCHMARK_SAMPLE_RATE, &timings,
+                                                             [&shouldCancel, &memoryPeak]()
+                                                             {
+                                                                 memoryPeak = std::max(memoryPeak, residentMegabytes());
+                                                                 return !shouldCancel;
+                                                             });
+                    if (!analyzed)
+                        return std::nullopt;
+                    const auto &metadata = *analyzed;
+                    const double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                    memoryPeak = std::max(memoryPeak, residentMegabytes());
+
+                    totalAnalysisMs += elapsedMs;
+                    totalTimings.beatTrackingMs += timings.beatTrackingMs;
+                    totalTimings.tempoMapMs += timings.tempoMapMs;
+                    totalTimings.energyFramesMs += timings.energyFramesMs;
+                    totalTimings.introOutroMs += timings.introOutroMs;
+                    totalTimings.loudnessMs += timings.loudnessMs;
+
+                    // Summary BPM against the tempo at the middle of the track
+                    const double expectedBpm = benchmarkCase.tempoAt(benchmarkCase.durationSeconds / 2.0);
+                    const double bpmError = std::abs(metadata.bpm - expectedBpm);
+
+                    // Tempo map against ground truth at each segment's midpoint, weighted by segment length
+                    double mapError = expectedBpm;
+                    double weightSum = 0.0;
+                    double weightedError = 0.0;
+                    for (const auto &segment : metadata.tempoMap)
+                    {
+                        const double startSeconds = segment.start.count() / 1000.0;
+                        const double endSeconds = segment.end.count() / 1000.0;
+                        const double weight = endSeconds - startSeconds;
+                        weightedError += weight * std::abs(segment.bpm - benchmarkCase.tempoAt((startSeconds + endSeconds) / 2.0));
+                        weightSum += weight;
+                    }
+                    if (weightSum > 0.0)
+                        mapError = weightedError / weightSum;
+
+                    json result{{"name", benchmarkCase.name},
+                                {"duration_s", benchmarkCase.durationSeconds},
+                                {"analysis_ms", elapsedMs},
+                                {"realtime_factor", benchmarkCase.durationSeconds * 1000.0 / std::max(elapsedMs, 0.001)},
+                                {"stages", timingsToJson(timings)},
+                                {"expected_bpm", expectedBpm},
+                                {"detected_bpm", metadata.bpm},
+                                {"bpm_error", bpmError},
+                                {"tempo_segments", metadata.tempoMap.size()},
+                                {"tempo_map_error", mapError},
+                                {"analysis_memory_mb", std::max(0.0, memoryPeak - memoryBefore)}};
+
+                    const auto introError = sectionError(benchmarkCase.introEnd, metadata.hasIntro, metadata.introEnd,
+                                                         benchmarkCase.introEnd.value_or(0.0));
+                    const auto outroError = sectionError(benchmarkCase.outroStart, metadata.hasOutro, metadata.outroStart,
+                                                         benchmarkCase.durationSeconds - benchmarkCase.outroStart.value_or(0.0));
+                    result["intro_error_s"] = introError.has_value() ? json(*introError) : json(nullptr);
+                    result["outro_error_s"] = outroError.has_value() ? json(*outroError) : json(nullptr);
+                    // Sections reported on signals that have none are false positives
+                    result["false_intro"] = !benchmarkCase.introEnd.has_value() && metadata.hasIntro;
+                    result["false_outro"] = !benchmarkCase.outroStart.has_value() && metadata.hasOutro;
+                    return result;
+                }
+
+                json summarize(const json &cases, const AnalysisStageTimings &totalTimings, double totalAnalysisMs)
+                {
+                    double totalAudioSeconds = 0.0;
+                    double bpmErrorSum = 0.0;
+                    double mapErrorSum = 0.0;
+                    double sectionErrorSum = 0.0;
+                    int sectionCount = 0;
+                    int falseSections = 0;
+                    double analysisMemory = 0.0;
+                    for (const auto &result : cases)
+                    {
+                        analysisMemory = std::max(analysisMemory, result["analysis_memory_mb"].get<double>());
+                        totalAudioSeconds += result["duration_s"].get<double>();
+                        bpmErrorSum += result["bpm_error"].get<double>();
+                        mapErrorSum += result["tempo_map_error"].get<double>();
+                        for (const char *key : {"intro_error_s", "outro_error_s"})
+                        {
+                            if (!result[key].is_null())
+                            {
+                                sectionErrorSum += result[key].get<double>();
+                                ++sectionCount;
+                            }
+                        }
+                        falseSections += (result["false_intro"].get<bool>() ? 1 : 0) + (result["false_outro"].get<bool>() ? 1 : 0);
+                    }
+                    const double caseCount = std::max<size_t>(1, cases.size());
+                    return json{{"total_audio_s", totalAudioSeconds},
+                                {"total_analysis_ms", totalAnalysisMs},
+                                {"realtime_factor", totalAudioSeconds * 1000.0 / std::max(totalAnalysisMs, 0.001)},
+                                {"stages", timingsToJson(totalTimings)},
+                                {"analysis_memory_mb", analysisMemory},
+                                {"mean_bpm_error", bpmErrorSum / caseCount},
+                                {"mean_tempo_map_error", mapErrorSum / caseCount},
+                                {"mean_section_error_s", sectionCount ? sectionErrorSum / sectionCount : 0.0},
+                                {"false_sections", falseSections}};
+                }
+
+                std::vector<std::string> findRegressions(const json &baseline, const json &current)
+                {
+                    std::vector<std::string> regressions;
+                    const auto isNumber = [](const json &j, const char *key)
+                    {
+                        return j.contains(key) && j[key].is_number();
+                    };
+                    const auto value = [&isNumber](const json &j, const char *key)
+                    {
+                        return isNumber(j, key) ? j[key].get<double>() : 0.0;
+                    };
+                    // Keys an older or hand-edited baseline does not have are not compared
+                    const auto check = [&](const char *key, const char *what, const std::function<bool(double, double)> &regressed)
+                    {
+                        if (!isNumber(baseline, key) || !isNumber(current, key))
+                            return;
+                        const double before = value(baseline, key);
+                        const double after = value(current, key);
+                        if (regressed(before, after))
+                        {
+                            regressions.push_back(std::format("{}: {:.3f} -> {:.3f} ({})", key, before, after, what));
+                        }
+                    };
+
+                    check("realtime_factor", "slower",
+                          [](double before, double after)
+                          {
+                              return after < before * (1.0 - MAX_REALTIME_FACTOR_DROP);
+                          });
+                    for (const char *key : {"mean_bpm_error", "mean_tempo_map_error"})
+                    {
+                        check(key, "less accurate",
+                              [](double before, double after)
+                              {
+                                  return after > before + MAX_BPM_ERROR_INCREASE;
+                              });
+                    }
+                    check("mean_section_error_s", "less accurate",
+                          [](double before, double after)
+                          {
+                              return after > before + MAX_SECTION_ERROR_INCREASE;
+                          });
+                    check("analysis_memory_mb", "more memory",
+                          [](double before, double after)
+                          {
+                              return after > std::max(before * (1.0 + MAX_MEMORY_INCREASE), before + MIN_MEMORY_INCREASE_MB);
+                          });
+                    if (isNumber(baseline, "false_sections") && value(current, "false_sections") > value(baseline, "false_sections"))
+                    {
+                        regressions.push_back(std::format("false_sections: {} -> {}", static_cast<int>(value(baseline, "false_sections")),
+                                                          static_cast<int>(value(current, "false_sections"))));
+                    }
+                    return regressions;
+                }
+
+                bool writeJson(const std::filesystem::path &path, const json &document)
+                {
+                    std::ofstream out{path};
+                    if (!out)
+                    {
+                        spdlog::error("Analysis benchmark: cannot write {}", pathToString(path));
+                        return false;
+                    }
+                    out << document.dump(2);
+                    return static_cast<bool>(out);
+                }
+            } // namespace
+
+            AnalysisBenchmark::AnalysisBenchmark(std::filesystem::path outputDirectory)
+                : ILongRunningTask{"Analysis Benchmark", true, TaskLane::Cpu},
+                  m_outputDirectory{std::move(outputDirectory)}
+            {
+            }
+
+            void AnalysisBenchmark::run(ProgressCallback progressCb, CompletionCallback completionCb, std::atomic<bool> &shouldCancel)
+            {
+                const auto benchmarkCases = createBenchmarkCases();
+                json cases = json::array();
+                AnalysisStageTimings totalTimings;
+                double totalAnalysisMs = 0.0;
+
+                for (size_t i = 0; i < benchmarkCases.size(); ++i)
+                {
+                    if (shouldCancel)
+                    {
+                        completionCb(false, "Analysis benchmark cancelled.");
+                        return;
+                    }
+                    progressCb(static_cast<int>(i * 100 / benchmarkCases.size()), "Analyzing " + benchmarkCases[i].name + "...");
+                    auto result = runCase(benchmarkCases[i], totalTimings, totalAnalysisMs, shouldCancel);
+                    if (!result)
+                    {
+                        completionCb(false, "Analysis benchmark cancelled.");
+                        return;
+                    }
+                    cases.push_back(std::move(*result));
+                    spdlog::info("Analysis benchmark: {}", cases.back().dump());
+                }
+
+                const json summary = summarize(cases, totalTimings, totalAnalysisMs);
+                const json document{{"version", 2}, {"timestamp", timestampToString(std::chrono::system_clock::now())}, {"summary", summary}, {"cases", cases}};
+
+                std::string message = std::format("Realtime factor {:.1f}x, mean BPM error {:.2f}, mean tempo map error {:.2f}, mean intro/outro error {:.2f}s, "
+                                                  "analysis memory {:.0f} MB.",
+                                                  summary["realtime_factor"].get<double>(), summary["mean_bpm_error"].get<double>(),
+                                                  summary["mean_tempo_map_error"].get<double>(), summary["mean_section_error_s"].get<double>(),
+                                                  summary["analysis_memory_mb"].get<double>());
+
+                const auto baselinePath = m_outputDirectory / BASELINE_FILENAME;
+                const auto latestPath = m_outputDirectory / LATEST_FILENAME;
+                if (!writeJson(latestPath, document))
+                {
+                    completionCb(false, "Cannot write benchmark results to " + pathToString(latestPath));
+                    return;
+                }
+
+                std::ifstream baselineFile{baselinePath};
+                if (!baselineFile)
+                {
+                    writeJson(baselinePath, document);
+                    completionCb(true, message + "\nRecorded as new baseline: " + pathToString(baselinePath));
+                    return;
+                }
+
+                const json baseline = json::parse(baselineFile, nullptr, false);
+                if (baseline.is_discarded() || !baseline.contains("summary"))
+                {
+                    completionCb(false, message + "\nBaseline is unreadable: " + pathToString(baselinePath));
+                    return;
+                }
+
+                const auto regressions = findRegressions(baseline["summary"], summary);
+                if (regressions.empty())
+                {
+                    completionCb(true, message + "\nNo regressions against " + pathToString(baselinePath));
+                    return;
+                }
+                for (const auto &regression : regressions)
+                {
+                    message += "\nREGRESSION " + regression;
+                }
+                completionCb(false, message);
+            }
+        } // namespace background_tasks
+    } // namespace database
+} // namespace jucyaudio
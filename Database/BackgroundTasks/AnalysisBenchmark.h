@@ -0,0 +1,33 @@
+#pragma once
+
+#include <Database/Includes/ILongRunningTask.h>
+#include <filesystem>
+
+namespace jucyaudio
+{
+    namespace database
+    {
+        namespace background_tasks
+        {
+            /// @brief Offline throughput and accuracy benchmark for the track analyzer.
+            ///
+            /// Synthesizes signals with known ground truth (click tracks at fixed tempos, a tempo ramp, quiet intros
+            /// and outros), runs them through analyzeAudioBuffer and reports realtime factor, per-stage time, the
+            /// memory the analysis itself takes, BPM / tempo-map error and intro/outro error.
+            ///
+            /// Results are written as JSON to the output directory. The first run becomes the baseline
+            /// (analysis_benchmark_baseline.json); later runs write analysis_benchmark_latest.json and report any
+            /// regressions against the baseline. Delete the baseline file to re-baseline.
+            class AnalysisBenchmark final : public ILongRunningTask
+            {
+            public:
+                explicit AnalysisBenchmark(std::filesystem::path outputDirectory);
+
+                void run(ProgressCallback progressCb, CompletionCallback completionCb, std::atomic<bool> &shouldCancel) override;
+
+            private:
+                const std::filesystem::path m_outputDirectory;
+            };
+        } // namespace background_tasks
+    } // namespace database
+} // namespace jucyaudio
@@ -0,0 +1,647 @@
+#include <Audio/LoudnessMeter.h>
+#include <Audio/SignalKernels.h>
+#include <Database/BackgroundTasks/AudioAnalyzer.h>
+#include <Utils/AssortedUtils.h>
+#include <Utils/UiUtils.h>
+#include <aubio/aubio.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <vector>
+
+namespace jucyaudio
+{
+    namespace database
+    {
+        namespace background_tasks
+        {
+            namespace
+            {
+                // Adds the wall-clock time of its scope to *target (if any)
+                class StageTimer final
+                {
+                public:
+                    explicit StageTimer(double *target)
+                        : m_target{target},
+                          m_start{std::chrono::steady_clock::now()}
+                    {
+                    }
+                    ~StageTimer()
+                    {
+                        if (m_target)
+                        {
+                            *m_target += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+                        }
+                    }
+
+                private:
+                    double *const m_target;
+                    const std::chrono::steady_clock::time_point m_start;
+                };
+
+                // Work between two checkpoints: ~1.5 s of audio, a few milliseconds of processing per block
+                constexpr int CHECKPOINT_BLOCK_SAMPLES = 65536;
+
+                bool keepGoing(const AnalysisCheckpoint &checkpoint)
+                {
+                    return !checkpoint || checkpoint();
+                }
+
+                // Offsets a set of planar channel pointers, for handing a slice of a buffer to block-based processors
+                std::vector<const float *> channelPointersAt(const juce::AudioBuffer<float> &buffer, int offset)
+                {
+                    std::vector<const float *> pointers(static_cast<size_t>(buffer.getNumChannels()));
+                    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+                    {
+                        pointers[ch] = buffer.getReadPointer(ch, offset);
+                    }
+                    return pointers;
+                }
+
+                class AudioAnalyzer
+                {
+                private:
+                    static constexpr int WINDOW_SIZE = 1024;
+                    static constexpr int HOP_SIZE = 512;
+                    static constexpr double MIN_INTRO_LENGTH = 8.0; // Minimum intro length in seconds
+                    static constexpr double MIN_OUTRO_LENGTH = 8.0; // Minimum outro length in seconds
+                    static constexpr double MIN_BPM = 60.0;
+                    static constexpr double MAX_BPM = 200.0;
+                    static constexpr double TEMPO_WINDOW_SECONDS = 8.0;   // resolution of the tempo map
+                    static constexpr size_t MIN_BEATS_PER_WINDOW = 4;     // fewer beats than this and the window has no tempo
+                    static constexpr double TEMPO_INLIER_TOLERANCE = 0.03; // beat intervals within 3% of the window median
+                    static constexpr double TEMPO_MERGE_TOLERANCE = 0.015; // neighbouring windows within 1.5% share a segment
+
+                    struct EnergyFrame
+                    {
+                        double timestamp;
+                        float energy;
+                        float spectralCentroid;
+                        float spectralRolloff;
+                    };
+
+                    static std::optional<std::vector<EnergyFrame>> calculateEnergyFrames(const juce::AudioBuffer<float> &buffer, double sampleRate,
+                                                                                         const AnalysisCheckpoint &checkpoint)
+                    {
+                        std::vector<EnergyFrame> frames;
+                        const int numSamples = buffer.getNumSamples();
+                        const int hopSize = static_cast<int>(sampleRate * 0.05); // 100ms frames at 50% hop
+                        const int frameSize = 2 * hopSize;
+
+                        // Frames are exactly two hops long, so each hop's sum of squares is computed once and shared by
+                        // the two frames that overlap it
+                        audio::SlidingRms slidingRms{hopSize, 2};
+                        for (int offset = 0; offset < numSamples; offset += CHECKPOINT_BLOCK_SAMPLES)
+                        {
+                            if (!keepGoing(checkpoint))
+                                return std::nullopt;
+                            slidingRms.process(channelPointersAt(buffer, offset).data(), buffer.getNumChannels(),
+                                               std::min(CHECKPOINT_BLOCK_SAMPLES, numSamples - offset));
+                        }
+                        const auto &frameRms = slidingRms.getWindowRms();
+
+                        for (size_t k = 0; k < frameRms.size(); ++k)
+                        {
+                            const int i = static_cast<int>(k) * hopSize;
+                            if (i >= numSamples - frameSize)
+                                break;
+                            if (k % 16 == 0 && !keepGoing(checkpoint))
+                                return std::nullopt;
+
+                            EnergyFrame frame;
+                            frame.timestamp = static_cast<double>(i) / sampleRate;
+                            frame.energy = frameRms[k];
+
+                            // Calculate spectral centroid (simplified)
+                            frame.spectralCentroid = calculateSpectralCentroid(buffer, i, frameSize);
+
+                            // Calculate spectral rolloff (simplified)
+                            frame.spectralRolloff = calculateSpectralRolloff(buffer, i, frameSize);
+
+                            frames.push_back(frame);
+                        }
+
+                        return frames;
+                    }
+
+                    static float calculateSpectralCentroid(const juce::AudioBuffer<float> &buffer, int startSample, int frameSize)
+                    {
+                        // Simplified spectral centroid calculation
+                        // In a real implementation, you'd use FFT here
+                        float weightedSum = 0.0f;
+                        float magnitudeSum = 0.0f;
+
+                        for (int i = 0; i < frameSize; ++i)
+                        {
+                            float sample = 0.0f;
+                            for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+                            {
+                                sample += std::abs(buffer.getReadPointer(ch)[startSample + i]);
+                            }
+                            sample /= buffer.getNumChannels();
+
+                            weightedSum += sample * i;
+                            magnitudeSum += sample;
+                        }
+
+                        return magnitudeSum > 0 ? weightedSum / magnitudeSum : 0.0f;
+                    }
+
+                    static float calculateSpectralRolloff(const juce::AudioBuffer<float> &buffer, int startSample, int frameSize)
+                    {
+                        // Simplified spectral rolloff calculation
+                        std::vector<float> magnitudes;
+                        for (int i = 0; i < frameSize; ++i)
+                        {
+                            float sample = 0.0f;
+                            for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+                            {
+                                sample += std::abs(buffer.getReadPointer(ch)[startSample + i]);
+                            }
+                            magnitudes.push_back(sample / buffer.getNumChannels());
+                        }
+
+                        float totalEnergy = std::accumulate(magnitudes.begin(), magnitudes.end(), 0.0f);
+                        float threshold = totalEnergy * 0.85f; // 85% of total energy
+
+                        float cumulativeEnergy = 0.0f;
+                        for (size_t i = 0; i < magnitudes.size(); ++i)
+                        {
+                            cumulativeEnergy += magnitudes[i];
+                            if (cumulativeEnergy >= threshold)
+                                return static_cast<float>(i) / frameSize;
+                        }
+
+                        return 1.0f;
+                    }
+
+                    struct BeatEstimate
+                    {
+                        double timestamp;
+                        float confidence;
+                    };
+
+                    // Fold a beat interval into the plausible BPM range so double/half-time detections land on one tempo
+                    static double foldBpm(double bpm)
+                    {
+                        while (bpm > 0.0 && bpm < MIN_BPM)
+                            bpm *= 2.0;
+                        while (bpm >= MAX_BPM)
+                            bpm /= 2.0;
+                        return bpm;
+                    }
+
+                    static std::optional<std::vector<BeatEstimate>> detectBeats(const juce::AudioBuffer<float> &buffer, double sampleRate,
+                                                                                const AnalysisCheckpoint &checkpoint)
+                    {
+                        // Convert to mono if needed
+                        juce::AudioBuffer<float> monoBuffer;
+                        if (buffer.getNumChannels() > 1)
+                        {
+                            monoBuffer.setSize(1, buffer.getNumSamples());
+                            monoBuffer.copyFrom(0, 0, buffer, 0, 0, buffer.getNumSamples());
+                            for (int ch = 1; ch < buffer.getNumChannels(); ++ch)
+                            {
+                                monoBuffer.addFrom(0, 0, buffer, ch, 0, buffer.getNumSamples());
+                            }
+                            monoBuffer.applyGain(1.0f / buffer.getNumChannels());
+                        }
+                        else
+                        {
+                            monoBuffer.makeCopyOf(buffer);
+                        }
+
+                        // Initialize Aubio tempo detection
+                        aubio_tempo_t *tempo = new_aubio_tempo("default", WINDOW_SIZE, HOP_SIZE, static_cast<uint_t>(sampleRate));
+                        fvec_t *input = new_fvec(HOP_SIZE);
+                        fvec_t *output = new_fvec(1);
+
+                        std::vector<BeatEstimate> beats;
+                        const float *audioData = monoBuffer.getReadPointer(0);
+
+                        // Process audio in chunks
+                        bool abandoned = false;
+                        for (int i = 0; i < monoBuffer.getNumSamples() - HOP_SIZE; i += HOP_SIZE)
+                        {
+                            if (i % CHECKPOINT_BLOCK_SAMPLES < HOP_SIZE && !keepGoing(checkpoint))
+                            {
+                                abandoned = true;
+                                break;
+                            }
+
+                            // Copy audio data to aubio vector
+                            for (int j = 0; j < HOP_SIZE; ++j)
+                            {
+                                input->data[j] = audioData[i + j];
+                            }
+
+                            // Process the chunk
+                            aubio_tempo_do(tempo, input, output);
+
+                            // Keep every beat position; the tempo map is derived from the intervals between them
+                            if (output->data[0] > 0)
+                            {
+                                beats.push_back({aubio_tempo_get_last_s(tempo), aubio_tempo_get_confidence(tempo)});
+                            }
+                        }
+
+                        // Cleanup
+                        del_fvec(input);
+                        del_fvec(output);
+                        del_aubio_tempo(tempo);
+                        if (abandoned)
+                            return std::nullopt;
+                        return beats;
+                    }
+
+                    // Estimate a tempo per fixed window from the beat intervals inside it, then merge neighbouring windows
+                    // whose tempo agrees into piecewise-constant segments. Windows without enough beats (breaks, silence)
+                    // are absorbed by the surrounding segments, so the map always covers the whole track.
+                    static std::vector<TempoSegment> buildTempoMap(const std::vector<BeatEstimate> &beats, double totalDuration)
+                    {
+                        struct Interval
+                        {
+                            double timestamp;
+                            double bpm;
+                            float confidence;
+                        };
+                        std::vector<Interval> intervals;
+                        for (size_t i = 1; i < beats.size(); ++i)
+                        {
+                            const double delta = beats[i].timestamp - beats[i - 1].timestamp;
+                            if (delta > 0.0)
+                            {
+                                intervals.push_back({beats[i].timestamp, foldBpm(60.0 / delta), beats[i].confidence});
+                            }
+                        }
+
+                        struct WindowTempo
+                        {
+                            double start;
+                            double bpm;
+                            double confidence;
+                        };
+                        std::vector<WindowTempo> windows;
+                        size_t next = 0;
+                        for (double windowStart = 0.0; windowStart < totalDuration; windowStart += TEMPO_WINDOW_SECONDS)
+                        {
+                            std::vector<double> bpms;
+                            double aubioConfidence = 0.0;
+                            while (next < intervals.size() && intervals[next].timestamp < windowStart + TEMPO_WINDOW_SECONDS)
+                            {
+                                bpms.push_back(intervals[next].bpm);
+                                aubioConfidence += intervals[next].confidence;
+                                ++next;
+                            }
+                            if (bpms.size() < MIN_BEATS_PER_WINDOW)
+                                continue;
+                            aubioConfidence /= bpms.size();
+
+                            std::vector<double> sorted{bpms};
+                            std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+                            const double median = sorted[sorted.size() / 2];
+
+                            double inlierSum = 0.0;
+                            size_t inliers = 0;
+                            for (const double bpm : bpms)
+                            {
+                                if (std::abs(bpm - median) <= median * TEMPO_INLIER_TOLERANCE)
+                                {
+                                    inlierSum += bpm;
+                                    ++inliers;
+                                }
+                            }
+                            const double inlierRatio = static_cast<double>(inliers) / bpms.size();
+                            const double confidence = 0.5 * inlierRatio + 0.5 * std::clamp(aubioConfidence, 0.0, 1.0);
+                            windows.push_back({windowStart, inlierSum / inliers, confidence});
+                        }
+
+                        std::vector<TempoSegment> segments;
+                        double segmentWeight = 0.0;
+                        double segmentBpm = 0.0;
+                        double segmentConfidence = 0.0;
+                        const auto toDuration = [](double seconds)
+                        {
+                            return Duration_t{static_cast<int64_t>(seconds * 1000.0)};
+                        };
+                        for (const auto &window : windows)
+                        {
+                            if (!segments.empty() && std::abs(window.bpm - segmentBpm) <= segmentBpm * TEMPO_MERGE_TOLERANCE)
+                            {
+                                segmentWeight += 1.0;
+                                segmentBpm += (window.bpm - segmentBpm) / segmentWeight;
+                                segmentConfidence += (window.confidence - segmentConfidence) / segmentWeight;
+                                segments.back().bpm = segmentBpm;
+                                segments.back().confidence = static_cast<float>(segmentConfidence);
+                                continue;
+                            }
+                            if (!segments.empty())
+                            {
+                                segments.back().end = toDuration(window.start);
+                            }
+                            segmentWeight = 1.0;
+                            segmentBpm = window.bpm;
+                            segmentConfidence = window.confidence;
+                            segments.push_back({toDuration(segments.empty() ? 0.0 : window.start), Duration_t{0}, segmentBpm,
+                                                static_cast<float>(segmentConfidence)});
+                        }
+                        if (!segments.empty())
+                        {
+                            segments.back().end = toDuration(totalDuration);
+                        }
+                        return segments;
+                    }
+
+                    // Summary tempo for the bpm column: median over the map, weighted by segment length and confidence
+                    static float summarizeTempoMap(const std::vector<TempoSegment> &segments)
+                    {
+                        if (segments.empty())
+                            return 0.0f;
+
+                        std::vector<std::pair<double, double>> weighted; // bpm, weight
+                        double totalWeight = 0.0;
+                        for (const auto &segment : segments)
+                        {
+                            const double weight = static_cast<double>((segment.end - segment.start).count()) * std::max(segment.confidence, 0.01f);
+                            weighted.emplace_back(segment.bpm, weight);
+                            totalWeight += weight;
+                        }
+                        std::sort(weighted.begin(), weighted.end());
+                        double cumulative = 0.0;
+                        for (const auto &[bpm, weight] : weighted)
+                        {
+                            cumulative += weight;
+                            if (cumulative >= totalWeight / 2.0)
+                                return static_cast<float>(bpm);
+                        }
+                        return static_cast<float>(weighted.back().first);
+                    }
+
+                    static std::pair<double, double> detectIntro(const std::vector<EnergyFrame> &frames, double totalDuration)
+                    {
+                        if (frames.empty() || totalDuration < MIN_INTRO_LENGTH)
+                            return {0.0, 0.0};
+
+                        // Simple approach: compare first 10% vs middle 10% of track
+                        size_t firstSectionEnd = frames.size() / 10;
+                        size_t middleStart = frames.size() * 4 / 10;
+                        size_t middleEnd = frames.size() * 5 / 10;
+
+                        // Average energy in first 10%
+                        float firstEnergy = 0.0f;
+                        for (size_t i = 0; i < firstSectionEnd; ++i)
+                        {
+                            firstEnergy += frames[i].energy;
+                        }
+                        firstEnergy /= firstSectionEnd;
+
+                        // Average energy in middle 10%
+                        float middleEnergy = 0.0f;
+                        for (size_t i = middleStart; i < middleEnd; ++i)
+                        {
+                            middleEnergy += frames[i].energy;
+                        }
+                        middleEnergy /= (middleEnd - middleStart);
+
+                        // If first section is significantly quieter than middle, it's an intro
+                        if (middleEnergy > firstEnergy * 1.5f) // Lowered from 2.0f to 1.5f
+                        {
+                            spdlog::info("Intro detected - Middle energy: {:.4f}, First energy: {:.4f}, Ratio: {:.2f}", middleEnergy, firstEnergy,
+                                         middleEnergy / firstEnergy);
+
+                            // Find where energy crosses the threshold
+                            float threshold = firstEnergy + (middleEnergy - firstEnergy) * 0.6f;
+
+                            for (size_t i = 0; i < frames.size() / 3; ++i) // Look in first third
+                            {
+                                if (frames[i].energy > threshold)
+                                {
+                                    double introEnd = frames[i].timestamp;
+                                    if (introEnd >= MIN_INTRO_LENGTH)
+                                    {
+                                        return {0.0, introEnd};
+                                    }
+                                    break;
+                                }
+                            }
+                        }
+                        else
+                        {
+                            spdlog::info("No intro - Middle energy: {:.4f}, First energy: {:.4f}, Ratio: {:.2f}", middleEnergy, firstEnergy,
+                                         middleEnergy / firstEnergy);
+                        }
+
+                        return {0.0, 0.0};
+                    }
+
+                    static std::pair<double, double> detectOutro(const std::vector<EnergyFrame> &frames, double totalDuration)
+                    {
+                        if (frames.empty() || totalDuration < MIN_OUTRO_LENGTH)
+                            return {0.0, 0.0};
+
+                        // More sophisticated approach: look for sustained decline in last 40%
+                        size_t analyzeFromIndex = frames.size() * 6 / 10; // Start from 60% into track
+                        size_t middleStart = frames.size() * 4 / 10;
+                        size_t middleEnd = frames.size() * 5 / 10;
+
+                        // Calculate middle energy (reference point)
+                        float middleEnergy = 0.0f;
+                        for (size_t i = middleStart; i < middleEnd; ++i)
+                        {
+                            middleEnergy += frames[i].energy;
+                        }
+                        middleEnergy /= (middleEnd - middleStart);
+
+                        // Look for a point where energy drops significantly and stays low
+                        for (size_t i = analyzeFromIndex; i < frames.size() - 10; ++i) // Leave some buffer at end
+                        {
+                            // Calculate average energy from this point to end
+                            float avgEnergyToEnd = 0.0f;
+                            for (size_t j = i; j < frames.size(); ++j)
+                            {
+                                avgEnergyToEnd += frames[j].energy;
+                            }
+                            avgEnergyToEnd /= (frames.size() - i);
+
+                            // Check if remaining portion is significantly quieter than middle
+                            float ratio = middleEnergy / avgEnergyToEnd;
+                            if (ratio >= 1.3f) // Lowered from 1.5f to 1.3f
+                            {
+                                double outroStart = frames[i].timestamp;
+                                double outroLength = totalDuration - outroStart;
+
+                                if (outroLength >= MIN_OUTRO_LENGTH)
+                                {
+                                    spdlog::info("Outro detected at {:.1f}s - Middle energy: {:.4f}, Remaining avg energy: {:.4f}, Ratio: {:.2f}", outroStart,
+                                                 middleEnergy, avgEnergyToEnd, ratio);
+                                    return {outroStart, totalDuration};
+                                }
+                            }
+                        }
+
+                        spdlog::info("No outro detected - Middle energy: {:.4f}", middleEnergy);
+                        return {0.0, 0.0};
+                    }
+
+                public:
+                    static std::optional<AudioMetadata> analyze(const juce::AudioBuffer<float> &buffer, double sampleRate, AnalysisStageTimings *timings,
+                                                                const AnalysisCheckpoint &checkpoint)
+                    {
+                        AudioMetadata metadata;
+
+                        if (buffer.getNumSamples() == 0)
+                            return metadata;
+
+                        double totalDuration = static_cast<double>(buffer.getNumSamples()) / sampleRate;
+
+                        // Detect tempo map; the single BPM value is a summary of it
+                        std::optional<std::vector<BeatEstimate>> beats;
+                        {
+                            StageTimer timer{timings ? &timings->beatTrackingMs : nullptr};
+                            beats = detectBeats(buffer, sampleRate, checkpoint);
+                        }
+                        if (!beats)
+                            return std::nullopt;
+                        {
+                            StageTimer timer{timings ? &timings->tempoMapMs : nullptr};
+                            metadata.tempoMap = buildTempoMap(*beats, totalDuration);
+                            metadata.bpm = summarizeTempoMap(metadata.tempoMap);
+                        }
+
+                        // Calculate energy frames for intro/outro detection
+                        std::optional<std::vector<EnergyFrame>> energyFrames;
+                        {
+                            StageTimer timer{timings ? &timings->energyFramesMs : nullptr};
+                            energyFrames = calculateEnergyFrames(buffer, sampleRate, checkpoint);
+                        }
+                        if (!energyFrames)
+                            return std::nullopt;
+
+                        {
+                            StageTimer timer{timings ? &timings->introOutroMs : nullptr};
+
+                            // Detect intro
+                            auto [introStart, introEnd] = detectIntro(*energyFrames, totalDuration);
+                            if (introEnd > introStart)
+                            {
+                                metadata.hasIntro = true;
+                                metadata.introStart = introStart;
+                                metadata.introEnd = introEnd;
+                            }
+
+                            // Detect outro
+                            auto [outroStart, outroEnd] = detectOutro(*energyFrames, totalDuration);
+                            if (outroEnd > outroStart)
+                            {
+                                metadata.hasOutro = true;
+                                metadata.outroStart = outroStart;
+                                metadata.outroEnd = outroEnd;
+                            }
+                        }
+
+                        // Loudness runs over the same decoded buffer, so normalization never needs a second decode
+                        {
+                            StageTimer timer{timings ? &timings->loudnessMs : nullptr};
+                            audio::LoudnessMeter loudnessMeter{sampleRate, buffer.getNumChannels()};
+                            for (int offset = 0; offset < buffer.getNumSamples(); offset += CHECKPOINT_BLOCK_SAMPLES)
+                            {
+                                if (!keepGoing(checkpoint))
+                                    return std::nullopt;
+                                loudnessMeter.process(channelPointersAt(buffer, offset).data(), buffer.getNumChannels(),
+                                                      std::min(CHECKPOINT_BLOCK_SAMPLES, buffer.getNumSamples() - offset));
+                            }
+                            const auto loudness = loudnessMeter.getResult();
+                            if (loudness.valid)
+                            {
+                                metadata.hasLoudness = true;
+                                metadata.integratedLoudness = loudness.integratedLufs;
+                                metadata.loudnessRange = loudness.loudnessRangeLu;
+                                metadata.truePeak = loudness.truePeakDbtp;
+                            }
+                        }
+
+                        return metadata;
+                    }
+                };
+
+            } // namespace
+
+            std::optional<AudioMetadata> analyzeAudioBuffer(const juce::AudioBuffer<float> &buffer, double sampleRate, AnalysisStageTimings *timings,
+                                                            const AnalysisCheckpoint &checkpoint)
+            {
+                return AudioAnalyzer::analyze(buffer, sampleRate, timings, checkpoint);
+            }
+
+            std::optional<AudioMetadata> analyzeAudioFile(const std::filesystem::path &filepath, AnalysisStageTimings *timings,
+                                                          const AnalysisCheckpoint &checkpoint, std::string *decodeError)
+            {
+                AudioMetadata metadata;
+                const auto undecodable = [&](const char *why)
+                {
+                    spdlog::error("{}: {}", why, pathToString(filepath));
+                    if (decodeError)
+                        *decodeError = why;
+                    return metadata;
+                };
+
+                // Initialize JUCE audio format manager
+                juce::AudioFormatManager formatManager;
+                formatManager.registerBasicFormats();
+
+                // Load the audio file
+                juce::File audioFile{ui::jucePathFromFs(filepath)};
+                if (!audioFile.existsAsFile())
+                {
+                    return undecodable("Audio file does not exist");
+                }
+
+                std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(audioFile));
+                if (!reader)
+                {
+                    return undecodable("Could not create audio format reader");
+                }
+
+                // Read the entire audio file into a buffer
+                const int numSamples = static_cast<int>(reader->lengthInSamples);
+                const int numChannels = static_cast<int>(reader->numChannels);
+                const double sampleRate = reader->sampleRate;
+                if (numSamples <= 0 || numChannels <= 0 || sampleRate <= 0.0)
+                {
+                    return undecodable("Audio file contains no audio");
+                }
+
+                juce::AudioBuffer<float> audioBuffer(numChannels, numSamples);
+                for (int offset = 0; offset < numSamples; offset += CHECKPOINT_BLOCK_SAMPLES)
+                {
+                    if (!keepGoing(checkpoint))
+                        return std::nullopt;
+                    StageTimer timer{timings ? &timings->decodeMs : nullptr};
+                    reader->read(&audioBuffer, offset, std::min(CHECKPOINT_BLOCK_SAMPLES, numSamples - offset), offset, true, true);
+                }
+
+                // Perform analysis
+                auto analyzed = AudioAnalyzer::analyze(audioBuffer, sampleRate, timings, checkpoint);
+                if (!analyzed)
+                    return std::nullopt;
+                metadata = std::move(*analyzed);
+
+                spdlog::info("Analysis complete for: {}", pathToString(filepath));
+                spdlog::info("BPM: {} ({} tempo segments)", metadata.bpm, metadata.tempoMap.size());
+                spdlog::info("Has Intro: {}", metadata.hasIntro);
+                spdlog::info("Has Outro: {}", metadata.hasOutro);
+                if (metadata.hasLoudness)
+                {
+                    spdlog::info("Loudness: {:.1f} LUFS, LRA {:.1f} LU, true peak {:.1f} dBTP", metadata.integratedLoudness, metadata.loudnessRange,
+                                 metadata.truePeak);
+                }
+
+                return metadata;
+            }
+        } // namespace background_tasks
+    } // namespace database
+} // namespace jucyaudio
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <Database/Includes/ITrackDatabase.h>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <string>
+#include <juce_audio_basics/juce_audio_basics.h>
+
+namespace jucyaudio
+{
+    namespace database
+    {
+        namespace background_tasks
+        {
+            /// @brief Wall-clock milliseconds spent in each analysis stage. Values are added to, so one instance can
+            /// accumulate over several runs. Only filled in when a pointer is passed (benchmarking).
+            struct AnalysisStageTimings
+            {
+                double decodeMs = 0.0;
+                double beatTrackingMs = 0.0;
+                double tempoMapMs = 0.0;
+                double energyFramesMs = 0.0;
+                double introOutroMs = 0.0;
+                double loudnessMs = 0.0;
+            };
+
+            /// @brief Called between blocks of work (every ~1.5 s of audio). It may block to pause or throttle the analysis,
+            /// which then continues from the same block; returning false abandons the analysis.
+            using AnalysisCheckpoint = std::function<bool()>;
+
+            /// @brief Runs the full analysis (tempo map, intro/outro, loudness) over an already-decoded buffer.
+            /// Returns std::nullopt if the checkpoint abandoned the analysis.
+            std::optional<AudioMetadata> analyzeAudioBuffer(const juce::AudioBuffer<float> &buffer, double sampleRate, AnalysisStageTimings *timings = nullptr,
+                                                            const AnalysisCheckpoint &checkpoint = {});
+
+            /// @brief Decodes the whole file and runs analyzeAudioBuffer over it.
+            /// A file that cannot be decoded comes back as empty metadata with decodeError (if given) set to why; a
+            /// decoded file without a detectable tempo comes back with bpm 0 and decodeError left empty.
+            std::optional<AudioMetadata> analyzeAudioFile(const std::filesystem::path &filepath, AnalysisStageTimings *timings = nullptr,
+                                                          const AnalysisCheckpoint &checkpoint = {}, std::string *decodeError = nullptr);
+
+        } // namespace background_tasks
+    } // namespace database
+} // namespace jucyaudio
@@ -7,6 +7,7 @@
 
 #include <Database/Includes/Constants.h>
 #include <Database/Includes/IBackgroundTask.h>
+#include <Database/Includes/IJobQueue.h>
 #include <Database/Includes/IRefCounted.h>
 
 namespace jucyaudio
@@ -25,15 +26,12 @@ namespace jucyaudio
 
             private:
                 /// @brief Process the work for the BPM analysis task.
-                void processWork() override;
+                BackgroundTaskStatus processWork() override;
 
-                std::optional<std::chrono::steady_clock::time_point> m_startTime;
-
-                /// @brief The file path to the audio file to analyze.
-                std::string audioFilePath;
+                /// @brief Analyzes the leased job's track and completes, fails or releases the job.
+                BackgroundTaskStatus processJob(const JobInfo &job);
 
-                /// @brief The BPM value found during the analysis.
-                std::optional<double> bpmValue;
+                std::optional<std::chrono::steady_clock::time_point> m_startTime;
             };
         } // namespace background_tasks
     } // namespace database
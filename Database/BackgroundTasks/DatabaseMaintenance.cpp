@@ -0,0 +1,71 @@
+#include <Database/BackgroundService.h>
+#include <Database/BackgroundTasks/DatabaseMaintenance.h>
+#include <Database/TrackLibrary.h>
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+namespace jucyaudio
+{
+    namespace database
+    {
+        namespace background_tasks
+        {
+            namespace
+            {
+                constexpr auto STARTUP_DELAY = std::chrono::seconds(30);
+                constexpr auto CHECK_INTERVAL = std::chrono::minutes(5);
+                constexpr auto STATISTICS_INTERVAL = std::chrono::hours(1);
+
+                // Free pages kept for the database to grow into; only what goes beyond is given back
+                constexpr int64_t FREE_PAGES_KEPT = 256;
+                // Pages given back per step: about a megabyte, a write of a few milliseconds
+                constexpr int64_t VACUUM_STEP_PAGES = 256;
+            } // namespace
+
+            BackgroundTaskStatus DatabaseMaintenance::processWork()
+            {
+                const auto now = std::chrono::steady_clock::now();
+                if (!m_startTime.has_value())
+                {
+                    m_startTime = now;
+                    m_nextStatisticsUpdate = now + STARTUP_DELAY;
+                }
+                if (now - *m_startTime < STARTUP_DELAY)
+                {
+                    return BackgroundTaskStatus::wakeAt(*m_startTime + STARTUP_DELAY);
+                }
+
+                ITrackDatabase *database = theTrackLibrary.getTrackDatabase();
+                if (!database)
+                {
+                    return BackgroundTaskStatus::wakeAt(now + CHECK_INTERVAL);
+                }
+
+                const auto report = database->getSpaceReport();
+                if (report.incrementalVacuum && report.freePages > FREE_PAGES_KEPT)
+                {
+                    const auto released = database->incrementalVacuum(std::min(VACUUM_STEP_PAGES, report.freePages - FREE_PAGES_KEPT));
+                    if (released < 0)
+                    {
+                        spdlog::warn("Database Maintenance Task: {}", database->getLastError());
+                    }
+                    else if (released > 0)
+                    {
+                        // The next step once the other tasks had their turn, or not at all when shutting down
+                        return theBackgroundTaskService.checkpoint() ? BackgroundTaskStatus::moreWork() : BackgroundTaskStatus::idle();
+                    }
+                }
+
+                if (now >= m_nextStatisticsUpdate)
+                {
+                    if (!database->optimizeStatistics())
+                    {
+                        spdlog::warn("Database Maintenance Task: {}", database->getLastError());
+                    }
+                    m_nextStatisticsUpdate = now + STATISTICS_INTERVAL;
+                }
+                return BackgroundTaskStatus::wakeAt(std::min(now + CHECK_INTERVAL, m_nextStatisticsUpdate));
+            }
+        } // namespace background_tasks
+    } // namespace database
+} // namespace jucyaudio
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <chrono>
+#include <optional>
+
+#include <Database/Includes/IBackgroundTask.h>
+
+namespace jucyaudio
+{
+    namespace database
+    {
+        namespace background_tasks
+        {
+            /// @brief Keeps the database file compact and its statistics fresh while the app runs.
+            ///
+            /// Gives free pages back to the file system in small incremental vacuum steps, one per call, so no step
+            /// holds the writer for long, and every so often lets SQLite re-analyze the tables whose statistics went
+            /// stale. Databases not yet converted to incremental auto-vacuum are left to the maintenance dialog.
+            struct DatabaseMaintenance final : public IBackgroundTask
+            {
+                DatabaseMaintenance()
+                    : IBackgroundTask{"Database Maintenance Task"}
+                {
+                }
+
+            private:
+                BackgroundTaskStatus processWork() override;
+
+                std::optional<std::chrono::steady_clock::time_point> m_startTime;
+                std::chrono::steady_clock::time_point m_nextStatisticsUpdate{};
+            };
+        } // namespace background_tasks
+    } // namespace database
+} // namespace jucyaudio
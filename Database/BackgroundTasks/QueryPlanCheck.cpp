@@ -0,0 +1,165 @@
+#include <Database/BackgroundTasks/QueryPlanCheck.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <format>
+#include <string_view>
+#include <vector>
+
+namespace jucyaudio
+{
+    namespace database
+    {
+        namespace background_tasks
+        {
+            namespace
+            {
+                // What track lists sort by: the library view's columns, and rating
+                struct SortColumn
+                {
+                    const char *name;
+                    ColumnDataTypeHint typeHint;
+                };
+                constexpr SortColumn SortColumns[] = {
+                    {"title", ColumnDataTypeHint::String},        {"artist_name", ColumnDataTypeHint::String},
+                    {"album_title", ColumnDataTypeHint::String},  {"filepath", ColumnDataTypeHint::String},
+                    {"duration", ColumnDataTypeHint::Duration},   {"bpm", ColumnDataTypeHint::Integer},
+                    {"intro_end", ColumnDataTypeHint::Integer},   {"outro_start", ColumnDataTypeHint::Integer},
+                    {"track_id", ColumnDataTypeHint::Integer},    {"rating", ColumnDataTypeHint::Integer},
+                    {"last_modified_fs", ColumnDataTypeHint::Integer},
+                };
+
+                struct Filter
+                {
+                    const char *name;
+                    void (*apply)(TrackQueryArgs &args);
+                };
+                // The values only need to look like real ones: a LIKE prefix, for one, changes the plan
+                const Filter Filters[] = {
+                    {"library", [](TrackQueryArgs &) {}},
+                    {"search", [](TrackQueryArgs &args) { args.searchTerms = {"love"}; }},
+                    {"folder", [](TrackQueryArgs &args) { args.pathFilter = std::filesystem::path{"/music/"}; }},
+                    {"working set", [](TrackQueryArgs &args) { args.workingSetId = 1; }},
+                    {"mix", [](TrackQueryArgs &args) { args.mixId = 1; }},
+                };
+
+                enum class QueryForm
+                {
+                    FirstPage,
+                    IdList,
+                };
+
+                const char *formName(QueryForm form)
+                {
+                    switch (form)
+                    {
+                    case QueryForm::FirstPage:
+                        return "first page";
+                    case QueryForm::IdList:
+                        return "id list";
+                    }
+                    return "";
+                }
+
+                // Plan steps without their indentation
+                std::vector<std::string_view> planSteps(const std::string &plan)
+                {
+                    std::vector<std::string_view> steps;
+                    size_t start = 0;
+                    while (start < plan.size())
+                    {
+                        size_t end = plan.find('\n', start);
+                        if (end == std::string::npos)
+                            end = plan.size();
+                        std::string_view step{plan.data() + start, end - start};
+                        step.remove_prefix(std::min(step.find_first_not_of(' '), step.size()));
+                        steps.push_back(step);
+                        start = end + 1;
+                    }
+                    return steps;
+                }
+            } // namespace
+
+            QueryPlanCheck::QueryPlanCheck(const ITrackDatabase &database)
+                : ILongRunningTask{"Checking Track Query Plans", true},
+                  m_database{database}
+            {
+            }
+
+            void QueryPlanCheck::run(ProgressCallback progressCb, CompletionCallback completionCb, std::atomic<bool> &shouldCancel)
+            {
+                constexpr QueryForm forms[] = {QueryForm::FirstPage, QueryForm::IdList};
+                const int total = static_cast<int>(std::size(Filters) * std::size(SortColumns) * 2 * std::size(forms));
+
+                int checked = 0;
+                std::vector<std::string> failures;
+                for (const auto &filter : Filters)
+                {
+                    const bool bFiltered = &filter != &Filters[0]; // the first is the whole library
+                    for (const auto &column : SortColumns)
+                    {
+                        for (const bool descending : {false, true})
+                        {
+                            for (const auto form : forms)
+                            {
+                                if (shouldCancel)
+                                {
+                                    completionCb(false, "Query plan check cancelled.");
+                                    return;
+                                }
+
+                                TrackQueryArgs args;
+                                filter.apply(args);
+                                args.sortBy.push_back(SortOrderInfo{column.name, descending, column.typeHint});
+
+                                const auto description = std::format("{}, {} {}, {}", filter.name, column.name, descending ? "descending" : "ascending",
+                                                                     formName(form));
+                                const auto plan = m_database.explainTrackQuery(args, form == QueryForm::IdList);
+                                ++checked;
+                                progressCb(checked * 100 / total, description);
+                                if (plan.empty())
+                                {
+                                    failures.push_back(description + ": no plan (" + m_database.getLastError() + ")");
+                                    continue;
+                                }
+                                spdlog::debug("Query plan for {}:\n{}", description, plan);
+
+                                // The whole library has to come in index order. A filter may have what it found
+                                // sorted, which beats walking a sort index past every track it did not find, but not
+                                // after reading all of Tracks.
+                                bool bSorts = false;
+                                bool bScansTracks = false; // also walking a whole index of it
+                                for (const auto step : planSteps(plan))
+                                {
+                                    bSorts |= step.starts_with("USE TEMP B-TREE FOR") && step.find("ORDER BY") != std::string_view::npos;
+                                    bScansTracks |= step == "SCAN Tracks" || step.starts_with("SCAN Tracks ");
+                                }
+                                if (bSorts && (!bFiltered || bScansTracks))
+                                {
+                                    spdlog::warn("Query plan check: {} sorts in a temporary B-tree:\n{}", description, plan);
+                                    failures.push_back(description);
+                                }
+                            }
+                        }
+                    }
+                }
+
+                if (failures.empty())
+                {
+                    completionCb(true, std::format("All {} track queries read their sort order from an index.", checked));
+                    return;
+                }
+                constexpr size_t MAX_LISTED = 12;
+                std::string message = std::format("{} of {} track queries sort in a temporary B-tree:", failures.size(), checked);
+                for (size_t i = 0; i < failures.size() && i < MAX_LISTED; ++i)
+                {
+                    message += "\n  " + failures[i];
+                }
+                if (failures.size() > MAX_LISTED)
+                {
+                    message += std::format("\n  ... and {} more; the log has their plans.", failures.size() - MAX_LISTED);
+                }
+                completionCb(false, message);
+            }
+        } // namespace background_tasks
+    } // namespace database
+} // namespace jucyaudio
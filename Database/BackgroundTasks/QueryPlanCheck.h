@@ -0,0 +1,32 @@
+#pragma once
+
+#include <Database/Includes/ILongRunningTask.h>
+#include <Database/Includes/ITrackDatabase.h>
+
+namespace jucyaudio
+{
+    namespace database
+    {
+        namespace background_tasks
+        {
+            /// @brief Checks that track lists are read in index order rather than sorted on the fly.
+            ///
+            /// For every column a track list sorts by, ascending and descending, takes the query plans of a first page
+            /// and the id list, on the whole library and with each filter (search, folder, working set, mix). On the
+            /// whole library no plan may sort in a temporary B-tree. A filtered query may sort what its filter found,
+            /// but not after scanning all of Tracks. Offending plans are logged and listed in the result.
+            ///
+            /// Runs on the open library: the plans are the ones its indexes and statistics give.
+            class QueryPlanCheck final : public ILongRunningTask
+            {
+            public:
+                explicit QueryPlanCheck(const ITrackDatabase &database);
+
+                void run(ProgressCallback progressCb, CompletionCallback completionCb, std::atomic<bool> &shouldCancel) override;
+
+            private:
+                const ITrackDatabase &m_database;
+            };
+        } // namespace background_tasks
+    } // namespace database
+} // namespace jucyaudio
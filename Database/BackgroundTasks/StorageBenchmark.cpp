@@ -0,0 +1,326 @@
+#include <Database/BackgroundTasks/StorageBenchmark.h>
+#include <Database/Sqlite/SqliteTrackDatabase.h>
+#include <Utils/AssortedUtils.h>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <optional>
+#include <random>
+
+using json = nlohmann::json;
+
+namespace jucyaudio
+{
+    namespace database
+    {
+        namespace background_tasks
+        {
+            namespace
+            {
+                constexpr const char *SCRATCH_FILENAME = "storage_benchmark.sqlite";
+                constexpr const char *LATEST_FILENAME = "storage_benchmark_latest.json";
+
+                // Workload per profile: about what a small library's first scan and a few minutes of browsing do
+                constexpr int TRACK_COUNT = 2000;
+                constexpr size_t PAGE_ROWS = 50;
+                constexpr int PAGE_FETCHES = 200;
+                constexpr int SEARCHES = 100;
+                constexpr int VOCABULARY_SIZE = 400;
+
+                struct Profile
+                {
+                    std::string name;
+                    StorageTuning tuning;
+                };
+
+                std::vector<Profile> createProfiles(const StorageTuning &configured)
+                {
+                    StorageTuning walNormal;
+                    walNormal.synchronous = "NORMAL";
+
+                    StorageTuning inMemory = walNormal;
+                    inMemory.mmapSizeMiB = 256;
+                    inMemory.cacheSizeKiB = 64 * 1024;
+                    inMemory.tempStore = "MEMORY";
+
+                    StorageTuning largePages = inMemory;
+                    largePages.pageSize = 16384;
+                    largePages.walAutoCheckpointPages = 4000;
+
+                    return {
+                        {"configured", configured}, {"sqlite_defaults", StorageTuning{}}, {"wal_normal", walNormal},
+                        {"mmap_large_cache", inMemory}, {"mmap_16k_pages", largePages},
+                    };
+                }
+
+                json tuningToJson(const StorageTuning &tuning)
+                {
+                    return json{{"mmap_size_mib", tuning.mmapSizeMiB},     {"cache_size_kib", tuning.cacheSizeKiB},
+                                {"synchronous", tuning.synchronous},       {"temp_store", tuning.tempStore},
+                                {"page_size", tuning.pageSize},            {"wal_autocheckpoint", tuning.walAutoCheckpointPages}};
+                }
+
+                // Pronounceable made-up words, the same on every run, so the full-text index has a realistic vocabulary
+                std::vector<std::string> createVocabulary(std::mt19937 &random)
+                {
+                    static constexpr const char *syllables[] = {"ka", "lo", "mi", "ra", "zen", "tu", "vel", "shi", "dor", "an",
+                                                                "bre", "qui", "mo", "sta", "nix", "el", "gra", "pho", "ul", "tri"};
+                    std::uniform_int_distribution<size_t> syllable{0, std::size(syllables) - 1};
+                    std::uniform_int_distribution<int> length{2, 4};
+                    std::vector<std::string> words;
+                    for (int i = 0; i < VOCABULARY_SIZE; ++i)
+                    {
+                        std::string word;
+                        for (int n = length(random); n > 0; --n)
+                            word += syllables[syllable(random)];
+                        words.push_back(std::move(word));
+                    }
+                    return words;
+                }
+
+                TrackInfo createTrack(int index, FolderId folderId, const std::vector<std::string> &words, std::mt19937 &random)
+                {
+                    std::uniform_int_distribution<size_t> word{0, words.size() - 1};
+                    const auto phrase = [&](int count)
+                    {
+                        std::string text = words[word(random)];
+                        while (--count > 0)
+                            text += " " + words[word(random)];
+                        return text;
+                    };
+
+                    TrackInfo track;
+                    track.folderId = folderId;
+                    track.artist_name = phrase(2);
+                    track.album_artist_name = track.artist_name;
+                    track.album_title = phrase(2);
+                    track.title = phrase(3);
+                    track.filepath = std::filesystem::path{"benchmark"} / track.artist_name / track.album_title / std::format("{:05}.mp3", index);
+                    track.track_number = index % 12 + 1;
+                    track.year = 1970 + index % 55;
+                    track.duration = Duration_t{std::uniform_int_distribution<int64_t>{120000, 480000}(random)};
+                    track.samplerate = 44100;
+                    track.channels = 2;
+                    track.bitrate = 320;
+                    track.codec_name = "mp3";
+                    track.filesize_bytes = 40000 * (track.duration.count() / 1000);
+                    track.date_added = track.last_scanned = track.last_modified_fs = std::chrono::system_clock::now();
+                    return track;
+                }
+
+                double elapsedMs(std::chrono::steady_clock::time_point start)
+                {
+                    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                }
+
+                json latencyToJson(std::vector<double> latenciesMs)
+                {
+                    if (latenciesMs.empty())
+                        return json{{"count", 0}};
+                    std::ranges::sort(latenciesMs);
+                    const auto percentile = [&latenciesMs](double p)
+                    {
+                        return latenciesMs[static_cast<size_t>(p * static_cast<double>(latenciesMs.size() - 1))];
+                    };
+                    double total = 0.0;
+                    for (const double latency : latenciesMs)
+                        total += latency;
+                    return json{{"count", latenciesMs.size()},
+                                {"total_ms", total},
+                                {"p50_ms", percentile(0.50)},
+                                {"p95_ms", percentile(0.95)},
+                                {"max_ms", latenciesMs.back()}};
+                }
+
+                void removeScratchDatabase(const std::filesystem::path &path)
+                {
+                    std::error_code ec;
+                    for (const char *suffix : {"", "-wal", "-shm"})
+                    {
+                        std::filesystem::remove(std::filesystem::path{path}.concat(suffix), ec);
+                    }
+                }
+
+                // Returns std::nullopt if the profile could not be set up, or the user cancelled in the middle of it
+                std::optional<json> runProfile(const Profile &profile, const std::filesystem::path &scratchPath, std::atomic<bool> &shouldCancel,
+                                               const std::function<void(const std::string &)> &report)
+                {
+                    removeScratchDatabase(scratchPath);
+                    SqliteTrackDatabase db;
+                    db.setStorageTuning(profile.tuning);
+                    if (!db.connect(scratchPath).isOk())
+                    {
+                        spdlog::error("Storage benchmark: cannot create {}: {}", pathToString(scratchPath), db.getLastError());
+                        return std::nullopt;
+                    }
+
+                    FolderInfo folder;
+                    folder.path = "benchmark";
+                    if (!db.getFolderDatabase().addFolder(folder))
+                        return std::nullopt;
+
+                    // Scanning saves one track per transaction, so this is where synchronous and the checkpoint size show
+                    report("saving tracks");
+                    std::mt19937 random{0x6a756379};
+                    const auto words = createVocabulary(random);
+                    std::vector<double> saveMs;
+                    saveMs.reserve(TRACK_COUNT);
+                    for (int i = 0; i < TRACK_COUNT; ++i)
+                    {
+                        if (shouldCancel)
+                            return std::nullopt;
+                        auto track = createTrack(i, folder.folderId, words, random);
+                        const auto start = std::chrono::steady_clock::now();
+                        if (!db.saveTrackInfo(track).isOk())
+                        {
+                            spdlog::error("Storage benchmark: saving a track failed: {}", db.getLastError());
+                            return std::nullopt;
+                        }
+                        saveMs.push_back(elapsedMs(start));
+                    }
+
+                    // Reading starts from a fresh connection, as after a restart, so the page cache and mmap start cold
+                    db.close();
+                    if (!db.connect(scratchPath).isOk())
+                        return std::nullopt;
+
+                    report("fetching pages");
+                    TrackQueryArgs sorted;
+                    sorted.sortBy.push_back(SortOrderInfo{"title", false, ColumnDataTypeHint::String});
+                    sorted.usePaging = false;
+                    const auto start = std::chrono::steady_clock::now();
+                    const auto trackIds = db.getTrackIds(sorted);
+                    const double snapshotMs = elapsedMs(start);
+                    if (trackIds.size() < PAGE_ROWS)
+                        return std::nullopt;
+
+                    std::uniform_int_distribution<size_t> pageStart{0, trackIds.size() - PAGE_ROWS};
+                    std::vector<double> pageMs;
+                    for (int i = 0; i < PAGE_FETCHES; ++i)
+                    {
+                        if (shouldCancel)
+                            return std::nullopt;
+                        const auto first = trackIds.begin() + static_cast<std::ptrdiff_t>(pageStart(random));
+                        const std::vector<TrackId> pageIds{first, first + PAGE_ROWS};
+                        const auto pageStartTime = std::chrono::steady_clock::now();
+                        db.getTrackRowsById(pageIds, {});
+                        pageMs.push_back(elapsedMs(pageStartTime));
+                    }
+
+                    report("searching");
+                    std::uniform_int_distribution<size_t> word{0, words.size() - 1};
+                    std::vector<double> searchMs;
+                    for (int i = 0; i < SEARCHES; ++i)
+                    {
+                        if (shouldCancel)
+                            return std::nullopt;
+                        TrackQueryArgs search = sorted;
+                        search.searchTerms = {words[word(random)]};
+                        const auto searchStart = std::chrono::steady_clock::now();
+                        db.getTrackIds(search);
+                        searchMs.push_back(elapsedMs(searchStart));
+                    }
+
+                    const auto space = db.getSpaceReport();
+                    db.close();
+                    removeScratchDatabase(scratchPath);
+
+                    json saves = latencyToJson(std::move(saveMs));
+                    saves["tracks_per_sec"] = TRACK_COUNT * 1000.0 / std::max(saves["total_ms"].get<double>(), 0.001);
+                    return json{{"name", profile.name},
+                                {"tuning", tuningToJson(profile.tuning)},
+                                {"file_bytes", space.fileBytes()},
+                                {"scan_insert", saves},
+                                {"sorted_id_list_ms", snapshotMs},
+                                {"page_fetch", latencyToJson(std::move(pageMs))},
+                                {"search", latencyToJson(std::move(searchMs))}};
+                }
+
+                // Name of the profile with the lowest median for the workload
+                std::string fastestFor(const json &profiles, const char *workload)
+                {
+                    const auto best = std::ranges::min_element(profiles,
+                                                               [workload](const json &a, const json &b)
+                                                               {
+                                                                   return a[workload]["p50_ms"].get<double>() < b[workload]["p50_ms"].get<double>();
+                                                               });
+                    return (*best)["name"].get<std::string>();
+                }
+
+                bool writeJson(const std::filesystem::path &path, const json &document)
+                {
+                    std::ofstream out{path};
+                    if (!out)
+                    {
+                        spdlog::error("Storage benchmark: cannot write {}", pathToString(path));
+                        return false;
+                    }
+                    out << document.dump(2);
+                    return static_cast<bool>(out);
+                }
+            } // namespace
+
+            StorageBenchmark::StorageBenchmark(std::filesystem::path outputDirectory, StorageTuning configured)
+                : ILongRunningTask{"Storage Benchmark", true, TaskLane::Io},
+                  m_outputDirectory{std::move(outputDirectory)},
+                  m_configured{std::move(configured)}
+            {
+            }
+
+            void StorageBenchmark::run(ProgressCallback progressCb, CompletionCallback completionCb, std::atomic<bool> &shouldCancel)
+            {
+                const auto profiles = createProfiles(m_configured);
+                const auto scratchPath = m_outputDirectory / SCRATCH_FILENAME;
+                json results = json::array();
+
+                for (size_t i = 0; i < profiles.size(); ++i)
+                {
+                    const auto report = [&, i](const std::string &phase)
+                    {
+                        progressCb(static_cast<int>(i * 100 / profiles.size()), std::format("{}: {}...", profiles[i].name, phase));
+                    };
+                    auto result = runProfile(profiles[i], scratchPath, shouldCancel, report);
+                    if (!result)
+                    {
+                        removeScratchDatabase(scratchPath);
+                        completionCb(false, shouldCancel ? "Storage benchmark cancelled." : "Storage benchmark failed for profile " + profiles[i].name + ".");
+                        return;
+                    }
+                    results.push_back(std::move(*result));
+                    spdlog::info("Storage benchmark: {}", results.back().dump());
+                }
+
+                const json document{{"version", 1},
+                                    {"timestamp", timestampToString(std::chrono::system_clock::now())},
+                                    {"tracks", TRACK_COUNT},
+                                    {"page_rows", PAGE_ROWS},
+                                    {"profiles", results}};
+
+                std::string message;
+                for (const auto &result : results)
+                {
+                    message += std::format("{}: save {:.2f} ms (p95 {:.2f}), page {:.2f} ms (p95 {:.2f}), search {:.2f} ms (p95 {:.2f})\n",
+                                           result["name"].get<std::string>(), result["scan_insert"]["p50_ms"].get<double>(),
+                                           result["scan_insert"]["p95_ms"].get<double>(), result["page_fetch"]["p50_ms"].get<double>(),
+                                           result["page_fetch"]["p95_ms"].get<double>(), result["search"]["p50_ms"].get<double>(),
+                                           result["search"]["p95_ms"].get<double>());
+                }
+                message += std::format("Fastest: saving {}, pages {}, search {}. Profiles are described in the results file; copy the chosen "
+                                       "values to the Database/Storage settings.",
+                                       fastestFor(results, "scan_insert"), fastestFor(results, "page_fetch"), fastestFor(results, "search"));
+
+                const auto latestPath = m_outputDirectory / LATEST_FILENAME;
+                if (!writeJson(latestPath, document))
+                {
+                    completionCb(false, "Cannot write benchmark results to " + pathToString(latestPath));
+                    return;
+                }
+                completionCb(true, message + "\nResults: " + pathToString(latestPath));
+            }
+        } // namespace background_tasks
+    } // namespace database
+} // namespace jucyaudio
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <Database/Includes/ILongRunningTask.h>
+#include <Database/Includes/ITrackDatabase.h>
+#include <filesystem>
+
+namespace jucyaudio
+{
+    namespace database
+    {
+        namespace background_tasks
+        {
+            /// @brief Latency benchmark for the SQLite storage settings.
+            ///
+            /// For the configured StorageTuning and a few candidates next to it, builds a scratch library of synthetic
+            /// tracks and measures what the app spends its database time on: saving scanned tracks one at a time,
+            /// fetching list pages by track id after a reopen, and full-text searches. Each profile reports median and
+            /// 95th percentile latencies, and the summary names the fastest profile per workload.
+            ///
+            /// The scratch database lives in the output directory and is deleted afterwards; the user's library is not
+            /// touched. Results are written as JSON to storage_benchmark_latest.json in the output directory.
+            class StorageBenchmark final : public ILongRunningTask
+            {
+            public:
+                StorageBenchmark(std::filesystem::path outputDirectory, StorageTuning configured);
+
+                void run(ProgressCallback progressCb, CompletionCallback completionCb, std::atomic<bool> &shouldCancel) override;
+
+            private:
+                const std::filesystem::path m_outputDirectory;
+                const StorageTuning m_configured;
+            };
+        } // namespace background_tasks
+    } // namespace database
+} // namespace jucyaudio
@@ -146,16 +146,6 @@ namespace jucyaudio
          */
         typedef long long TagId;
 
-        /**
-         * @brief Specifies sort order for database queries
-         * @note Used in TrackQueryArgs to define multi-column sorting
-         */
-        struct SortOrderInfo
-        {
-            std::string columnName; ///< Column name from DataColumn::name
-            bool descending;        ///< true for descending order, false for ascending
-        };
-
         /**
          * @brief Column alignment options for UI display
          * @note Used by DataColumn to specify text alignment in table views
@@ -182,6 +172,17 @@ namespace jucyaudio
             Rating    ///< Rating values (typically 1-5 stars)
         };
 
+        /**
+         * @brief Specifies sort order for database queries
+         * @note Used in TrackQueryArgs to define multi-column sorting
+         */
+        struct SortOrderInfo
+        {
+            std::string columnName; ///< Column name from DataColumn::name
+            bool descending;        ///< true for descending order, false for ascending
+            ColumnDataTypeHint typeHint{ColumnDataTypeHint::String}; ///< From DataColumn::typeHint; only String sorts case-insensitively
+        };
+
         /**
          * @brief Available actions that can be performed on data items
          * @details Represents user interface actions available in context menus,
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <chrono>
+#include <optional>
 #include <string>
 
 #include <Database/Includes/Constants.h>
@@ -9,13 +11,38 @@ namespace jucyaudio
 {
     namespace database
     {
+        // What a task reports after one call to processWork(); the scheduler uses it to decide when to call again
+        struct BackgroundTaskStatus
+        {
+            // true: more work is queued, run again as soon as the other tasks had their turn
+            bool hasMoreWork{false};
+            // Run again no earlier than this (e.g. a startup delay). Without it, an idle task is retried with
+            // exponential backoff, and any BackgroundTaskService::notify() makes it due immediately.
+            std::optional<std::chrono::steady_clock::time_point> nextWakeTime;
+
+            static BackgroundTaskStatus moreWork()
+            {
+                return {true, std::nullopt};
+            }
+            static BackgroundTaskStatus idle()
+            {
+                return {false, std::nullopt};
+            }
+            static BackgroundTaskStatus wakeAt(std::chrono::steady_clock::time_point when)
+            {
+                return {false, when};
+            }
+        };
+
         struct IBackgroundTask : public RefCountImpl
         {
             explicit IBackgroundTask(std::string taskName)
                 : m_taskName{std::move(taskName)}
             {
             }
-            virtual void processWork() = 0;
+
+            // Does one unit of work (e.g. one track) and reports whether there is more
+            virtual BackgroundTaskStatus processWork() = 0;
 
             const std::string m_taskName;
         };
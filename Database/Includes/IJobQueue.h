@@ -0,0 +1,86 @@
+#pragma once
+
+#include <Database/Includes/Constants.h>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace jucyaudio
+{
+    namespace database
+    {
+        typedef int64_t JobId;
+
+        /// @brief Kind of background work. Stored as an integer in Jobs.type, so never renumber.
+        enum class JobType
+        {
+            Analysis = 1 ///< Tempo map, intro/outro and loudness analysis of a track
+        };
+
+        /// @brief Every job type, for code that reports on all of them
+        constexpr JobType ALL_JOB_TYPES[] = {JobType::Analysis};
+
+        inline const char *getJobTypeName(JobType type)
+        {
+            switch (type)
+            {
+            case JobType::Analysis:
+                return "analysis";
+            }
+            return "unknown";
+        }
+
+        /// @brief After this many failed attempts a job is parked as failed and no longer handed out.
+        constexpr int MAX_JOB_ATTEMPTS = 3;
+
+        struct JobInfo
+        {
+            JobId jobId{-1};
+            JobType type{JobType::Analysis};
+            TrackId trackId{-1};
+            int priority{0};
+            int attempts{0};       ///< Failed attempts so far
+            std::string lastError; ///< Error of the most recent failed attempt, empty if none
+        };
+
+        /// @brief Persistent queue of background work, one job per (type, track).
+        ///
+        /// The scanner enqueues jobs as it commits tracks and background tasks lease them. A leased job is invisible
+        /// to other workers until it is completed, failed, released or its lease runs out (so a crash mid-job only
+        /// delays it). Failed jobs are retried with a growing delay and given up on after MAX_JOB_ATTEMPTS, keeping
+        /// the last error for diagnosis. Completed jobs are deleted, so the queue only ever holds outstanding work.
+        class IJobQueue
+        {
+        public:
+            virtual ~IJobQueue() = default;
+
+            /// @brief Queues a job for the track. If one exists it keeps the higher priority and, since the track
+            /// changed, gets a fresh set of attempts.
+            virtual bool enqueue(JobType type, TrackId trackId, int priority = 0) = 0;
+
+            /// @brief Leases the most urgent due job of the type: highest priority first, oldest first within it.
+            virtual std::optional<JobInfo> leaseNext(JobType type, std::chrono::seconds leaseDuration) = 0;
+
+            /// @brief Leases the job for a specific track, if it has one that is due.
+            virtual std::optional<JobInfo> leaseForTrack(JobType type, TrackId trackId, std::chrono::seconds leaseDuration) = 0;
+
+            /// @brief The work is done; removes the job.
+            virtual bool complete(const JobInfo &job) = 0;
+
+            /// @brief Records a failed attempt. The job is retried later, or parked once it ran out of attempts.
+            virtual bool fail(const JobInfo &job, std::string_view error) = 0;
+
+            /// @brief Gives the job back without counting an attempt, e.g. when the work was interrupted by shutdown.
+            virtual bool release(const JobInfo &job) = 0;
+
+            /// @brief Number of jobs of the type that are still to be done (leased or not, but not given up on).
+            virtual int64_t getPendingCount(JobType type) const = 0;
+
+            /// @brief Number of jobs of the type that were given up on after MAX_JOB_ATTEMPTS.
+            virtual int64_t getFailedCount(JobType type) const = 0;
+        };
+
+    } // namespace database
+} // namespace jucyaudio
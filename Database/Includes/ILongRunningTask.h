@@ -9,6 +9,7 @@
 #include <Database/Includes/Constants.h>
 #include <Database/Includes/INavigationNode.h>
 #include <spdlog/spdlog.h>
+#include <Utils/TaskExecutor.h>
 
 namespace jucyaudio
 {
@@ -25,13 +26,14 @@ namespace jucyaudio
             // --- Task Characteristics (public const members) ---
             const std::string m_taskName; // Task name for display
             const bool m_isCancellable;   // Can this task be cancelled?
+            const TaskLane m_lane;        // Executor lane: Io for tasks that mostly wait on disk, Cpu for number crunching
 
             virtual ~ILongRunningTask()
             {
                 assert(m_refCount.load() == 0); // Ensure no leaks
             }
 
-            // Called on a background thread to perform the task.
+            // Called on an executor worker (see m_lane) to perform the task.
             // The task signals completion (success/failure) and final message via completionCb.
             virtual void run(ProgressCallback progressCb, CompletionCallback completionCb, std::atomic<bool> &shouldCancel) = 0;
 
@@ -73,9 +75,10 @@ namespace jucyaudio
 
         protected:
             // Constructor for derived classes to set the const members
-            ILongRunningTask(std::string_view name, bool cancellable)
+            ILongRunningTask(std::string_view name, bool cancellable, TaskLane lane = TaskLane::Io)
                 : m_taskName{name},
                   m_isCancellable{cancellable},
+                  m_lane{lane},
                   m_refCount{1} // Start with refcount 1
             {
 #ifdef USE_REFCOUNT_DEBUGGING
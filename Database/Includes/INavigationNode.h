@@ -91,6 +91,10 @@ namespace jucyaudio
 
             virtual const TrackQueryArgs *getQueryArgs() const = 0;
 
+            /// @brief Tell the node which of its columns the UI shows, so it only has to fetch data for those.
+            /// @param columns Pointers into getColumns(); empty if unknown
+            virtual void setVisibleColumns(const std::vector<const DataColumn *> &columns) = 0;
+
             virtual std::string getCellText(RowIndex_t rowIndex, ColumnIndex_t index) const = 0;
             virtual const TrackInfo *getTrackInfoForRow(RowIndex_t rowIndex) const = 0;
 
@@ -2,10 +2,13 @@
 
 #include <Database/Includes/Constants.h>
 #include <Database/Includes/IFolderDatabase.h>
+#include <Database/Includes/ILongRunningTask.h>
+#include <Database/Includes/IJobQueue.h>
 #include <Database/Includes/IMixManager.h>
 #include <Database/Includes/ITagManager.h>
 #include <Database/Includes/IWorkingSetManager.h>
 #include <Database/Includes/MixInfo.h>
+#include <Database/Includes/QueryStats.h>
 #include <Database/Includes/TrackInfo.h>
 #include <Database/Includes/TrackQueryArgs.h>
 #include <chrono>
@@ -21,13 +24,18 @@ namespace jucyaudio
     {
         struct AudioMetadata
         {
-            float bpm = 0.0f;
+            float bpm = 0.0f; // summary derived from tempoMap
+            std::vector<TempoSegment> tempoMap;
             double introStart = 0.0;
             double introEnd = 0.0;
             double outroStart = 0.0;
             double outroEnd = 0.0;
             bool hasIntro = false;
             bool hasOutro = false;
+            double integratedLoudness = 0.0; // LUFS
+            double loudnessRange = 0.0;      // LU
+            double truePeak = 0.0;           // dBTP
+            bool hasLoudness = false;
         };
 
         // Simple status for operations, can be expanded
@@ -68,6 +76,40 @@ namespace jucyaudio
             }
         };
 
+        // Space use of the database file, read from SQLite's page counters
+        struct DatabaseSpaceReport
+        {
+            int64_t pageSize = 0;
+            int64_t pageCount = 0;
+            int64_t freePages = 0;          // on the freelist: reused by new data, or given back by a vacuum
+            bool incrementalVacuum = false; // auto_vacuum=INCREMENTAL is in effect, so free pages can be given back in steps
+
+            int64_t fileBytes() const
+            {
+                return pageSize * pageCount;
+            }
+            int64_t freeBytes() const
+            {
+                return pageSize * freePages;
+            }
+            double freeRatio() const
+            {
+                return pageCount > 0 ? static_cast<double>(freePages) / static_cast<double>(pageCount) : 0.0;
+            }
+        };
+
+        // Storage settings applied when connecting. The defaults are SQLite's own; for SQLite each field is the
+        // PRAGMA of the same name.
+        struct StorageTuning
+        {
+            int mmapSizeMiB = 0;                // memory-mapped I/O window; 0 reads through the page cache only
+            int cacheSizeKiB = 2000;            // page cache per connection
+            std::string synchronous = "FULL";   // OFF, NORMAL, FULL or EXTRA; NORMAL may lose the last commits on power loss
+            std::string tempStore = "DEFAULT";  // DEFAULT, FILE or MEMORY: where sorts and temporary tables go
+            int pageSize = 4096;                // only takes effect for a new database
+            int walAutoCheckpointPages = 1000;  // WAL size that triggers a checkpoint; 0 turns automatic checkpoints off
+        };
+
         class ITrackDatabase
         {
         public:
@@ -75,6 +117,8 @@ namespace jucyaudio
 
             // Connection management
             // Connection parameters could be a struct or a variant/map if we need more flexibility later
+            /// @brief Storage settings the next connect() applies
+            virtual void setStorageTuning(const StorageTuning &tuning) = 0;
             virtual DbResult connect(
                 const std::filesystem::path &databaseIdentifier) = 0; // For SQLite, this is a file path
                                                                       // For PostgreSQL, this could be a connection string, or we'd overload/use a struct
@@ -84,6 +128,12 @@ namespace jucyaudio
 
             // Schema management
             virtual DbResult createTablesIfNeeded() = 0;
+            /// @brief The database was opened with an older layout that takes rebuilding tables to bring up to date.
+            /// Until migrateSchema() has run it keeps working on the old layout.
+            virtual bool needsSchemaMigration() const = 0;
+            /// @brief Rebuilds the tables needsSchemaMigration() is about, reporting progress as it copies them. A
+            /// cancelled or failed run leaves the old layout in place, to be migrated on a later start.
+            virtual DbResult migrateSchema(ProgressCallback progressCb, std::atomic<bool> &shouldCancel) = 0;
             // virtual int getCurrentSchemaVersion() = 0;
             // virtual DbResult upgradeSchemaTo(int targetVersion) = 0;
 
@@ -91,15 +141,55 @@ namespace jucyaudio
             // Primary method for adding a new track or updating an existing one with full info.
             // If trackInfo.trackId is -1 (or some uninitialized state), it's an INSERT.
             // The method should update trackInfo.trackId with the assigned ID on successful insert.
-            // If trackInfo.trackId is valid, it's an UPDATE.
+            // If trackInfo.trackId is valid, it's an UPDATE of the columns in trackInfo.changedFields; tags are
+            // brought in line with trackInfo.tag_ids. A successful save clears changedFields.
             virtual DbResult saveTrackInfo(TrackInfo &trackInfo) = 0;
 
-            virtual bool runMaintenanceTasks(std::atomic<bool> &shouldCancel) = 0; // For maintenance tasks like vacuuming, reindexing, etc.
+            /// @brief Releases all free pages and refreshes the planner statistics, stopping between steps once
+            /// shouldCancel is set. The first run on a database created without incremental auto-vacuum converts it
+            /// with one full VACUUM, which shouldCancel interrupts as well.
+            virtual bool runMaintenanceTasks(std::atomic<bool> &shouldCancel) = 0;
+
+            /// @brief Space the database file takes and how much of it is free pages
+            virtual DatabaseSpaceReport getSpaceReport() const = 0;
+
+            /// @brief Hands up to maxPages free pages back to the file system, in one short write. Only possible once
+            /// the database uses incremental auto-vacuum (see runMaintenanceTasks()).
+            /// @return pages released, or -1 on error
+            virtual int64_t incrementalVacuum(int64_t maxPages) = 0;
+
+            /// @brief Re-analyzes the tables whose query planner statistics went stale, sampling a bounded number of
+            /// rows per index so it stays quick on large libraries.
+            virtual bool optimizeStatistics() = 0;
+
+            /// @brief Keeps an in-memory copy of the sort and filter columns to answer track id lists and counts from,
+            /// loaded in the background. Off by default; the queries give the same results either way.
+            virtual void setColumnIndexEnabled(bool enabled) = 0;
+
+            /// @brief Collects the cost of every statement the database runs, and logs the ones taking at least
+            /// slowQueryThreshold (zero logs none) with their query plan. Off by default.
+            virtual void setQueryProfiling(bool enabled, std::chrono::milliseconds slowQueryThreshold) = 0;
+            /// @brief Statement statistics since profiling started or was last reset, most total time first
+            virtual std::vector<QueryStats> getQueryStats() const = 0;
+            virtual void resetQueryStats() = 0;
 
             virtual std::optional<TrackInfo> getTrackById(TrackId trackId) const = 0;
             virtual std::optional<TrackInfo> getTrackByFilepath(const std::filesystem::path &filepath) const = 0;
 
             virtual std::vector<TrackInfo> getTracks(const TrackQueryArgs &args) const = 0;
+            /// @brief Ids of all tracks matching args, in its sort order (paging is ignored)
+            virtual std::vector<TrackId> getTrackIds(const TrackQueryArgs &args) const = 0;
+            /// @brief Rows for the given ids with track_id and the columns asked for (all if none), one per id and in
+            /// the same order. An id no longer in the library gives a row with trackId -1.
+            virtual std::vector<TrackListRow> getTrackRowsById(const std::vector<TrackId> &trackIds, const std::vector<std::string> &columns) const = 0;
+            /// @brief Full track infos for the given ids, one per id and in the same order; trackId -1 for ids that are gone
+            virtual std::vector<TrackInfo> getTracksById(const std::vector<TrackId> &trackIds) const = 0;
+            /// @brief Changes whenever tracks, their listed columns, tags, working sets or mixes change. Results read at
+            /// one version are still current while it returns the same.
+            virtual int64_t getDataVersion() const = 0;
+            /// @brief Query plan of the statement getTracks() runs for args, or getTrackIds() with idsOnly: one step per
+            /// line, children indented below their parent. Empty on error.
+            virtual std::string explainTrackQuery(const TrackQueryArgs &args, bool idsOnly) const = 0;
             virtual int getTotalTrackCount(const TrackQueryArgs &baseFilters) const = 0;
 
             // Specific updates, often user-driven or for quick filesystem checks
@@ -108,9 +198,9 @@ namespace jucyaudio
             virtual DbResult incrementTrackPlayCount(TrackId trackId) = 0; // And update last_played
             virtual DbResult updateTrackUserNotes(TrackId trackId, const std::string &notes) = 0;
 
-            // Finds one track that has no BPM data and returns its info.
-            // Returns std::nullopt if no such tracks are found.
-            virtual std::optional<TrackInfo> getNextTrackForBpmAnalysis() const = 0;
+            // Returns the ids of all tracks matching the query that still need analysis, in the query's sort order.
+            // Paging in args is ignored. Used to promote what the user is looking at in the analysis queue.
+            virtual std::vector<TrackId> getTrackIdsNeedingAnalysis(const TrackQueryArgs &args) const = 0;
 
             // Performs a targeted update of only the BPM for a given track.
             virtual DbResult updateTrackBpm(TrackId trackId, const AudioMetadata& am) = 0;
@@ -133,6 +223,10 @@ namespace jucyaudio
             virtual IWorkingSetManager &getWorkingSetManager() = 0;
             virtual const IWorkingSetManager &getWorkingSetManager() const = 0;
 
+            // Persistent queue of background work (analysis jobs), filled by the scanner
+            virtual IJobQueue &getJobQueue() = 0;
+            virtual const IJobQueue &getJobQueue() const = 0;
+
             /// @brief Update the tags for a track.
             /// @param trackId track ID
             /// @param tagIds updated list of tag IDs to associate with the track.
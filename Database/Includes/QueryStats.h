@@ -0,0 +1,32 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace jucyaudio
+{
+    namespace database
+    {
+        /// @brief Cost of one statement shape since profiling started: every run of SQL that is the same once its
+        /// literals are replaced by ? counts here
+        struct QueryStats
+        {
+            std::string sql;                       ///< Normalized text
+            int64_t count{0};                      ///< Runs
+            std::chrono::nanoseconds totalTime{0}; ///< From the first step to the statement finishing, summed
+            std::chrono::nanoseconds maxTime{0};
+            int64_t rows{0};      ///< Result rows, summed; counted for statements run through SqliteStatement
+            int64_t slowCount{0}; ///< Runs over the slow query threshold
+            std::string plan;     ///< EXPLAIN QUERY PLAN, taken the first time the statement was slow
+        };
+
+        /// @brief Serializes statistics for tooling (times in milliseconds)
+        std::string queryStatsToJson(const std::vector<QueryStats> &stats);
+
+        /// @brief Readable summary of the most expensive statements, for a dialog
+        std::string describeQueryStats(const std::vector<QueryStats> &stats, size_t maxStatements);
+
+    } // namespace database
+} // namespace jucyaudio
@@ -3,6 +3,7 @@
 #include <chrono>     // For time_point
 #include <cstdint>    // For std::uintmax_t
 #include <filesystem> // For file_size return type (uintmax_t)
+#include <optional>
 #include <string>
 #include <vector>
 #include <Database/Includes/Constants.h>
@@ -11,6 +12,61 @@ namespace jucyaudio
 {
     namespace database
     {
+        // One piece of a piecewise-constant tempo map. Segments are contiguous and cover the whole track.
+        struct TempoSegment
+        {
+            Duration_t start{0}; // relative to beginning of the track
+            Duration_t end{0};
+            double bpm = 0.0;
+            float confidence = 0.0f; // 0..1, how consistent the beat intervals inside the segment are
+
+            bool operator==(const TempoSegment &) const = default;
+        };
+
+        /// @brief The stored fields of a TrackInfo (everything but trackId and tag_ids), one bit each
+        enum class TrackField : uint64_t
+        {
+            FolderId = uint64_t{1} << 0,
+            Filepath = uint64_t{1} << 1,
+            LastModifiedFs = uint64_t{1} << 2,
+            FilesizeBytes = uint64_t{1} << 3,
+            DateAdded = uint64_t{1} << 4,
+            LastScanned = uint64_t{1} << 5,
+            Title = uint64_t{1} << 6,
+            ArtistName = uint64_t{1} << 7,
+            AlbumTitle = uint64_t{1} << 8,
+            AlbumArtistName = uint64_t{1} << 9,
+            TrackNumber = uint64_t{1} << 10,
+            DiscNumber = uint64_t{1} << 11,
+            Year = uint64_t{1} << 12,
+            Duration = uint64_t{1} << 13,
+            Samplerate = uint64_t{1} << 14,
+            Channels = uint64_t{1} << 15,
+            Bitrate = uint64_t{1} << 16,
+            CodecName = uint64_t{1} << 17,
+            Bpm = uint64_t{1} << 18,
+            IntroEnd = uint64_t{1} << 19,
+            OutroStart = uint64_t{1} << 20,
+            KeyString = uint64_t{1} << 21,
+            BeatLocationsJson = uint64_t{1} << 22,
+            Rating = uint64_t{1} << 23,
+            LikedStatus = uint64_t{1} << 24,
+            PlayCount = uint64_t{1} << 25,
+            LastPlayed = uint64_t{1} << 26,
+            InternalContentHash = uint64_t{1} << 27,
+            UserNotes = uint64_t{1} << 28,
+            IsMissing = uint64_t{1} << 29,
+            LoudnessLufs = uint64_t{1} << 30,
+            LoudnessRange = uint64_t{1} << 31,
+            TruePeakDb = uint64_t{1} << 32,
+            TempoMap = uint64_t{1} << 33,
+        };
+
+        /// @brief Set of TrackField bits
+        typedef uint64_t TrackFields;
+
+        constexpr TrackFields ALL_TRACK_FIELDS = (uint64_t{1} << 34) - 1;
+
         struct TrackInfo
         {
             TrackId trackId = -1;
@@ -43,11 +99,15 @@ namespace jucyaudio
             std::string codec_name;
 
             // Analysis Results
-            std::optional<BPM_t> bpm;
+            std::optional<BPM_t> bpm; // summary of tempo_map (confidence-weighted median), stored * 100
+            std::vector<TempoSegment> tempo_map;
             std::optional<Duration_t> intro_end; // relative to beginning of the track
             std::optional<Duration_t> outro_start; // relative to beginning of the track
             std::string key_string;
             std::string beat_locations_json; // Or a more structured representation
+            std::optional<double> loudness_lufs;  // EBU R128 integrated loudness
+            std::optional<double> loudness_range; // EBU R128 loudness range (LU)
+            std::optional<double> true_peak_db;   // BS.1770 true peak (dBTP)
 
             // User Data
             int rating = 0;
@@ -58,6 +118,108 @@ namespace jucyaudio
             std::string internal_content_hash; // Optional
             std::string user_notes;
             bool is_missing = false; // True if file not found on disk during last scan
+
+            /// Fields a save has to write: all of them for a new TrackInfo, none for one just read from the database
+            TrackFields changedFields = ALL_TRACK_FIELDS;
+
+            void markChanged(TrackField field)
+            {
+                changedFields |= static_cast<TrackFields>(field);
+            }
+
+            bool isChanged(TrackField field) const
+            {
+                return (changedFields & static_cast<TrackFields>(field)) != 0;
+            }
+
+            /// @brief Marks every field that differs from original, typically this track as it was read
+            void markChangedSince(const TrackInfo &original)
+            {
+                if (folderId != original.folderId)
+                    markChanged(TrackField::FolderId);
+                if (filepath != original.filepath)
+                    markChanged(TrackField::Filepath);
+                if (last_modified_fs != original.last_modified_fs)
+                    markChanged(TrackField::LastModifiedFs);
+                if (filesize_bytes != original.filesize_bytes)
+                    markChanged(TrackField::FilesizeBytes);
+                if (date_added != original.date_added)
+                    markChanged(TrackField::DateAdded);
+                if (last_scanned != original.last_scanned)
+                    markChanged(TrackField::LastScanned);
+                if (title != original.title)
+                    markChanged(TrackField::Title);
+                if (artist_name != original.artist_name)
+                    markChanged(TrackField::ArtistName);
+                if (album_title != original.album_title)
+                    markChanged(TrackField::AlbumTitle);
+                if (album_artist_name != original.album_artist_name)
+                    markChanged(TrackField::AlbumArtistName);
+                if (track_number != original.track_number)
+                    markChanged(TrackField::TrackNumber);
+                if (disc_number != original.disc_number)
+                    markChanged(TrackField::DiscNumber);
+                if (year != original.year)
+                    markChanged(TrackField::Year);
+                if (duration != original.duration)
+                    markChanged(TrackField::Duration);
+                if (samplerate != original.samplerate)
+                    markChanged(TrackField::Samplerate);
+                if (channels != original.channels)
+                    markChanged(TrackField::Channels);
+                if (bitrate != original.bitrate)
+                    markChanged(TrackField::Bitrate);
+                if (codec_name != original.codec_name)
+                    markChanged(TrackField::CodecName);
+                if (bpm != original.bpm)
+                    markChanged(TrackField::Bpm);
+                if (intro_end != original.intro_end)
+                    markChanged(TrackField::IntroEnd);
+                if (outro_start != original.outro_start)
+                    markChanged(TrackField::OutroStart);
+                if (key_string != original.key_string)
+                    markChanged(TrackField::KeyString);
+                if (beat_locations_json != original.beat_locations_json)
+                    markChanged(TrackField::BeatLocationsJson);
+                if (rating != original.rating)
+                    markChanged(TrackField::Rating);
+                if (liked_status != original.liked_status)
+                    markChanged(TrackField::LikedStatus);
+                if (play_count != original.play_count)
+                    markChanged(TrackField::PlayCount);
+                if (last_played != original.last_played)
+                    markChanged(TrackField::LastPlayed);
+                if (internal_content_hash != original.internal_content_hash)
+                    markChanged(TrackField::InternalContentHash);
+                if (user_notes != original.user_notes)
+                    markChanged(TrackField::UserNotes);
+                if (is_missing != original.is_missing)
+                    markChanged(TrackField::IsMissing);
+                if (loudness_lufs != original.loudness_lufs)
+                    markChanged(TrackField::LoudnessLufs);
+                if (loudness_range != original.loudness_range)
+                    markChanged(TrackField::LoudnessRange);
+                if (true_peak_db != original.true_peak_db)
+                    markChanged(TrackField::TruePeakDb);
+                if (tempo_map != original.tempo_map)
+                    markChanged(TrackField::TempoMap);
+            }
+        };
+
+        /// @brief The fields of a track that list views show. Filled by ITrackDatabase::getTrackRowsById() for the
+        /// columns asked for only; the rest keep their defaults.
+        struct TrackListRow
+        {
+            TrackId trackId = -1;
+            std::filesystem::path filepath;
+            Timestamp_t last_modified_fs;
+            std::string title;
+            std::string artist_name;
+            std::string album_title;
+            Duration_t duration{0};
+            std::optional<BPM_t> bpm; // stored * 100, like TrackInfo::bpm
+            std::optional<Duration_t> intro_end;
+            std::optional<Duration_t> outro_start;
         };
 
     } // namespace database
@@ -21,6 +21,9 @@ namespace jucyaudio
             WorkingSetId workingSetId{0};
             MixId mixId{0};
             bool usePaging{true};
+            /// Tracks columns (SQL ids) list views read with getTrackRowsById(), on top of track_id. Empty reads all it
+            /// knows.
+            std::vector<std::string> columns;
         };
 
     } // namespace database
@@ -85,6 +85,10 @@ namespace jucyaudio
             return true;  // Assume success
         }
 
+        void BaseNode::setVisibleColumns([[maybe_unused]] const std::vector<const DataColumn *> &columns)
+        {
+        }
+
         std::string BaseNode::getCellText([[maybe_unused]] RowIndex_t rowIndex, [[maybe_unused]] ColumnIndex_t index) const
         {
             return {};
@@ -44,6 +44,7 @@ namespace jucyaudio
             std::vector<std::string> getCurrentSearchTerms() const override;
             const DataActions &getNodeActions() const override;
             const DataActions &getRowActions(RowIndex_t rowIndex) const override;
+            void setVisibleColumns(const std::vector<const DataColumn *> &columns) override;
             std::string getCellText(RowIndex_t rowIndex, ColumnIndex_t index) const override;
             const TrackInfo *getTrackInfoForRow(RowIndex_t rowIndex) const override;
             bool getNumberOfRows(int64_t &outCount) const override;
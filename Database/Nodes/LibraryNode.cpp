@@ -35,7 +35,7 @@ namespace jucyaudio
             DataColumn{(ColumnIndex_t)Column::Artist, "artist_name", "Artist", 150, ColumnAlignment::Left, ColumnDataTypeHint::String},
             DataColumn{(ColumnIndex_t)Column::Album, "album_title", "Album", 150, ColumnAlignment::Left, ColumnDataTypeHint::String},
             DataColumn{(ColumnIndex_t)Column::Duration, "duration", "Duration", 100, ColumnAlignment::Right, ColumnDataTypeHint::Duration},
-            DataColumn{(ColumnIndex_t)Column::BPM, "bpm", "BPM at start", 80, ColumnAlignment::Left, ColumnDataTypeHint::Integer},
+            DataColumn{(ColumnIndex_t)Column::BPM, "bpm", "BPM", 80, ColumnAlignment::Left, ColumnDataTypeHint::Integer},
             DataColumn{(ColumnIndex_t)Column::Intro, "intro_end", "Intro", 80, ColumnAlignment::Left, ColumnDataTypeHint::Integer},
             DataColumn{(ColumnIndex_t)Column::Outro, "outro_start", "Outro", 80, ColumnAlignment::Left, ColumnDataTypeHint::Integer},
             DataColumn{(ColumnIndex_t)Column::TrackId, "track_id", "Track ID", 80, ColumnAlignment::Left, ColumnDataTypeHint::Integer},
@@ -58,6 +58,7 @@ namespace jucyaudio
         {
             // No dynamic memory to clean up, but we can log if needed
             // spdlog::debug("LibraryNode destructor called, cleaning up resources if any.");
+            m_rows.clear();
             m_tracks.clear();
         }
 
@@ -85,7 +86,7 @@ namespace jucyaudio
 
         bool LibraryNode::getNumberOfRows(int64_t &outCount) const
         {
-            outCount = theTrackLibrary.getTotalTrackCount(m_queryArgs);
+            outCount = static_cast<int64_t>(ensureSnapshot().size());
             return true;
         }
 
@@ -93,6 +94,8 @@ namespace jucyaudio
         {
             m_queryArgs.sortBy = sortOrders;
             m_bCacheInitialized = false;
+            m_bTracksInitialized = false;
+            invalidateSnapshot();
             return true;
         }
 
@@ -105,6 +108,8 @@ namespace jucyaudio
         {
             m_queryArgs.searchTerms = searchTerms;
             m_bCacheInitialized = false;
+            m_bTracksInitialized = false;
+            invalidateSnapshot();
             return true;
         }
 
@@ -113,9 +118,27 @@ namespace jucyaudio
             return m_queryArgs.searchTerms;
         }
 
+        void LibraryNode::setVisibleColumns(const std::vector<const DataColumn *> &columns)
+        {
+            std::vector<std::string> sqlIds;
+            for (const auto *column : columns)
+            {
+                sqlIds.push_back(column->sqlId);
+                if (column->index == (ColumnIndex_t)Column::Outro)
+                {
+                    sqlIds.push_back("duration"); // shown as time remaining after the outro starts
+                }
+            }
+            if (sqlIds != m_queryArgs.columns)
+            {
+                m_queryArgs.columns = std::move(sqlIds);
+                m_bCacheInitialized = false;
+            }
+        }
+
         std::string LibraryNode::getCellText(RowIndex_t rowIndex, ColumnIndex_t index) const
         {
-            const auto track{getTrackInfoForRow(rowIndex)};
+            const auto track{getRow(rowIndex)};
             if (track == nullptr)
             {
                 return {};
@@ -162,41 +185,109 @@ namespace jucyaudio
             }
         }
 
-        const TrackInfo *LibraryNode::getTrackInfoForRow(RowIndex_t rowIndex) const
+        namespace
         {
-            if (rowIndex < 0)
-            {
-                spdlog::warn("Row index {} is negative, returning nullptr", rowIndex);
-                return nullptr;
-            }
-            // if the cache is invalid, or the rowIndex is out of bounds, we need to retrieve the rows
-            const auto refreshCache = !m_bCacheInitialized || (rowIndex < m_queryArgs.offset) || (rowIndex >= m_queryArgs.offset + QUERY_PAGE_SIZE);
-            if (refreshCache)
+            // Loads the page holding rowIndex into cache unless it is already there; returns the row's index in the page,
+            // or -1 if the row does not exist
+            template <typename ROW, typename FETCH>
+            int64_t loadPageFor(RowIndex_t rowIndex, std::vector<ROW> &cache, RowIndex_t &cacheOffset, bool &cacheInitialized, FETCH &&fetch)
             {
-                volatile auto temp = rowIndex / QUERY_PAGE_SIZE;
-                m_queryArgs.offset = temp * QUERY_PAGE_SIZE;
-                // we should maybe switch the limit from a variable to a constant: this is an implementation detail
-                // callers of our library shouldn't need to know about this
-                m_tracks = theTrackLibrary.getTracks(m_queryArgs);
-                m_bCacheInitialized = true;
+                if (rowIndex < 0)
+                {
+                    spdlog::warn("Row index {} is negative, returning nullptr", rowIndex);
+                    return -1;
+                }
+                // if the cache is invalid, or the rowIndex is out of bounds, we need to retrieve the rows
+                if (!cacheInitialized || (rowIndex < cacheOffset) || (rowIndex >= cacheOffset + QUERY_PAGE_SIZE))
+                {
+                    cacheOffset = (rowIndex / QUERY_PAGE_SIZE) * QUERY_PAGE_SIZE;
+                    cache = fetch(cacheOffset);
+                    cacheInitialized = true;
+                }
+                const auto targetIndex = rowIndex - cacheOffset;
+                if (targetIndex >= cache.size())
+                {
+                    spdlog::warn("Target index {} is out of bounds for the current track cache size {}", targetIndex, cache.size());
+                    return -1;
+                }
+                return static_cast<int64_t>(targetIndex);
             }
-            const auto targetIndex = rowIndex - m_queryArgs.offset;
-            if (targetIndex >= m_tracks.size())
+        } // namespace
+
+        void LibraryNode::invalidateSnapshot() const
+        {
+            m_rowIds.clear();
+            m_bRowIdsInitialized = false;
+            m_dataVersion = -1;
+        }
+
+        const std::vector<TrackId> &LibraryNode::ensureSnapshot() const
+        {
+            if (!m_bRowIdsInitialized)
             {
-                spdlog::warn("Target index {} is out of bounds for the current track cache size {}", targetIndex, m_tracks.size());
-                return nullptr;
+                // Version first: a change landing in between makes the next refresh take the snapshot again
+                m_dataVersion = theTrackLibrary.getDataVersion();
+                m_rowIds = theTrackLibrary.getTrackIds(m_queryArgs);
+                m_bRowIdsInitialized = true;
             }
-            return &m_tracks[targetIndex];
+            return m_rowIds;
+        }
+
+        std::vector<TrackId> LibraryNode::getPageIds(RowIndex_t pageOffset) const
+        {
+            const auto &rowIds = ensureSnapshot();
+            if (pageOffset >= static_cast<RowIndex_t>(rowIds.size()))
+                return {};
+            const auto pageEnd = std::min<RowIndex_t>(pageOffset + QUERY_PAGE_SIZE, static_cast<RowIndex_t>(rowIds.size()));
+            return std::vector<TrackId>(rowIds.begin() + pageOffset, rowIds.begin() + pageEnd);
+        }
+
+        std::vector<TrackListRow> LibraryNode::fetchRows(RowIndex_t pageOffset) const
+        {
+            return theTrackLibrary.getTrackRowsById(getPageIds(pageOffset), m_queryArgs.columns);
+        }
+
+        std::vector<TrackInfo> LibraryNode::fetchTracks(RowIndex_t pageOffset) const
+        {
+            return theTrackLibrary.getTracksById(getPageIds(pageOffset));
+        }
+
+        const TrackListRow *LibraryNode::getRow(RowIndex_t rowIndex) const
+        {
+            const auto targetIndex = loadPageFor(rowIndex, m_rows, m_rowsOffset, m_bCacheInitialized,
+                                                 [this](RowIndex_t offset)
+                                                 {
+                                                     return fetchRows(offset);
+                                                 });
+            // A track deleted since the snapshot was taken keeps its row, empty, until the next refresh
+            return (targetIndex < 0 || m_rows[targetIndex].trackId == -1) ? nullptr : &m_rows[targetIndex];
+        }
+
+        const TrackInfo *LibraryNode::getTrackInfoForRow(RowIndex_t rowIndex) const
+        {
+            const auto targetIndex = loadPageFor(rowIndex, m_tracks, m_tracksOffset, m_bTracksInitialized,
+                                                 [this](RowIndex_t offset)
+                                                 {
+                                                     return fetchTracks(offset);
+                                                 });
+            return (targetIndex < 0 || m_tracks[targetIndex].trackId == -1) ? nullptr : &m_tracks[targetIndex];
         }
 
         void LibraryNode::refreshCache(bool flushCache) const
         {
-            // if the cache is invalid, or the rowIndex is out of bounds, we need to retrieve the rows
-            const auto refreshCache = !m_bCacheInitialized || flushCache;
-            if (refreshCache)
+            // A flush only costs something when the data changed since the snapshot was taken; then the ids are read
+            // again and the page on screen reloaded from them
+            if (flushCache && m_bRowIdsInitialized && theTrackLibrary.getDataVersion() != m_dataVersion)
+            {
+                invalidateSnapshot();
+                m_bCacheInitialized = false;
+            }
+            if (!m_bCacheInitialized)
             {
-                m_tracks = theTrackLibrary.getTracks(m_queryArgs);
+                m_rows = fetchRows(m_rowsOffset);
                 m_bCacheInitialized = true;
+                // Full track infos are reread when next asked for
+                m_bTracksInitialized = false;
             }
         }
 
@@ -29,6 +29,7 @@ namespace jucyaudio
             bool hasChildren() const override;
             const std::vector<DataColumn> &getColumns() const override;
             bool getNumberOfRows(int64_t &outCount) const override;
+            void setVisibleColumns(const std::vector<const DataColumn *> &columns) override;
             std::string getCellText(RowIndex_t rowIndex, ColumnIndex_t index) const override;
             const TrackInfo *getTrackInfoForRow(RowIndex_t rowIndex) const override;
             bool prepareToShowData() override;
@@ -43,8 +44,27 @@ namespace jucyaudio
             void refreshCache(bool flushCache = false) const override;
 
         private:
-            mutable std::vector<TrackInfo> m_tracks;
+            const TrackListRow *getRow(RowIndex_t rowIndex) const;
+            std::vector<TrackListRow> fetchRows(RowIndex_t pageOffset) const;
+            std::vector<TrackInfo> fetchTracks(RowIndex_t pageOffset) const;
+            std::vector<TrackId> getPageIds(RowIndex_t pageOffset) const;
+            const std::vector<TrackId> &ensureSnapshot() const;
+            void invalidateSnapshot() const;
+
+            // The page on screen, with just the visible columns; full TrackInfos are only read for rows acted upon
+            mutable std::vector<TrackListRow> m_rows;
+            mutable RowIndex_t m_rowsOffset{0};
             mutable bool m_bCacheInitialized{false};
+            mutable std::vector<TrackInfo> m_tracks;
+            mutable RowIndex_t m_tracksOffset{0};
+            mutable bool m_bTracksInitialized{false};
+
+            // Snapshot of the result set: every row's track id, in order, read once per query and data version. The
+            // row count is its size and a page is a slice of it looked up by id, so scrolling anywhere costs the same
+            // and rows don't shift under the user while unrelated data changes.
+            mutable std::vector<TrackId> m_rowIds;
+            mutable bool m_bRowIdsInitialized{false};
+            mutable int64_t m_dataVersion{-1}; // DataVersion the snapshot was taken at
 
         protected:
             mutable TrackQueryArgs m_queryArgs;
@@ -0,0 +1,64 @@
+#include <Database/Includes/QueryStats.h>
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <format>
+
+using json = nlohmann::json;
+
+namespace jucyaudio
+{
+    namespace database
+    {
+        namespace
+        {
+            double toMilliseconds(std::chrono::nanoseconds duration)
+            {
+                return std::chrono::duration<double, std::milli>(duration).count();
+            }
+        } // namespace
+
+        std::string queryStatsToJson(const std::vector<QueryStats> &stats)
+        {
+            json statements = json::array();
+            for (const auto &entry : stats)
+            {
+                statements.push_back(json{{"sql", entry.sql},
+                                          {"count", entry.count},
+                                          {"total_ms", toMilliseconds(entry.totalTime)},
+                                          {"mean_ms", entry.count ? toMilliseconds(entry.totalTime) / static_cast<double>(entry.count) : 0.0},
+                                          {"max_ms", toMilliseconds(entry.maxTime)},
+                                          {"rows", entry.rows},
+                                          {"slow_count", entry.slowCount},
+                                          {"plan", entry.plan.empty() ? json(nullptr) : json(entry.plan)}});
+            }
+            const auto wallClock = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch());
+            return json{{"timestamp_ms", wallClock.count()}, {"statements", statements}}.dump(2);
+        }
+
+        std::string describeQueryStats(const std::vector<QueryStats> &stats, size_t maxStatements)
+        {
+            if (stats.empty())
+                return "No statements recorded yet.";
+
+            auto total = std::chrono::nanoseconds::zero();
+            int64_t runs = 0;
+            for (const auto &entry : stats)
+            {
+                total += entry.totalTime;
+                runs += entry.count;
+            }
+            std::string text = std::format("{} statements, {} runs, {:.1f} ms in total. Most expensive:\n", stats.size(), runs, toMilliseconds(total));
+
+            constexpr size_t MAX_SQL_LENGTH = 160;
+            for (size_t i = 0; i < std::min(maxStatements, stats.size()); ++i)
+            {
+                const auto &entry = stats[i];
+                std::string sql = entry.sql.size() > MAX_SQL_LENGTH ? entry.sql.substr(0, MAX_SQL_LENGTH) + "..." : entry.sql;
+                text += std::format("\n{:.1f} ms total, {} runs, max {:.1f} ms, {} rows{}\n  {}\n", toMilliseconds(entry.totalTime), entry.count,
+                                    toMilliseconds(entry.maxTime), entry.rows, entry.slowCount ? std::format(", {} slow", entry.slowCount) : "", sql);
+            }
+            return text;
+        }
+
+    } // namespace database
+} // namespace jucyaudio
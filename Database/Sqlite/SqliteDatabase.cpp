@@ -1,6 +1,9 @@
 #include <Database/Sqlite/SqliteDatabase.h>
 #include <Database/Sqlite/SqliteStatement.h>
 #include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cctype>
+#include <thread>
 
 namespace jucyaudio
 {
@@ -48,18 +51,71 @@ namespace jucyaudio
             }
         }
 
-        bool SqliteDatabase::execute(std::string_view statement)
+        namespace
+        {
+            // Writer statements the calling thread holds. While there are any, its reads stay on the writer too, so
+            // connections are only ever locked reader first, then writer.
+            thread_local int t_writerStatements = 0;
+
+            // True if the SQL starts with the given keyword (case-insensitive, leading whitespace skipped)
+            bool startsWithKeyword(std::string_view sql, std::string_view keyword)
+            {
+                size_t pos = 0;
+                while (pos < sql.size() && std::isspace(static_cast<unsigned char>(sql[pos])))
+                    ++pos;
+                if (sql.size() - pos < keyword.size())
+                    return false;
+                for (size_t i = 0; i < keyword.size(); ++i)
+                {
+                    if (std::toupper(static_cast<unsigned char>(sql[pos + i])) != keyword[i])
+                        return false;
+                }
+                return true;
+            }
+        } // namespace
+
+        bool SqliteDatabase::execute(std::string_view statement, const std::atomic<bool> *shouldCancel)
         {
             //spdlog::debug("SqliteDatabase executing SQL: {}", statement);
+            const std::lock_guard<std::recursive_mutex> lock{m_writer.mutex};
+            if (shouldCancel)
+            {
+                // Checked every few thousand VM instructions, so even a VACUUM stops soon after it is asked to
+                sqlite3_progress_handler(m_writer.handle, 10000, &SqliteDatabase::onProgress, const_cast<std::atomic<bool> *>(shouldCancel));
+            }
             char *lpszErrorMessage = nullptr;
-            int rc = sqlite3_exec(m_db, statement.data(), nullptr, 0, &lpszErrorMessage);
-            if (rc != SQLITE_OK)
+            int rc = sqlite3_exec(m_writer.handle, statement.data(), nullptr, 0, &lpszErrorMessage);
+            if (shouldCancel)
             {
-                formatError(__LINE__, rc, "sqlite3_exec({}) failed with {}", statement, lpszErrorMessage);
+                sqlite3_progress_handler(m_writer.handle, 0, nullptr, nullptr);
+            }
+            if (rc == SQLITE_INTERRUPT && shouldCancel && shouldCancel->load())
+            {
+                spdlog::info("Cancelled: {}", statement);
                 sqlite3_free(lpszErrorMessage);
-                return false;
             }
-            return true;
+            else if (rc != SQLITE_OK)
+            {
+                formatError(m_writer.handle, __LINE__, rc, "sqlite3_exec({}) failed with {}", statement, lpszErrorMessage);
+                sqlite3_free(lpszErrorMessage);
+            }
+
+            updateTransactionOwner();
+            return rc == SQLITE_OK;
+        }
+
+        void SqliteDatabase::updateTransactionOwner()
+        {
+            // Reads of the thread that opened a transaction must see its uncommitted writes, so they stay on the writer
+            // until the transaction ends. Other threads writing into the open transaction do not take it over.
+            if (!m_writer.handle || sqlite3_get_autocommit(m_writer.handle))
+            {
+                m_transactionOwner = std::thread::id{};
+            }
+            else if (m_transactionOwner.load() == std::thread::id{})
+            {
+                m_transactionOwner = std::this_thread::get_id();
+            }
         }
 
         const char *SqliteDatabase::getVersion() const
@@ -72,34 +128,289 @@ namespace jucyaudio
             close();
         }
 
+        void SqliteDatabase::closeConnection(Connection &connection)
+        {
+            const std::lock_guard<std::recursive_mutex> lock{connection.mutex};
+            // sqlite3_close() refuses to close while prepared statements exist
+            connection.bySql.clear();
+            for (const auto &cached : connection.statementCache)
+            {
+                sqlite3_finalize(cached.statement);
+            }
+            connection.statementCache.clear();
+            connection.trace.statements.clear();
+            if (connection.handle)
+            {
+                sqlite3_close(connection.handle);
+                connection.handle = nullptr;
+            }
+        }
+
         void SqliteDatabase::close()
         {
-            if (m_db)
+            watchTableChanges({}, nullptr);
+            std::vector<std::shared_ptr<Connection>> readers;
+            {
+                const std::lock_guard<std::mutex> lock{m_readerMutex};
+                readers.swap(m_readers);
+                m_readerCount = 0;
+                m_connectionPragmas.clear();
+            }
+            for (auto &reader : readers)
             {
-                sqlite3_close(m_db);
-                m_db = nullptr;
+                closeConnection(*reader);
             }
+            closeConnection(m_writer);
+            m_profiler.setDatabaseFile({});
+            m_transactionOwner = std::thread::id{};
         }
 
-        bool SqliteDatabase::open(std::string_view filename)
+        bool SqliteDatabase::open(std::string_view filename, size_t readerCount)
         {
             close();
-            int rc = sqlite3_open_v2(filename.data(), &m_db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_FULLMUTEX,
+            m_filename = filename;
+            int rc = sqlite3_open_v2(m_filename.c_str(), &m_writer.handle, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_FULLMUTEX,
                                      nullptr);
 
             if (rc != SQLITE_OK)
             {
-                formatError(__LINE__, rc, "sqlite3_open({}) failed", filename);
-                m_db = nullptr;
+                formatError(m_writer.handle, __LINE__, rc, "sqlite3_open({}) failed", filename);
+                sqlite3_close(m_writer.handle);
+                m_writer.handle = nullptr;
+                return false;
+            }
+            sqlite3_busy_timeout(m_writer.handle, 60000);
+            m_profiler.attach(m_writer.handle, m_writer.trace, m_bProfiling);
+            m_profiler.setDatabaseFile(m_filename);
+
+            const std::lock_guard<std::mutex> lock{m_readerMutex};
+            m_readerCount = (m_filename.empty() || m_filename == ":memory:") ? 0 : readerCount;
+            return true;
+        }
+
+        bool SqliteDatabase::setConnectionPragmas(std::string statements)
+        {
+            std::vector<std::shared_ptr<Connection>> readers;
+            {
+                const std::lock_guard<std::mutex> lock{m_readerMutex};
+                m_connectionPragmas = statements;
+                readers = m_readers;
+            }
+            if (!execute(statements))
+                return false;
+            // A busy reader gets them once its statements are done, since this waits for its mutex
+            for (auto &reader : readers)
+            {
+                const std::lock_guard<std::recursive_mutex> lock{reader->mutex};
+                if (!reader->handle)
+                    continue;
+                const int rc = sqlite3_exec(reader->handle, statements.c_str(), nullptr, nullptr, nullptr);
+                if (rc != SQLITE_OK)
+                    return formatError(reader->handle, __LINE__, rc, "sqlite3_exec({}) on a reader failed", statements);
+            }
+            return true;
+        }
+
+        void SqliteDatabase::setQueryProfiling(bool enabled, std::chrono::nanoseconds slowQueryThreshold)
+        {
+            m_profiler.setSlowQueryThreshold(slowQueryThreshold);
+            m_bProfiling = enabled;
+            {
+                const std::lock_guard<std::recursive_mutex> lock{m_writer.mutex};
+                m_profiler.attach(m_writer.handle, m_writer.trace, enabled);
+            }
+            std::vector<std::shared_ptr<Connection>> readers;
+            {
+                const std::lock_guard<std::mutex> lock{m_readerMutex};
+                readers = m_readers;
+            }
+            for (auto &reader : readers)
+            {
+                const std::lock_guard<std::recursive_mutex> lock{reader->mutex};
+                m_profiler.attach(reader->handle, reader->trace, enabled);
+            }
+        }
+
+        SqliteDatabase::Connection &SqliteDatabase::acquireConnection(std::string_view sql)
+        {
+            if (t_writerStatements == 0 && startsWithKeyword(sql, "SELECT") && m_transactionOwner.load() != std::this_thread::get_id())
+            {
+                if (Connection *reader = checkoutReader())
+                {
+                    reader->mutex.lock();
+                    if (reader->handle || openReader(*reader))
+                        return *reader;
+                    reader->mutex.unlock();
+                    returnReader(*reader);
+                }
+            }
+            m_writer.mutex.lock();
+            ++t_writerStatements;
+            return m_writer;
+        }
+
+        void SqliteDatabase::releaseConnection(Connection &connection)
+        {
+            if (&connection == &m_writer)
+            {
+                updateTransactionOwner();
+                --t_writerStatements;
+                connection.mutex.unlock();
+                return;
+            }
+            connection.mutex.unlock();
+            returnReader(connection);
+        }
+
+        SqliteDatabase::Connection *SqliteDatabase::checkoutReader()
+        {
+            const auto self = std::this_thread::get_id();
+            const std::lock_guard<std::mutex> lock{m_readerMutex};
+            if (m_readerCount == 0)
+                return nullptr;
+
+            Connection *reader = nullptr;
+            for (const auto &candidate : m_readers)
+            {
+                if (candidate->holder == self)
+                {
+                    reader = candidate.get(); // nested read on the thread's own reader
+                    break;
+                }
+                if (!reader && candidate->holds == 0)
+                    reader = candidate.get();
+            }
+            if (!reader)
+            {
+                m_readers.push_back(std::make_shared<Connection>());
+                reader = m_readers.back().get();
+                if (m_readers.size() > m_readerCount)
+                    spdlog::debug("All {} SQLite readers are busy, opening another", m_readerCount);
+            }
+            reader->holder = self;
+            ++reader->holds;
+            return reader;
+        }
+
+        void SqliteDatabase::returnReader(Connection &reader)
+        {
+            std::shared_ptr<Connection> surplus;
+            {
+                const std::lock_guard<std::mutex> lock{m_readerMutex};
+                if (--reader.holds > 0)
+                    return;
+                reader.holder = std::thread::id{};
+                // Only as many readers as asked for stay open; ones opened while all were busy go again
+                if (m_readers.size() > m_readerCount)
+                {
+                    const auto it = std::find_if(m_readers.begin(), m_readers.end(),
+                                                 [&reader](const std::shared_ptr<Connection> &candidate)
+                                                 {
+                                                     return candidate.get() == &reader;
+                                                 });
+                    if (it != m_readers.end())
+                    {
+                        surplus = std::move(*it);
+                        m_readers.erase(it);
+                    }
+                }
+            }
+            if (surplus)
+                closeConnection(*surplus);
+        }
+
+        bool SqliteDatabase::openReader(Connection &reader)
+        {
+            // Opened lazily, so the writer has set up WAL mode and the schema by the time readers exist. A reader is
+            // only used by the thread holding it, under its own mutex, so SQLite's per-connection mutex is not needed.
+            const int rc = sqlite3_open_v2(m_filename.c_str(), &reader.handle, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, nullptr);
+            if (rc != SQLITE_OK)
+            {
+                formatError(reader.handle, __LINE__, rc, "sqlite3_open({}) for reading failed, using the writer", m_filename);
+                sqlite3_close(reader.handle);
+                reader.handle = nullptr;
                 return false;
             }
-            sqlite3_busy_timeout(m_db, 60000);
+            sqlite3_busy_timeout(reader.handle, 60000);
+            m_profiler.attach(reader.handle, reader.trace, m_bProfiling);
+            std::string pragmas;
+            {
+                const std::lock_guard<std::mutex> lock{m_readerMutex};
+                pragmas = m_connectionPragmas;
+            }
+            if (!pragmas.empty())
+            {
+                const int pragmaRc = sqlite3_exec(reader.handle, pragmas.c_str(), nullptr, nullptr, nullptr);
+                if (pragmaRc != SQLITE_OK)
+                    formatError(reader.handle, __LINE__, pragmaRc, "sqlite3_exec({}) on a reader failed (continuing)", pragmas);
+            }
             return true;
         }
 
-        bool SqliteDatabase::raiseError(int lno, int rc, std::string_view message)
+        sqlite3_stmt *SqliteDatabase::checkoutStatement(Connection &connection, const std::string &sql)
+        {
+            const std::lock_guard<std::recursive_mutex> lock{connection.mutex};
+            if (const auto it = connection.bySql.find(sql); it != connection.bySql.end())
+            {
+                const auto entry = it->second;
+                sqlite3_stmt *statement = entry->statement;
+                connection.bySql.erase(it); // before the list node its key points into
+                connection.statementCache.erase(entry);
+                return statement;
+            }
+
+            sqlite3_stmt *statement = nullptr;
+            int rc;
+            do
+            {
+                rc = sqlite3_prepare_v3(connection.handle, sql.data(), (int)sql.length(), SQLITE_PREPARE_PERSISTENT, &statement, nullptr);
+                if (rc == SQLITE_BUSY)
+                {
+                    std::this_thread::yield();
+                }
+                else if (rc)
+                {
+                    formatError(connection.handle, __LINE__, rc, "sqlite3_prepare_v3({}) failed", sql);
+                    return nullptr;
+                }
+            } while (rc == SQLITE_BUSY);
+            SqliteQueryProfiler::addStatement(connection.trace, statement);
+            return statement;
+        }
+
+        void SqliteDatabase::returnStatement(Connection &connection, const std::string &sql, sqlite3_stmt *statement)
         {
-            const char *msg = sqlite3_errmsg(m_db);
+            if (!statement)
+                return;
+
+            // Reset now rather than on the next checkout: a SELECT that was not stepped to the end would otherwise keep
+            // its read transaction open while it sits in the cache. Bound text points into the returning
+            // SqliteStatement, so the bindings go too.
+            sqlite3_reset(statement);
+            sqlite3_clear_bindings(statement);
+
+            const std::lock_guard<std::recursive_mutex> lock{connection.mutex};
+            if (!connection.handle || connection.bySql.contains(sql))
+            {
+                sqlite3_finalize(statement);
+                SqliteQueryProfiler::removeStatement(connection.trace, statement);
+                return;
+            }
+            connection.statementCache.push_front({sql, statement});
+            connection.bySql.emplace(connection.statementCache.front().sql, connection.statementCache.begin());
+            if (connection.statementCache.size() > STATEMENT_CACHE_CAPACITY)
+            {
+                auto &oldest = connection.statementCache.back();
+                connection.bySql.erase(oldest.sql);
+                sqlite3_finalize(oldest.statement);
+                SqliteQueryProfiler::removeStatement(connection.trace, oldest.statement);
+                connection.statementCache.pop_back();
+            }
+        }
+
+        bool SqliteDatabase::raiseError(sqlite3 *handle, int lno, int rc, std::string_view message)
+        {
+            const char *msg = handle ? sqlite3_errmsg(handle) : nullptr;
 
             std::string output;
             output.append(sqlite3_code_as_string(rc));
@@ -112,11 +423,59 @@ namespace jucyaudio
             output.append(std::to_string(lno));
             output.append("): ");
             output.append(message);
-            m_lastErrorMessage = output;
+            {
+                const std::lock_guard<std::mutex> lock{m_errorMutex};
+                m_lastErrorMessage = output;
+            }
             spdlog::error("{}", output);
             return false;
         }
 
+        void SqliteDatabase::watchTableChanges(std::string_view table, RowChangeWatcher watcher)
+        {
+            const std::lock_guard<std::recursive_mutex> lock{m_writer.mutex};
+            m_watchedTable = table;
+            m_rowChangeWatcher = std::move(watcher);
+            m_uncommittedRowIds.clear();
+            if (!m_writer.handle)
+                return;
+
+            void *context = m_rowChangeWatcher ? this : nullptr;
+            sqlite3_update_hook(m_writer.handle, context ? &SqliteDatabase::onUpdate : nullptr, context);
+            sqlite3_commit_hook(m_writer.handle, context ? &SqliteDatabase::onCommit : nullptr, context);
+            sqlite3_rollback_hook(m_writer.handle, context ? &SqliteDatabase::onRollback : nullptr, context);
+        }
+
+        void SqliteDatabase::onUpdate(void *context, [[maybe_unused]] int operation, const char *database, const char *table, sqlite3_int64 rowId)
+        {
+            auto *self = static_cast<SqliteDatabase *>(context);
+            if (std::string_view{database} == "main" && self->m_watchedTable == table)
+            {
+                self->m_uncommittedRowIds.push_back(rowId);
+            }
+        }
+
+        int SqliteDatabase::onCommit(void *context)
+        {
+            auto *self = static_cast<SqliteDatabase *>(context);
+            if (!self->m_uncommittedRowIds.empty())
+            {
+                self->m_rowChangeWatcher(self->m_uncommittedRowIds);
+                self->m_uncommittedRowIds.clear();
+            }
+            return 0; // go ahead with the commit
+        }
+
+        void SqliteDatabase::onRollback(void *context)
+        {
+            static_cast<SqliteDatabase *>(context)->m_uncommittedRowIds.clear();
+        }
+
+        int SqliteDatabase::onProgress(void *shouldCancel)
+        {
+            return static_cast<std::atomic<bool> *>(shouldCancel)->load() ? 1 : 0; // non-zero interrupts the statement
+        }
+
         bool SqliteDatabase::doesTableExist(std::string_view name)
         {
             SqliteStatement stmt{*this, "SELECT name FROM sqlite_master WHERE type='table' and name=?;"};
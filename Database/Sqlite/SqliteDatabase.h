@@ -1,40 +1,77 @@
 #pragma once
 
+#include <Database/Sqlite/SqliteQueryProfiler.h>
 #include <Database/Sqlite/sqlite3.h>
 #include <spdlog/spdlog.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 namespace jucyaudio
 {
     namespace database
     {
+        /// @brief SQLite database as a small connection pool.
+        ///
+        /// One writer connection takes every statement that may modify the database, plus everything a thread runs
+        /// while it has a transaction open. Plain SELECTs go to read-only connections instead, so in WAL mode the UI's
+        /// queries keep running from the last committed snapshot while a scan writes. A reading thread checks a reader
+        /// out for as long as it has statements on it (nested reads share it) and no other thread uses that reader
+        /// meanwhile: a read never waits for another thread's. Readers are opened on first use; when all of them are
+        /// busy another one is opened, and closed again once its statements are done.
+        ///
+        /// Whether a thread has a transaction open is read from the writer after each of its statements, so it does
+        /// not matter how the transaction was started. Still, open transactions with SqliteTransaction or
+        /// execute("BEGIN ..."): a BEGIN prepared as a SqliteStatement is only seen once that statement is destroyed.
         class SqliteDatabase final
         {
         public:
-            SqliteDatabase()
-                : m_db{nullptr}
-            {
-            }
+            static constexpr size_t DEFAULT_READER_COUNT = 4;
+
+            /// @brief Gets the rowids of the rows a committing transaction inserted, updated or deleted
+            typedef std::function<void(const std::vector<int64_t> &rowIds)> RowChangeWatcher;
+
+            SqliteDatabase() = default;
 
             ~SqliteDatabase();
 
         public:
             const char *getVersion() const;
-            bool open(std::string_view filename);
+            /// @param readerCount read-only connections kept open next to the writer; 0 runs everything on the writer
+            /// (and is what an in-memory database gets, since each connection would see its own)
+            bool open(std::string_view filename, size_t readerCount = DEFAULT_READER_COUNT);
             void close();
-            bool execute(std::string_view statement);
+            /// @param shouldCancel if given, polled while the statement runs; setting it interrupts the statement
+            bool execute(std::string_view statement, const std::atomic<bool> *shouldCancel = nullptr);
 
             bool isValid() const
             {
-                return (m_db != nullptr);
+                return (m_writer.handle != nullptr);
             }
 
+            /// @brief Statements (PRAGMAs) every connection needs: run on the writer now and on each reader as it is
+            /// opened, so per-connection settings such as cache_size reach the readers too
+            bool setConnectionPragmas(std::string statements);
+
             bool doesTableExist(std::string_view name);
 
             auto getLastInsertRowId() const
             {
-                return sqlite3_last_insert_rowid(m_db);
+                return sqlite3_last_insert_rowid(m_writer.handle);
+            }
+
+            /// @brief Rows changed by the most recent INSERT, UPDATE or DELETE
+            int getChangeCount() const
+            {
+                return sqlite3_changes(m_writer.handle);
             }
 
             SqliteDatabase(const SqliteDatabase &) = delete;
@@ -42,33 +79,112 @@ namespace jucyaudio
             SqliteDatabase(SqliteDatabase &&) = delete;
             SqliteDatabase &operator=(SqliteDatabase &&) = delete;
 
-            const auto &getLastError() const
+            std::string getLastError() const
             {
+                const std::lock_guard<std::mutex> lock{m_errorMutex};
                 return m_lastErrorMessage;
             }
 
             std::recursive_mutex &getMutex()
             {
-                // This mutex is used to ensure thread safety for database operations
-                // and should be locked before performing any operations on the database.
-                return m_mutex;
+                // This mutex guards the writer connection and should be held for any operation on it.
+                return m_writer.mutex;
+            }
+
+            /// @brief Has the watcher called for each transaction the writer commits that changed rows of the (rowid)
+            /// table. It runs on the committing thread, holding the writer, right before the commit completes: once
+            /// the writer mutex has been taken after that, readers see the changes. Rolled back changes are not
+            /// reported. One watcher at a time; an empty one stops watching. Cleared by close().
+            void watchTableChanges(std::string_view table, RowChangeWatcher watcher);
+
+            /// @brief Collects per-statement cost on every connection, and logs statements running for at least
+            /// slowQueryThreshold together with their query plan (zero logs none). Off until called; can be set
+            /// before open().
+            void setQueryProfiling(bool enabled, std::chrono::nanoseconds slowQueryThreshold);
+
+            const SqliteQueryProfiler &getQueryProfiler() const
+            {
+                return m_profiler;
+            }
+
+            SqliteQueryProfiler &getQueryProfiler()
+            {
+                return m_profiler;
             }
 
         private:
             friend class SqliteStatement;
 
+            // One sqlite3 handle with its prepared statement cache. A checked-out statement belongs exclusively to its
+            // SqliteStatement and comes back when that goes away, so the same SQL can still be run nested (the inner
+            // one is prepared fresh, and the surplus copy finalized on return).
+            struct Connection
+            {
+                struct CachedStatement
+                {
+                    std::string sql;
+                    sqlite3_stmt *statement;
+                };
+
+                sqlite3 *handle{nullptr};
+                std::recursive_mutex mutex;                                                        // held by every SqliteStatement using the connection
+                std::thread::id holder{};                                                          // readers only, guarded by m_readerMutex
+                int holds{0};                                                                      // statements of holder on the reader
+                std::list<CachedStatement> statementCache;                                         // most recently used first
+                std::unordered_map<std::string_view, std::list<CachedStatement>::iterator> bySql; // keys view into statementCache
+                SqliteQueryProfiler::ConnectionTrace trace;                                        // guarded by mutex
+            };
+
+            /// @brief Locks the connection a statement with this SQL should run on, for the calling thread; every
+            /// acquireConnection() needs a releaseConnection()
+            Connection &acquireConnection(std::string_view sql);
+            void releaseConnection(Connection &connection);
+
+            /// @brief Reader the calling thread holds, or a free one, checked out to it; nullptr if none can be opened
+            Connection *checkoutReader();
+            void returnReader(Connection &reader);
+            bool openReader(Connection &reader);
+            /// @brief Notes which thread has a transaction open on the writer; called with the writer locked
+            void updateTransactionOwner();
+
+            sqlite3_stmt *checkoutStatement(Connection &connection, const std::string &sql);
+            void returnStatement(Connection &connection, const std::string &sql, sqlite3_stmt *statement);
+            void closeConnection(Connection &connection);
+
         private:
-            bool raiseError(int lno, int rc, std::string_view message);
+            bool raiseError(sqlite3 *handle, int lno, int rc, std::string_view message);
+
+            static void onUpdate(void *context, int operation, const char *database, const char *table, sqlite3_int64 rowId);
+            static int onCommit(void *context);
+            static void onRollback(void *context);
+            static int onProgress(void *shouldCancel);
 
-            template <typename... Args> bool formatError(int lno, int rc, std::string_view text, Args &&...args)
+            template <typename... Args> bool formatError(sqlite3 *handle, int lno, int rc, std::string_view text, Args &&...args)
             {
-                return raiseError(lno, rc, std::vformat(text, std::make_format_args(args...)));
+                return raiseError(handle, lno, rc, std::vformat(text, std::make_format_args(args...)));
             }
 
         private:
-            sqlite3 *m_db;
-            mutable std::recursive_mutex m_mutex;
+            // Enough for the fixed statements of all managers; generated queries (filters, sorting) cycle through the rest
+            static constexpr size_t STATEMENT_CACHE_CAPACITY = 64;
+
+            std::string m_filename;
+            std::string m_connectionPragmas;
+            Connection m_writer;
+            std::mutex m_readerMutex;                         // guards m_readers and their holders
+            std::vector<std::shared_ptr<Connection>> m_readers; // shared, so settings can be applied outside m_readerMutex
+            size_t m_readerCount{0};                           // readers kept open; more are opened while all are busy
+            std::atomic<std::thread::id> m_transactionOwner{}; // thread with an open transaction on the writer, if any
+            mutable std::mutex m_errorMutex;
             mutable std::string m_lastErrorMessage;
+
+            SqliteQueryProfiler m_profiler;
+            std::atomic<bool> m_bProfiling{false}; // attach the profiler to connections as they open
+
+            // Only touched with the writer mutex held: the hooks run inside writer statements
+            std::string m_watchedTable;
+            RowChangeWatcher m_rowChangeWatcher;
+            std::vector<int64_t> m_uncommittedRowIds; // changed by the open transaction so far
         };
 
     } // namespace database
@@ -0,0 +1,170 @@
+#include <Database/BackgroundMetrics.h>
+#include <Database/Sqlite/SqliteJobQueue.h>
+#include <Database/Sqlite/SqliteStatement.h>
+#include <spdlog/spdlog.h>
+
+namespace
+{
+    using namespace jucyaudio;
+    using namespace jucyaudio::database;
+
+    // Leases and retry times are wall-clock, so they stay meaningful across restarts
+    int64_t nowMs()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    int64_t leaseUntil(std::chrono::seconds leaseDuration)
+    {
+        return nowMs() + std::chrono::duration_cast<std::chrono::milliseconds>(leaseDuration).count();
+    }
+
+    // First retry after a minute, doubling with each further failure
+    constexpr int64_t RETRY_DELAY_MS = 60 * 1000;
+
+    // Columns returned by the lease statements, in this order
+    constexpr const char *JOB_COLUMNS = "job_id, type, track_id, priority, attempts, last_error";
+} // namespace
+
+namespace jucyaudio
+{
+    namespace database
+    {
+        bool SqliteJobQueue::enqueue(JobType type, TrackId trackId, int priority)
+        {
+            // A job that is leased right now keeps its lease; a failed or waiting one becomes due immediately
+            SqliteStatement stmt{m_db, R"SQL(
+INSERT INTO Jobs (type, track_id, priority) VALUES (?, ?, ?)
+ON CONFLICT(type, track_id) DO UPDATE SET
+    priority = MAX(priority, excluded.priority),
+    attempts = 0,
+    last_error = NULL,
+    lease_until = CASE WHEN failed = 0 AND attempts = 0 THEN lease_until ELSE 0 END,
+    failed = 0;)SQL"};
+            return stmt.addParam(static_cast<int32_t>(type)) && stmt.addParam(static_cast<int64_t>(trackId)) && stmt.addParam(static_cast<int32_t>(priority)) &&
+                   stmt.execute();
+        }
+
+        std::optional<JobInfo> SqliteJobQueue::leaseFromStatement(SqliteStatement &stmt)
+        {
+            if (!stmt.isValid() || !stmt.getNextResult())
+                return std::nullopt;
+
+            JobInfo job;
+            int col = 0;
+            job.jobId = stmt.getInt64(col++);
+            job.type = static_cast<JobType>(stmt.getInt32(col++));
+            job.trackId = stmt.getInt64(col++);
+            job.priority = stmt.getInt32(col++);
+            job.attempts = stmt.getInt32(col++);
+            if (!stmt.isNull(col))
+                job.lastError = stmt.getText(col);
+            col++;
+
+            // Step past the RETURNING row so the UPDATE completes before the statement is finalized
+            stmt.getNextResult();
+            return job;
+        }
+
+        std::optional<JobInfo> SqliteJobQueue::leaseNext(JobType type, std::chrono::seconds leaseDuration)
+        {
+            // The subquery walks idx_jobs_next in order; only jobs leased or waiting for a retry are skipped
+            const auto now = nowMs();
+            SqliteStatement stmt{m_db, std::string{R"SQL(
+UPDATE Jobs SET lease_until = ?
+WHERE job_id = (SELECT job_id FROM Jobs
+                WHERE type = ? AND failed = 0 AND lease_until <= ?
+                ORDER BY priority DESC, job_id
+                LIMIT 1)
+RETURNING )SQL"} + JOB_COLUMNS + ";"};
+            if (!(stmt.addParam(leaseUntil(leaseDuration)) && stmt.addParam(static_cast<int32_t>(type)) && stmt.addParam(now)))
+                return std::nullopt;
+            return leaseFromStatement(stmt);
+        }
+
+        std::optional<JobInfo> SqliteJobQueue::leaseForTrack(JobType type, TrackId trackId, std::chrono::seconds leaseDuration)
+        {
+            const auto now = nowMs();
+            SqliteStatement stmt{m_db, std::string{R"SQL(
+UPDATE Jobs SET lease_until = ?
+WHERE type = ? AND track_id = ? AND failed = 0 AND lease_until <= ?
+RETURNING )SQL"} + JOB_COLUMNS + ";"};
+            if (!(stmt.addParam(leaseUntil(leaseDuration)) && stmt.addParam(static_cast<int32_t>(type)) && stmt.addParam(static_cast<int64_t>(trackId)) &&
+                  stmt.addParam(now)))
+                return std::nullopt;
+            return leaseFromStatement(stmt);
+        }
+
+        bool SqliteJobQueue::complete(const JobInfo &job)
+        {
+            theBackgroundMetrics.recordCompleted(job.type);
+            SqliteStatement stmt{m_db, "DELETE FROM Jobs WHERE job_id = ?;"};
+            return stmt.addParam(job.jobId) && stmt.execute();
+        }
+
+        bool SqliteJobQueue::fail(const JobInfo &job, std::string_view error)
+        {
+            theBackgroundMetrics.recordFailed(job.type);
+            const int attempts = job.attempts + 1;
+            const bool givingUp = attempts >= MAX_JOB_ATTEMPTS;
+            const int64_t retryAt = nowMs() + (RETRY_DELAY_MS << (attempts - 1));
+            if (givingUp)
+            {
+                spdlog::warn("Job {} for track {} failed {} times, giving up: {}", job.jobId, job.trackId, attempts, error);
+            }
+            else
+            {
+                spdlog::info("Job {} for track {} failed (attempt {} of {}): {}", job.jobId, job.trackId, attempts, MAX_JOB_ATTEMPTS, error);
+            }
+
+            SqliteStatement stmt{m_db, "UPDATE Jobs SET attempts = ?, last_error = ?, lease_until = ?, failed = ? WHERE job_id = ?;"};
+            return stmt.addParam(static_cast<int32_t>(attempts)) && stmt.addParam(error) && stmt.addParam(givingUp ? int64_t{0} : retryAt) &&
+                   stmt.addParam(static_cast<int32_t>(givingUp ? 1 : 0)) && stmt.addParam(job.jobId) && stmt.execute();
+        }
+
+        bool SqliteJobQueue::release(const JobInfo &job)
+        {
+            SqliteStatement stmt{m_db, "UPDATE Jobs SET lease_until = 0 WHERE job_id = ?;"};
+            return stmt.addParam(job.jobId) && stmt.execute();
+        }
+
+        int64_t SqliteJobQueue::getPendingCount(JobType type) const
+        {
+            SqliteStatement stmt{m_db, "SELECT COUNT(*) FROM Jobs WHERE type = ? AND failed = 0;"};
+            if (!stmt.addParam(static_cast<int32_t>(type)) || !stmt.getNextResult())
+                return 0;
+            return stmt.getInt64(0);
+        }
+
+        int64_t SqliteJobQueue::getFailedCount(JobType type) const
+        {
+            SqliteStatement stmt{m_db, "SELECT COUNT(*) FROM Jobs WHERE type = ? AND failed = 1;"};
+            if (!stmt.addParam(static_cast<int32_t>(type)) || !stmt.getNextResult())
+                return 0;
+            return stmt.getInt64(0);
+        }
+
+        bool SqliteJobQueue::enqueueUnanalyzedTracks()
+        {
+            // Tracks that are part of a mix get the lower job ids, so they are analyzed first
+            SqliteStatement stmt{m_db, R"SQL(
+INSERT OR IGNORE INTO Jobs (type, track_id, priority)
+SELECT ?, T.track_id, 0 FROM Tracks T
+WHERE (T.bpm IS NULL OR T.bpm <= 0) AND T.is_missing = 0
+  AND NOT EXISTS (SELECT 1 FROM Jobs J WHERE J.type = ? AND J.track_id = T.track_id)
+ORDER BY EXISTS (SELECT 1 FROM MixTracks MT WHERE MT.track_id = T.track_id) DESC, T.track_id;)SQL"};
+            if (!(stmt.addParam(static_cast<int32_t>(JobType::Analysis)) && stmt.addParam(static_cast<int32_t>(JobType::Analysis)) && stmt.execute()))
+            {
+                spdlog::error("Failed to queue unanalyzed tracks: {}", m_db.getLastError());
+                return false;
+            }
+            const auto added = m_db.getChangeCount();
+            if (added > 0)
+            {
+                spdlog::info("Queued {} track(s) for analysis", added);
+            }
+            return true;
+        }
+
+    } // namespace database
+} // namespace jucyaudio
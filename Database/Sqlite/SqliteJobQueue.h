@@ -0,0 +1,41 @@
+#pragma once
+
+#include <Database/Includes/IJobQueue.h>
+#include <Database/Sqlite/SqliteDatabase.h>
+
+namespace jucyaudio
+{
+    namespace database
+    {
+        class SqliteStatement;
+
+        class SqliteJobQueue : public IJobQueue
+        {
+        public:
+            SqliteJobQueue(database::SqliteDatabase &db)
+                : m_db{db}
+            {
+            }
+            ~SqliteJobQueue() override = default;
+
+            bool enqueue(JobType type, TrackId trackId, int priority = 0) override;
+            std::optional<JobInfo> leaseNext(JobType type, std::chrono::seconds leaseDuration) override;
+            std::optional<JobInfo> leaseForTrack(JobType type, TrackId trackId, std::chrono::seconds leaseDuration) override;
+            bool complete(const JobInfo &job) override;
+            bool fail(const JobInfo &job, std::string_view error) override;
+            bool release(const JobInfo &job) override;
+            int64_t getPendingCount(JobType type) const override;
+            int64_t getFailedCount(JobType type) const override;
+
+            /// @brief Queues analysis for tracks that have no tempo yet and no job either: libraries scanned before the
+            /// Jobs table existed, or a crash between saving a track and queueing it. Run once on connect.
+            bool enqueueUnanalyzedTracks();
+
+        private:
+            std::optional<JobInfo> leaseFromStatement(SqliteStatement &stmt);
+
+            database::SqliteDatabase &m_db;
+        };
+
+    } // namespace database
+} // namespace jucyaudio
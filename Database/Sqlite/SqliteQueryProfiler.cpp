@@ -0,0 +1,319 @@
+#include <Database/Sqlite/SqliteQueryProfiler.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cctype>
+
+namespace jucyaudio
+{
+    namespace database
+    {
+        namespace
+        {
+            bool isIdentifierChar(char c)
+            {
+                return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+            }
+
+            // A list of values (?, ?, ?) becomes (?)
+            void appendPlaceholder(std::string &out)
+            {
+                if (out.ends_with("?,"))
+                    out.pop_back();
+                else if (out.ends_with("?, "))
+                    out.resize(out.size() - 2);
+                else
+                    out += '?';
+            }
+        } // namespace
+
+        SqliteQueryProfiler::~SqliteQueryProfiler()
+        {
+            setDatabaseFile({});
+        }
+
+        void SqliteQueryProfiler::attach(sqlite3 *handle, ConnectionTrace &trace, bool enabled)
+        {
+            if (!handle)
+                return;
+            trace.profiler = this;
+            if (enabled)
+                sqlite3_trace_v2(handle, SQLITE_TRACE_STMT | SQLITE_TRACE_PROFILE, &SqliteQueryProfiler::onTrace, &trace);
+            else
+                sqlite3_trace_v2(handle, 0, nullptr, nullptr);
+        }
+
+        void SqliteQueryProfiler::addStatement(ConnectionTrace &trace, sqlite3_stmt *statement)
+        {
+            trace.statements[statement] = ConnectionTrace::Statement{nullptr, true, {}};
+        }
+
+        void SqliteQueryProfiler::removeStatement(ConnectionTrace &trace, sqlite3_stmt *statement)
+        {
+            trace.statements.erase(statement);
+        }
+
+        int64_t *SqliteQueryProfiler::rowCounter(ConnectionTrace &trace, sqlite3_stmt *statement)
+        {
+            const auto it = trace.statements.find(statement);
+            return it != trace.statements.end() ? &it->second.rows : nullptr;
+        }
+
+        void SqliteQueryProfiler::setDatabaseFile(std::string filename)
+        {
+            const std::lock_guard<std::mutex> lock{m_explainMutex};
+            if (m_explainHandle)
+            {
+                sqlite3_close(m_explainHandle);
+                m_explainHandle = nullptr;
+            }
+            m_filename = std::move(filename);
+        }
+
+        std::vector<QueryStats> SqliteQueryProfiler::getStats() const
+        {
+            std::vector<QueryStats> result;
+            {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                result.reserve(m_stats.size());
+                for (const auto &[sql, entry] : m_stats)
+                {
+                    QueryStats stats;
+                    stats.count = entry->count.load(std::memory_order_relaxed);
+                    if (stats.count == 0)
+                        continue; // not run since the last reset()
+                    stats.sql = entry->sql;
+                    stats.totalTime = std::chrono::nanoseconds{entry->totalNs.load(std::memory_order_relaxed)};
+                    stats.maxTime = std::chrono::nanoseconds{entry->maxNs.load(std::memory_order_relaxed)};
+                    stats.rows = entry->rows.load(std::memory_order_relaxed);
+                    stats.slowCount = entry->slowCount.load(std::memory_order_relaxed);
+                    stats.plan = entry->plan;
+                    result.push_back(std::move(stats));
+                }
+            }
+            std::ranges::sort(result,
+                              [](const QueryStats &a, const QueryStats &b)
+                              {
+                                  return a.totalTime > b.totalTime;
+                              });
+            return result;
+        }
+
+        void SqliteQueryProfiler::reset()
+        {
+            const std::lock_guard<std::mutex> lock{m_mutex};
+            for (auto &[sql, entry] : m_stats)
+            {
+                entry->count = 0;
+                entry->totalNs = 0;
+                entry->maxNs = 0;
+                entry->rows = 0;
+                entry->slowCount = 0;
+                entry->bPlanTaken = false;
+                entry->plan.clear();
+            }
+        }
+
+        std::string SqliteQueryProfiler::normalizeSql(std::string_view sql)
+        {
+            std::string out;
+            out.reserve(sql.size());
+            size_t i = 0;
+            while (i < sql.size())
+            {
+                const char c = sql[i];
+                if (std::isspace(static_cast<unsigned char>(c)))
+                {
+                    while (i < sql.size() && std::isspace(static_cast<unsigned char>(sql[i])))
+                        ++i;
+                    if (!out.empty() && out.back() != ' ')
+                        out += ' ';
+                }
+                else if (c == '-' && i + 1 < sql.size() && sql[i + 1] == '-')
+                {
+                    while (i < sql.size() && sql[i] != '\n')
+                        ++i;
+                }
+                else if (c == '\'')
+                {
+                    const size_t start = i;
+                    // '' inside a literal is an escaped quote, so a literal ends at a quote not followed by another
+                    for (++i; i < sql.size(); ++i)
+                    {
+                        if (sql[i] != '\'')
+                            continue;
+                        if (i + 1 < sql.size() && sql[i + 1] == '\'')
+                            ++i;
+                        else
+                            break;
+                    }
+                    ++i;
+                    // A quoted schema or table name, as in FTS5's own statements ('main'.'TrackSearch_data'), stays
+                    if ((i < sql.size() && sql[i] == '.') || out.ends_with('.'))
+                        out.append(sql.substr(start, i - start));
+                    else
+                        appendPlaceholder(out);
+                }
+                else if (std::isdigit(static_cast<unsigned char>(c)) && (out.empty() || (!isIdentifierChar(out.back()) && out.back() != '?')))
+                {
+                    while (i < sql.size() && (isIdentifierChar(sql[i]) || sql[i] == '.'))
+                        ++i;
+                    appendPlaceholder(out);
+                }
+                else if (c == '?')
+                {
+                    ++i;
+                    appendPlaceholder(out);
+                }
+                else
+                {
+                    out += c;
+                    ++i;
+                }
+            }
+            while (!out.empty() && (out.back() == ' ' || out.back() == ';'))
+                out.pop_back();
+            return out;
+        }
+
+        int SqliteQueryProfiler::onTrace(unsigned type, void *context, void *statement, void *detail)
+        {
+            auto &trace = *static_cast<ConnectionTrace *>(context);
+            auto *stmt = static_cast<sqlite3_stmt *>(statement);
+            if (type == SQLITE_TRACE_STMT)
+            {
+                // Also reported at the start of each trigger the statement fires, with "-- TRIGGER name" as the text
+                if (!std::string_view{static_cast<const char *>(detail)}.starts_with("--"))
+                {
+                    auto &running = trace.statements[stmt];
+                    running.start = std::chrono::steady_clock::now();
+                    running.rows = 0;
+                }
+            }
+            else if (type == SQLITE_TRACE_PROFILE)
+            {
+                const auto it = trace.statements.find(stmt);
+                const char *sql = sqlite3_sql(stmt);
+                if (!sql)
+                    return 0;
+
+                // SQLite's own time only has the VFS clock's millisecond resolution; most statements here take less
+                int64_t nanoseconds = *static_cast<const sqlite3_int64 *>(detail);
+                if (it == trace.statements.end())
+                {
+                    trace.profiler->record(trace.profiler->entryFor(sql), sql, nanoseconds, 0);
+                    return 0;
+                }
+                nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - it->second.start).count();
+
+                // Statements of sqlite3_exec() and of extensions like FTS5 are finalized without the connection knowing,
+                // so only its own cached statements keep their entry for the next run
+                if (it->second.bPersistent)
+                {
+                    if (!it->second.entry)
+                        it->second.entry = &trace.profiler->entryFor(sql);
+                    trace.profiler->record(*it->second.entry, sql, nanoseconds, it->second.rows);
+                }
+                else
+                {
+                    const int64_t rows = it->second.rows;
+                    trace.statements.erase(it);
+                    trace.profiler->record(trace.profiler->entryFor(sql), sql, nanoseconds, rows);
+                }
+            }
+            return 0;
+        }
+
+        SqliteQueryProfiler::Entry &SqliteQueryProfiler::entryFor(const char *sql)
+        {
+            std::string normalized = normalizeSql(sql);
+            const std::lock_guard<std::mutex> lock{m_mutex};
+            auto &entry = m_stats[normalized];
+            if (!entry)
+            {
+                entry = std::make_unique<Entry>();
+                entry->sql = std::move(normalized);
+            }
+            return *entry;
+        }
+
+        void SqliteQueryProfiler::record(Entry &entry, const char *sql, int64_t nanoseconds, int64_t rows)
+        {
+            entry.count.fetch_add(1, std::memory_order_relaxed);
+            entry.totalNs.fetch_add(nanoseconds, std::memory_order_relaxed);
+            entry.rows.fetch_add(rows, std::memory_order_relaxed);
+            int64_t maxNs = entry.maxNs.load(std::memory_order_relaxed);
+            while (nanoseconds > maxNs && !entry.maxNs.compare_exchange_weak(maxNs, nanoseconds, std::memory_order_relaxed))
+            {
+            }
+
+            const int64_t threshold = m_slowThresholdNs;
+            if (threshold <= 0 || nanoseconds < threshold)
+                return;
+
+            entry.slowCount.fetch_add(1, std::memory_order_relaxed);
+            bool takePlan = false;
+            std::string plan;
+            {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                takePlan = !entry.bPlanTaken;
+                entry.bPlanTaken = true;
+                plan = entry.plan;
+            }
+            if (takePlan)
+            {
+                plan = explainQueryPlan(sql);
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                entry.plan = plan;
+            }
+            spdlog::warn("Slow query: {:.1f} ms: {}{}{}", nanoseconds / 1e6, entry.sql, plan.empty() ? "" : "\n", plan);
+        }
+
+        std::string SqliteQueryProfiler::explainQueryPlan(const char *sql)
+        {
+            const std::lock_guard<std::mutex> lock{m_explainMutex};
+            if (!m_explainHandle)
+            {
+                if (m_filename.empty() || m_filename == ":memory:")
+                    return {};
+                if (sqlite3_open_v2(m_filename.c_str(), &m_explainHandle, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, nullptr) != SQLITE_OK)
+                {
+                    spdlog::warn("Cannot open {} to read query plans: {}", m_filename, sqlite3_errmsg(m_explainHandle));
+                    sqlite3_close(m_explainHandle);
+                    m_explainHandle = nullptr;
+                    return {};
+                }
+                // Only ever waits for a checkpoint; a plan is not worth holding up the slow statement's thread any longer
+                sqlite3_busy_timeout(m_explainHandle, 100);
+            }
+
+            sqlite3_stmt *statement = nullptr;
+            const std::string explainSql = std::string{"EXPLAIN QUERY PLAN "} + sql;
+            if (sqlite3_prepare_v2(m_explainHandle, explainSql.c_str(), -1, &statement, nullptr) != SQLITE_OK)
+            {
+                // E.g. a statement on a table the writer has not committed yet
+                spdlog::debug("No query plan for {}: {}", sql, sqlite3_errmsg(m_explainHandle));
+                sqlite3_finalize(statement);
+                return {};
+            }
+
+            // Rows are (id, parent, notused, detail); children come after their parent
+            std::unordered_map<int, int> depthOf;
+            std::string plan;
+            while (sqlite3_step(statement) == SQLITE_ROW)
+            {
+                const int id = sqlite3_column_int(statement, 0);
+                const int parent = sqlite3_column_int(statement, 1);
+                const auto detail = reinterpret_cast<const char *>(sqlite3_column_text(statement, 3));
+                const auto parentDepth = depthOf.find(parent);
+                const int depth = parentDepth != depthOf.end() ? parentDepth->second + 1 : 0;
+                depthOf[id] = depth;
+                if (!plan.empty())
+                    plan += '\n';
+                plan += std::string(2 * static_cast<size_t>(depth) + 2, ' ') + (detail ? detail : "");
+            }
+            sqlite3_finalize(statement);
+            return plan;
+        }
+
+    } // namespace database
+} // namespace jucyaudio
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <Database/Includes/QueryStats.h>
+#include <Database/Sqlite/sqlite3.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace jucyaudio
+{
+    namespace database
+    {
+        /// @brief Per-statement cost, collected from sqlite3_trace_v2 on the connections it is attached to.
+        ///
+        /// Statements are grouped by their SQL with literals, comments and runs of whitespace normalized away, and
+        /// lists of values collapsed to one, so generated queries that only differ in their values share an entry.
+        /// Statements slower than the threshold are logged with their query plan, which is taken once per entry on a
+        /// read-only connection of the profiler's own, never on the connection that ran the statement.
+        ///
+        /// Timing state lives in each connection's ConnectionTrace, which only the thread holding the connection
+        /// touches, and the counters are atomics, so profiled readers do not wait for each other. A statement the
+        /// connection keeps in its statement cache remembers its entry, so its SQL is normalized once, not per run.
+        /// Result rows are counted by SqliteStatement as it steps, not with a per-row trace callback.
+        class SqliteQueryProfiler final
+        {
+            struct Entry;
+
+        public:
+            /// @brief Statements running or cached on one connection; guarded by that connection's lock
+            struct ConnectionTrace
+            {
+                struct Statement
+                {
+                    Entry *entry{nullptr}; // set on the first run of a statement added with addStatement()
+                    bool bPersistent{false};
+                    std::chrono::steady_clock::time_point start;
+                    int64_t rows{0}; // of the current run, counted through rowCounter()
+                };
+
+                SqliteQueryProfiler *profiler{nullptr};
+                std::unordered_map<sqlite3_stmt *, Statement> statements;
+            };
+
+            SqliteQueryProfiler() = default;
+            ~SqliteQueryProfiler();
+
+            SqliteQueryProfiler(const SqliteQueryProfiler &) = delete;
+            SqliteQueryProfiler &operator=(const SqliteQueryProfiler &) = delete;
+
+            /// @brief Starts or stops tracing the connection; the caller must hold the connection exclusively
+            void attach(sqlite3 *handle, ConnectionTrace &trace, bool enabled);
+
+            /// @brief The connection prepared the statement to keep it until removeStatement(), so what it was
+            /// prepared from can be remembered
+            static void addStatement(ConnectionTrace &trace, sqlite3_stmt *statement);
+            /// @brief Call once the statement is finalized; its address may come back for different SQL
+            static void removeStatement(ConnectionTrace &trace, sqlite3_stmt *statement);
+            /// @brief Where the caller counts the statement's result rows, valid until removeStatement(); nullptr for
+            /// a statement not added with addStatement()
+            static int64_t *rowCounter(ConnectionTrace &trace, sqlite3_stmt *statement);
+
+            /// @brief Database file query plans are read from; empty (or an in-memory database) goes without plans
+            void setDatabaseFile(std::string filename);
+
+            /// @param threshold runs taking at least this long are logged; zero logs none
+            void setSlowQueryThreshold(std::chrono::nanoseconds threshold)
+            {
+                m_slowThresholdNs = threshold.count();
+            }
+
+            /// @brief Statistics so far, most total time first
+            std::vector<QueryStats> getStats() const;
+            void reset();
+
+            static std::string normalizeSql(std::string_view sql);
+
+        private:
+            // Never removed while the profiler exists, since connections keep pointers to them; reset() zeroes them
+            struct Entry
+            {
+                std::string sql; // normalized
+                std::atomic<int64_t> count{0};
+                std::atomic<int64_t> totalNs{0};
+                std::atomic<int64_t> maxNs{0};
+                std::atomic<int64_t> rows{0};
+                std::atomic<int64_t> slowCount{0};
+                bool bPlanTaken{false}; // tried once, whether or not there was a plan; guarded by m_mutex
+                std::string plan;       // guarded by m_mutex
+            };
+
+            static int onTrace(unsigned type, void *context, void *statement, void *detail);
+
+            Entry &entryFor(const char *sql);
+            void record(Entry &entry, const char *sql, int64_t nanoseconds, int64_t rows);
+            std::string explainQueryPlan(const char *sql);
+
+            std::atomic<int64_t> m_slowThresholdNs{0};
+
+            mutable std::mutex m_mutex;
+            std::unordered_map<std::string, std::unique_ptr<Entry>> m_stats; // by normalized SQL
+
+            std::mutex m_explainMutex;
+            std::string m_filename;
+            sqlite3 *m_explainHandle{nullptr};
+        };
+
+    } // namespace database
+} // namespace jucyaudio
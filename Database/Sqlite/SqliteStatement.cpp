@@ -6,8 +6,7 @@ namespace jucyaudio
     namespace database
     {
         SqliteStatement::SqliteStatement(SqliteDatabase &db, std::string_view statement)
-            : m_lock(db.getMutex()),
-              m_db{db},
+            : m_db{db},
               m_statement{nullptr},
               m_param_index{1},
               m_statement_text{},
@@ -17,8 +16,7 @@ namespace jucyaudio
         }
 
         SqliteStatement::SqliteStatement(SqliteDatabase &db)
-            : m_lock(db.getMutex()),
-              m_db{db},
+            : m_db{db},
               m_statement{nullptr},
               m_param_index{1},
               m_done{false}
@@ -36,21 +34,26 @@ namespace jucyaudio
             m_param_index = 1;
             m_done = false;
 
-            int rc;
-            do
+            // Plain reads run on a reader connection, everything else on the writer
+            m_connection = &m_db.acquireConnection(m_statement_text);
+
+            // Borrowed from the connection's cache; hot statements skip SQL parsing altogether
+            m_statement = m_db.checkoutStatement(*m_connection, m_statement_text);
+            if (m_statement)
             {
-                rc = sqlite3_prepare_v2(m_db.m_db, m_statement_text.data(), (int)m_statement_text.length(), &m_statement, nullptr);
-                if (rc == SQLITE_BUSY)
-                {
-                    std::this_thread::yield();
-                }
-                else if (rc)
-                {
-                    m_statement = nullptr;
-                    return m_db.formatError(__LINE__, rc, "sqlite3_prepare_v2({}) failed", m_statement_text);
-                }
-            } while (rc == SQLITE_BUSY);
+                m_rowCount = SqliteQueryProfiler::rowCounter(m_connection->trace, m_statement);
+            }
+            return m_statement != nullptr;
+        }
 
+        bool SqliteStatement::reset()
+        {
+            if (!m_statement)
+                return false;
+            sqlite3_reset(m_statement);
+            sqlite3_clear_bindings(m_statement);
+            m_param_index = 1;
+            m_done = false;
             return true;
         }
 
@@ -67,10 +70,15 @@ namespace jucyaudio
                     return false; // No more rows
                 }
                 if (rc == SQLITE_ROW)
+                {
+                    // Counted here rather than with a trace callback per row, which would cost on every read
+                    if (m_rowCount)
+                        ++*m_rowCount;
                     return true;
+                }
 
                 m_done = true;
-                return m_db.formatError(__LINE__, rc, "SqliteStatement::get_next_result({}) failed", m_statement_text);
+                return m_db.formatError(m_connection->handle, __LINE__, rc, "SqliteStatement::get_next_result({}) failed", m_statement_text);
             }
         }
 
@@ -79,7 +87,7 @@ namespace jucyaudio
             const int rc = sqlite3_bind_null(m_statement, m_param_index++);
             if (rc)
             {
-                return m_db.raiseError(__LINE__, rc, "sqlite3_bind_null() failed");
+                return m_db.raiseError(m_connection->handle, __LINE__, rc, "sqlite3_bind_null() failed");
             }
             return true;
         }
@@ -89,20 +97,30 @@ namespace jucyaudio
             const int rc = sqlite3_bind_blob(m_statement, m_param_index++, &blob[0], (int)blob.size(), SQLITE_STATIC);
             if (rc)
             {
-                return m_db.raiseError(__LINE__, rc, "sqlite3_bind_blob() failed");
+                return m_db.raiseError(m_connection->handle, __LINE__, rc, "sqlite3_bind_blob() failed");
             }
             return true;
         }
 
         bool SqliteStatement::addParam(std::string_view text)
         {
-            m_copy_of_string_args.push_back(std::string{text});
-            const auto &item{m_copy_of_string_args.back()};
+            // SQLite copies into its own memory, from its lookaside pool for short text
+            const int rc = sqlite3_bind_text(m_statement, m_param_index++, text.data(), (int)text.length(), SQLITE_TRANSIENT);
+            if (rc)
+            {
+                return m_db.formatError(m_connection->handle, __LINE__, rc, "sqlite3_bind_text({}) failed", text);
+            }
+            return true;
+        }
 
-            const int rc = sqlite3_bind_text(m_statement, m_param_index++, item.c_str(), (int)item.length(), nullptr);
+        bool SqliteStatement::addBorrowedParam(std::string_view text)
+        {
+            // SQLITE_STATIC makes no copy at all. The bindings are cleared before the statement goes back to the cache,
+            // so it never holds on to the caller's text beyond this SqliteStatement.
+            const int rc = sqlite3_bind_text(m_statement, m_param_index++, text.data(), (int)text.length(), SQLITE_STATIC);
             if (rc)
             {
-                return m_db.formatError(__LINE__, rc, "sqlite3_bind_text({}) failed", item);
+                return m_db.formatError(m_connection->handle, __LINE__, rc, "sqlite3_bind_text({}) failed", text);
             }
             return true;
         }
@@ -112,7 +130,7 @@ namespace jucyaudio
             const int rc = sqlite3_bind_int64(m_statement, m_param_index++, value);
             if (rc)
             {
-                return m_db.formatError(__LINE__, rc, "sqlite3_bind_int64({}) failed", value);
+                return m_db.formatError(m_connection->handle, __LINE__, rc, "sqlite3_bind_int64({}) failed", value);
             }
             return true;
         }
@@ -122,7 +140,7 @@ namespace jucyaudio
             const int rc = sqlite3_bind_int(m_statement, m_param_index++, value);
             if (rc)
             {
-                return m_db.formatError(__LINE__, rc, "sqlite3_bind_int({}) failed", value);
+                return m_db.formatError(m_connection->handle, __LINE__, rc, "sqlite3_bind_int({}) failed", value);
             }
             return true;
         }
@@ -132,7 +150,7 @@ namespace jucyaudio
             const int rc = sqlite3_bind_double(m_statement, m_param_index++, value);
             if (rc)
             {
-                return m_db.formatError(__LINE__, rc, "sqlite3_bind_int({}) failed", value);
+                return m_db.formatError(m_connection->handle, __LINE__, rc, "sqlite3_bind_int({}) failed", value);
             }
             return true;
         }
@@ -142,7 +160,7 @@ namespace jucyaudio
             const int rc = sqlite3_bind_null(m_statement, m_param_index++);
             if (rc)
             {
-                return m_db.raiseError(__LINE__, rc, "sqlite3_bind_null() failed");
+                return m_db.raiseError(m_connection->handle, __LINE__, rc, "sqlite3_bind_null() failed");
             }
             return true;
         }
@@ -150,11 +168,7 @@ namespace jucyaudio
         
         std::string SqliteStatement::getText(int index) const
         {
-            auto p = reinterpret_cast<const char *>(sqlite3_column_text(m_statement, index));
-            if (p)
-                return std::string{p};
-
-            return {};
+            return std::string{getTextView(index)};
         }
 
         std::vector<unsigned char> SqliteStatement::getBlob(int index) const
@@ -186,7 +200,7 @@ namespace jucyaudio
                     m_done = true;
                     return true;
                 }
-                return m_db.formatError(__LINE__, rc, "SqliteStatement::execute({}) failed", m_statement_text);
+                return m_db.formatError(m_connection->handle, __LINE__, rc, "SqliteStatement::execute({}) failed", m_statement_text);
             }
         }
 
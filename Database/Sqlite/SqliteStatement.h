@@ -2,7 +2,6 @@
 
 #include <string>
 #include <string_view>
-#include <list>
 #include <Database/Sqlite/SqliteDatabase.h>
 #include <Database/Includes/Constants.h>
 #include <spdlog/spdlog.h>
@@ -24,10 +23,11 @@ namespace jucyaudio
 
             ~SqliteStatement()
             {
-                if (m_statement)
+                if (m_connection)
                 {
-                    sqlite3_finalize(m_statement);
+                    m_db.returnStatement(*m_connection, m_statement_text, m_statement);
                     m_statement = nullptr;
+                    m_db.releaseConnection(*m_connection);
                 }
             }
 
@@ -36,9 +36,16 @@ namespace jucyaudio
             /// @param statement 
             bool bindStatement(std::string_view statement);
 
+            /// @brief Rewinds the statement and drops its parameters, so it can be run again with new ones
+            bool reset();
+
         public:
             bool addNullParam();
+            /// @brief Binds a copy of the text (made by SQLite), so temporaries are fine
             bool addParam(std::string_view text);
+            /// @brief Binds the text without copying it. The caller keeps it alive and unchanged until the statement
+            /// has run to the end, is reset or is destroyed: meant for fields of an object that outlives the statement.
+            bool addBorrowedParam(std::string_view text);
             bool addParam(int64_t value);
             bool addParam(int32_t value);
             bool addParam(nullptr_t parameter1);
@@ -86,6 +93,15 @@ namespace jucyaudio
 
             std::string getText(int index) const;
 
+            /// @brief The column's text without copying it; empty for NULL. Points into the statement's current row, so
+            /// it is only valid until the next step, reset or destruction: copy what has to outlive the row.
+            std::string_view getTextView(int index) const
+            {
+                const auto p = reinterpret_cast<const char *>(sqlite3_column_text(m_statement, index));
+                // Bytes only after the text conversion, which may have changed them
+                return p ? std::string_view{p, static_cast<size_t>(sqlite3_column_bytes(m_statement, index))} : std::string_view{};
+            }
+
             std::vector<unsigned char> getBlob(int index) const;
 
             size_t getNumberOfColumns() const
@@ -125,13 +141,10 @@ namespace jucyaudio
                 return true;
             }
         private:
-            /// <summary>
-            /// Note: we are using a list, so that the pointers do not change
-            /// </summary>
-            std::list<std::string> m_copy_of_string_args;
-            std::lock_guard<std::recursive_mutex> m_lock;
             SqliteDatabase &m_db;
+            SqliteDatabase::Connection *m_connection{nullptr}; // locked from bindStatement() until destruction
             sqlite3_stmt *m_statement;
+            int64_t *m_rowCount{nullptr}; // the query profiler's count of this run's rows
             int m_param_index;
             std::string m_statement_text;
             bool m_done;
@@ -2,33 +2,68 @@
 #include <Database/Includes/Constants.h>
 #include <Database/Sqlite/SqliteStatementConstruction.h>
 #include <Utils/AssortedUtils.h>
+#include <algorithm>
+#include <cctype>
 #include <spdlog/spdlog.h>
 
 namespace jucyaudio
 {
     namespace database
     {
+        namespace
+        {
+            // Text sorts case-insensitively, matching the NOCASE indexes on the text columns. Anything else compares as
+            // stored: a collation on a numeric column would keep SQLite from using its index.
+            bool isTextSort(const SortOrderInfo &order)
+            {
+                return order.typeHint == ColumnDataTypeHint::String;
+            }
+
+            bool hasTrackIdSort(const TrackQueryArgs &trackQueryArgs)
+            {
+                return std::any_of(trackQueryArgs.sortBy.begin(), trackQueryArgs.sortBy.end(),
+                                   [](const SortOrderInfo &order)
+                                   {
+                                       return order.columnName == "track_id";
+                                   });
+            }
+        } // namespace
 
-        void SqliteStatementConstruction::addWhereClause(StringWriter &writer, const TrackQueryArgs &trackQueryArgs)
+        std::string SqliteStatementConstruction::toFullTextQuery(const std::vector<std::string> &searchTerms)
         {
-            bool bWhereAdded = false;
-            for (const auto &searchTerm : trackQueryArgs.searchTerms)
+            std::string query;
+            for (const auto &searchTerm : searchTerms)
             {
-                if (!searchTerm.empty())
+                const bool hasWord = std::any_of(searchTerm.begin(), searchTerm.end(),
+                                                 [](char c)
+                                                 {
+                                                     return (static_cast<unsigned char>(c) & 0x80) || std::isalnum(static_cast<unsigned char>(c));
+                                                 });
+                if (!hasWord)
+                    continue;
+
+                if (!query.empty())
+                    query.push_back(' ');
+                query.push_back('"');
+                for (const char c : searchTerm)
                 {
-                    if (!bWhereAdded)
-                    {
-                        writer.append(" WHERE (");
-                        bWhereAdded = true;
-                    }
-                    else
-                    {
-                        writer.append(" AND (");
-                    }
-                    writer.appendFormatted("title LIKE ?{} OR artist_name LIKE ?{} OR album_title LIKE ?{} OR filepath LIKE ?{})",
-                                            m_searchTermIndex, m_searchTermIndex, m_searchTermIndex, m_searchTermIndex, m_searchTermIndex);
-                    ++m_searchTermIndex;
+                    if (c == '"')
+                        query.push_back('"');
+                    query.push_back(c);
                 }
+                query.append("\"*");
+            }
+            return query;
+        }
+
+        bool SqliteStatementConstruction::addWhereClause(StringWriter &writer, const TrackQueryArgs &trackQueryArgs)
+        {
+            bool bWhereAdded = false;
+            if (!toFullTextQuery(trackQueryArgs.searchTerms).empty())
+            {
+                writer.appendFormatted(" WHERE track_id IN (SELECT rowid FROM TrackSearch WHERE TrackSearch MATCH ?{})", m_searchTermIndex);
+                ++m_searchTermIndex;
+                bWhereAdded = true;
             }
             if (trackQueryArgs.pathFilter.has_value())
             {
@@ -72,6 +107,7 @@ namespace jucyaudio
                 writer.appendFormatted("track_id IN (SELECT track_id FROM MixTracks WHERE mix_id = ?{})", m_searchTermIndex);
                 ++m_searchTermIndex;
             }
+            return bWhereAdded;
         }
 
         void SqliteStatementConstruction::addOrderByClause(StringWriter &writer, const TrackQueryArgs &trackQueryArgs)
@@ -89,14 +125,18 @@ namespace jucyaudio
                     writer.append(", ");
                 }
                 writer.append(orderCriterion.columnName);
-                if (orderCriterion.descending)
-                {
-                    writer.append(" COLLATE NOCASE DESC");
-                }
-                else
+                if (isTextSort(orderCriterion))
                 {
-                    writer.append(" COLLATE NOCASE ASC");
+                    writer.append(" COLLATE NOCASE");
                 }
+                writer.append(orderCriterion.descending ? " DESC" : " ASC");
+            }
+            // Rows that tie on the sort columns still need a fixed order, or pages could overlap
+            if (!hasTrackIdSort(trackQueryArgs))
+            {
+                const bool descending = bOrderByAdded && trackQueryArgs.sortBy.back().descending;
+                writer.append(bOrderByAdded ? ", track_id" : " ORDER BY track_id");
+                writer.append(descending ? " DESC" : " ASC");
             }
         }
 
@@ -116,12 +156,9 @@ namespace jucyaudio
             {
                 m_stmt.addParam(wsId); // Bind each search term with wildcards
             }
-            for (const auto &searchTerm : trackQueryArgs.searchTerms)
+            if (const auto fullTextQuery = toFullTextQuery(trackQueryArgs.searchTerms); !fullTextQuery.empty())
             {
-                if (!searchTerm.empty())
-                {
-                    m_stmt.addParam("%" + searchTerm + "%"); // Bind each search term with wildcards
-                }
+                m_stmt.addParam(fullTextQuery);
             }
             if (trackQueryArgs.pathFilter.has_value())
             {
@@ -138,11 +175,11 @@ namespace jucyaudio
             return true;
         }
 
-        bool SqliteStatementConstruction::createSelectStatement(const TrackQueryArgs &trackQueryArgs)
+        bool SqliteStatementConstruction::createSelectStatement(const TrackQueryArgs &trackQueryArgs, std::string_view columnList)
         {
             m_searchTermIndex = 1;
             StringWriter writer;
-            writer.append("SELECT * FROM Tracks");
+            writer.appendFormatted("{}SELECT {} FROM Tracks", m_bExplain ? "EXPLAIN QUERY PLAN " : "", columnList);
             addWhereClause(writer, trackQueryArgs);
             addOrderByClause(writer, trackQueryArgs);
             if (trackQueryArgs.usePaging)
@@ -152,6 +189,14 @@ namespace jucyaudio
             return finalizeStatement(writer, trackQueryArgs);
         }
 
+        bool SqliteStatementConstruction::createExplainSelectStatement(const TrackQueryArgs &trackQueryArgs, std::string_view columnList)
+        {
+            m_bExplain = true;
+            bool result = createSelectStatement(trackQueryArgs, columnList);
+            m_bExplain = false;
+            return result;
+        }
+
         bool SqliteStatementConstruction::createInsertIntoSelectTrackIdsStatement(const TrackQueryArgs &trackQueryArgs, WorkingSetId wsId)
         {
             m_searchTermIndex = 1;
@@ -162,6 +207,19 @@ namespace jucyaudio
             return finalizeStatement(writer, trackQueryArgs, wsId);
         }
 
+        bool SqliteStatementConstruction::createSelectTrackIdsNeedingAnalysisStatement(const TrackQueryArgs &trackQueryArgs)
+        {
+            m_searchTermIndex = 1;
+            StringWriter writer;
+            writer.append("SELECT track_id FROM Tracks");
+            const bool bWhereAdded = addWhereClause(writer, trackQueryArgs);
+            // The ORDER BY has to be on the outermost SELECT: SQLite keeps no subquery's order
+            writer.append(bWhereAdded ? " AND " : " WHERE ");
+            writer.append("(bpm IS NULL OR bpm <= 0) AND is_missing = 0");
+            addOrderByClause(writer, trackQueryArgs);
+            return finalizeStatement(writer, trackQueryArgs);
+        }
+
         bool SqliteStatementConstruction::createCountStatement(const TrackQueryArgs &trackQueryArgs)
         {
             m_searchTermIndex = 1;
@@ -21,14 +21,24 @@ namespace jucyaudio
             }
 
             bool createCountStatement(const TrackQueryArgs &trackQueryArgs);
-            bool createSelectStatement(const TrackQueryArgs &trackQueryArgs);
+            /// @param columnList comma-separated columns to select; must only hold known column names
+            bool createSelectStatement(const TrackQueryArgs &trackQueryArgs, std::string_view columnList = "*");
+            /// @brief EXPLAIN QUERY PLAN of createSelectStatement()'s statement, with the same parameters bound, as the
+            /// plan can depend on them (a LIKE prefix, for one)
+            bool createExplainSelectStatement(const TrackQueryArgs &trackQueryArgs, std::string_view columnList = "*");
             bool createInsertIntoSelectTrackIdsStatement(const TrackQueryArgs &trackQueryArgs, WorkingSetId wsId);
+            bool createSelectTrackIdsNeedingAnalysisStatement(const TrackQueryArgs &trackQueryArgs);
+
+            /// @brief FTS5 query matching rows that have a word starting with each term, e.g. "beat"* "caf"*. Quoting
+            /// makes every term a literal; terms without letters or digits would match nothing and are left out.
+            static std::string toFullTextQuery(const std::vector<std::string> &searchTerms);
 
         private:
             SqliteStatement &m_stmt;
             int m_searchTermIndex = 1;
+            bool m_bExplain{false};
 
-            void addWhereClause(StringWriter &writer, const TrackQueryArgs &trackQueryArgs);
+            bool addWhereClause(StringWriter &writer, const TrackQueryArgs &trackQueryArgs);
             void addOrderByClause(StringWriter &writer, const TrackQueryArgs &trackQueryArgs);
             bool finalizeStatement(StringWriter &writer, const TrackQueryArgs &trackQueryArgs, WorkingSetId wsId = 0);
         };
@@ -0,0 +1,496 @@
+#include <Database/Sqlite/SqliteStatement.h>
+#include <Database/Sqlite/SqliteStatementConstruction.h>
+#include <Database/Sqlite/SqliteTrackColumnIndex.h>
+#include <Utils/AssortedUtils.h>
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+#include <spdlog/spdlog.h>
+
+namespace jucyaudio
+{
+    namespace database
+    {
+        namespace
+        {
+            // The sortable Tracks columns (see SqliteStatementConstruction), each kept in a text or number slot
+            struct IndexedColumn
+            {
+                std::string_view name;
+                bool isText;
+                size_t slot;
+            };
+
+            constexpr IndexedColumn IndexedColumns[] = {
+                {"title", true, 0},        {"artist_name", true, 1}, {"album_title", true, 2}, {"filepath", true, 3},
+                {"duration", false, 0},    {"bpm", false, 1},        {"intro_end", false, 2},  {"outro_start", false, 3},
+                {"rating", false, 4},      {"last_modified_fs", false, 5},
+            };
+            constexpr size_t TEXT_COLUMN_COUNT = 4;
+            constexpr size_t NUMBER_COLUMN_COUNT = 6;
+            constexpr size_t FILEPATH_SLOT = 3;
+            constexpr int TRACK_ID_COLUMN = static_cast<int>(std::size(IndexedColumns));
+
+            // track_id, then the indexed columns in table order
+            std::string selectColumns()
+            {
+                std::string columnList{"track_id"};
+                for (const auto &column : IndexedColumns)
+                {
+                    columnList.append(", ");
+                    columnList.append(column.name);
+                }
+                return columnList;
+            }
+
+            int findIndexedColumn(std::string_view name)
+            {
+                if (name == "track_id")
+                    return TRACK_ID_COLUMN;
+                const auto it = std::find_if(std::begin(IndexedColumns), std::end(IndexedColumns),
+                                             [name](const IndexedColumn &column)
+                                             {
+                                                 return column.name == name;
+                                             });
+                return it == std::end(IndexedColumns) ? -1 : static_cast<int>(it - std::begin(IndexedColumns));
+            }
+
+            unsigned char foldAscii(unsigned char c)
+            {
+                return (c >= 'A' && c <= 'Z') ? static_cast<unsigned char>(c - 'A' + 'a') : c;
+            }
+
+            // SQLite's NOCASE: bytes compared with ASCII letters folded, a prefix before the longer string
+            bool noCaseLess(const std::string &a, const std::string &b)
+            {
+                return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(),
+                                                    [](char x, char y)
+                                                    {
+                                                        return foldAscii(static_cast<unsigned char>(x)) < foldAscii(static_cast<unsigned char>(y));
+                                                    });
+            }
+
+            // value LIKE 'pattern%' as SQLite evaluates it: ASCII letters match either case, _ matches one UTF-8
+            // character. The pattern has no % of its own.
+            bool matchesLikePrefix(std::string_view value, std::string_view pattern)
+            {
+                size_t pos = 0;
+                for (const char p : pattern)
+                {
+                    if (pos >= value.size())
+                        return false;
+                    if (p == '_')
+                    {
+                        ++pos;
+                        while (pos < value.size() && (static_cast<unsigned char>(value[pos]) & 0xC0) == 0x80)
+                            ++pos;
+                    }
+                    else if (foldAscii(static_cast<unsigned char>(value[pos++])) != foldAscii(static_cast<unsigned char>(p)))
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            }
+        } // namespace
+
+        uint32_t SqliteTrackColumnIndex::TextColumn::encode(std::string_view value)
+        {
+            if (const auto it = codeOf.find(value); it != codeOf.end())
+                return it->second;
+            const auto code = static_cast<uint32_t>(values.size());
+            values.emplace_back(value);
+            codeOf.emplace(value, code);
+            bRanksValid = false;
+            return code;
+        }
+
+        SqliteTrackColumnIndex::SqliteTrackColumnIndex(SqliteDatabase &db)
+            : m_db{db},
+              m_columns{createColumns()}
+        {
+        }
+
+        SqliteTrackColumnIndex::~SqliteTrackColumnIndex()
+        {
+            stop();
+        }
+
+        SqliteTrackColumnIndex::Columns SqliteTrackColumnIndex::createColumns()
+        {
+            Columns columns;
+            columns.text.resize(TEXT_COLUMN_COUNT);
+            columns.numbers.resize(NUMBER_COLUMN_COUNT);
+            columns.permutations.resize(std::size(IndexedColumns) + 1);
+            return columns;
+        }
+
+        void SqliteTrackColumnIndex::start()
+        {
+            if (m_bStarted)
+                return;
+            m_bStarted = true;
+
+            // Watch first: whatever is committed while the load runs is reread on top of it
+            m_db.watchTableChanges("Tracks",
+                                   [this](const std::vector<int64_t> &rowIds)
+                                   {
+                                       const std::lock_guard<std::mutex> lock{m_changedMutex};
+                                       m_changedTrackIds.insert(rowIds.begin(), rowIds.end());
+                                   });
+            m_loadCancel = CancellationToken{};
+            m_loadDone = theTaskExecutor.submit(
+                TaskLane::Io, TaskPriority::Normal,
+                [this, cancel = m_loadCancel]()
+                {
+                    loadAll(cancel);
+                },
+                m_loadCancel);
+        }
+
+        void SqliteTrackColumnIndex::stop()
+        {
+            if (!m_bStarted)
+                return;
+            m_db.watchTableChanges({}, nullptr);
+            m_loadCancel.cancel();
+            if (m_loadDone.valid())
+                m_loadDone.wait();
+            {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                m_columns = createColumns();
+                m_bLoaded = false;
+            }
+            {
+                const std::lock_guard<std::mutex> lock{m_changedMutex};
+                m_changedTrackIds.clear();
+            }
+            m_bStarted = false;
+        }
+
+        void SqliteTrackColumnIndex::loadAll(const CancellationToken &cancel)
+        {
+            const auto startTime = std::chrono::steady_clock::now();
+            Columns columns = createColumns();
+            SqliteStatement stmt{m_db, "SELECT " + selectColumns() + " FROM Tracks;"};
+            while (stmt.getNextResult())
+            {
+                if (cancel.isCancelled())
+                    return;
+                readRow(columns, stmt);
+            }
+
+            const std::lock_guard<std::mutex> lock{m_mutex};
+            m_columns = std::move(columns);
+            m_bLoaded = true;
+            spdlog::info("Column index loaded {} tracks in {} ms", m_columns.trackIds.size(),
+                         std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count());
+        }
+
+        bool SqliteTrackColumnIndex::readRow(Columns &columns, const SqliteStatement &stmt)
+        {
+            const TrackId trackId = stmt.getInt64(0);
+            Row row;
+            bool bNewRow = false;
+            if (const auto it = columns.rowOf.find(trackId); it != columns.rowOf.end())
+            {
+                row = it->second;
+            }
+            else
+            {
+                row = static_cast<Row>(columns.trackIds.size());
+                columns.trackIds.push_back(trackId);
+                columns.rowOf.emplace(trackId, row);
+                for (auto &text : columns.text)
+                    text.codes.push_back(0);
+                for (auto &numbers : columns.numbers)
+                    numbers.push_back(NULL_KEY);
+                bNewRow = true;
+            }
+
+            for (size_t i = 0; i < std::size(IndexedColumns); ++i)
+            {
+                const auto &column = IndexedColumns[i];
+                const int col = static_cast<int>(i) + 1;
+                bool bChanged;
+                if (column.isText)
+                {
+                    auto &text = columns.text[column.slot];
+                    const uint32_t code = stmt.isNull(col) ? 0 : text.encode(stmt.getTextView(col));
+                    bChanged = text.codes[row] != code;
+                    text.codes[row] = code;
+                }
+                else
+                {
+                    const int64_t value = stmt.isNull(col) ? NULL_KEY : stmt.getInt64(col);
+                    bChanged = columns.numbers[column.slot][row] != value;
+                    columns.numbers[column.slot][row] = value;
+                }
+                if (bChanged)
+                    columns.permutations[i].bValid = false;
+            }
+            if (bNewRow)
+            {
+                for (auto &permutation : columns.permutations)
+                    permutation.bValid = false;
+            }
+            return bNewRow;
+        }
+
+        void SqliteTrackColumnIndex::markDeleted(Columns &columns, TrackId trackId)
+        {
+            // The row stays, masked out of every query, so the permutations stay valid
+            if (const auto it = columns.rowOf.find(trackId); it != columns.rowOf.end())
+            {
+                columns.trackIds[it->second] = -1;
+                columns.rowOf.erase(it);
+            }
+        }
+
+        bool SqliteTrackColumnIndex::applyChanges() const
+        {
+            std::vector<TrackId> changed;
+            {
+                // Holding the writer means no commit is half done, so what was reported can be read back as committed
+                std::unique_lock<std::recursive_mutex> writerLock{m_db.getMutex(), std::try_to_lock};
+                const std::lock_guard<std::mutex> lock{m_changedMutex};
+                if (m_changedTrackIds.empty())
+                    return true;
+                if (!writerLock.owns_lock())
+                    return false;
+                changed.assign(m_changedTrackIds.begin(), m_changedTrackIds.end());
+                m_changedTrackIds.clear();
+            }
+
+            std::string trackIds{"["};
+            for (const auto trackId : changed)
+            {
+                if (trackIds.size() > 1)
+                    trackIds.push_back(',');
+                trackIds.append(std::to_string(trackId));
+            }
+            trackIds.push_back(']');
+
+            SqliteStatement stmt{m_db, "SELECT " + selectColumns() + " FROM Tracks WHERE track_id IN (SELECT value FROM json_each(?));"};
+            if (!stmt.isValid())
+            {
+                const std::lock_guard<std::mutex> lock{m_changedMutex};
+                m_changedTrackIds.insert(changed.begin(), changed.end());
+                return false;
+            }
+            stmt.addParam(trackIds);
+
+            std::unordered_set<TrackId> found;
+            while (stmt.getNextResult())
+            {
+                readRow(m_columns, stmt);
+                found.insert(stmt.getInt64(0));
+            }
+            for (const auto trackId : changed)
+            {
+                if (!found.contains(trackId))
+                    markDeleted(m_columns, trackId);
+            }
+            return true;
+        }
+
+        bool SqliteTrackColumnIndex::filterByMembership(const std::string &sql, std::string_view parameter, int64_t id, std::vector<uint8_t> &mask) const
+        {
+            SqliteStatement stmt{m_db, sql};
+            if (!stmt.isValid())
+                return false;
+            if (parameter.empty())
+                stmt.addParam(id);
+            else
+                stmt.addParam(parameter);
+
+            std::vector<uint8_t> members(mask.size(), 0);
+            while (stmt.getNextResult())
+            {
+                if (const auto it = m_columns.rowOf.find(stmt.getInt64(0)); it != m_columns.rowOf.end())
+                    members[it->second] = 1;
+            }
+            for (size_t row = 0; row < mask.size(); ++row)
+                mask[row] &= members[row];
+            return true;
+        }
+
+        bool SqliteTrackColumnIndex::filterByPath(const std::filesystem::path &path, std::vector<uint8_t> &mask) const
+        {
+            // The SQL binds the path with a trailing %, so a % in the path itself matches anything; leave that to SQL
+            const std::string pattern{pathToString(path)};
+            if (pattern.find('%') != std::string::npos)
+                return false;
+
+            // Once per distinct path, then per row by its code
+            const auto &text = m_columns.text[FILEPATH_SLOT];
+            std::vector<uint8_t> valueMatches(text.values.size(), 0);
+            for (size_t code = 1; code < text.values.size(); ++code)
+                valueMatches[code] = matchesLikePrefix(text.values[code], pattern) ? 1 : 0;
+            for (size_t row = 0; row < mask.size(); ++row)
+                mask[row] &= valueMatches[text.codes[row]];
+            return true;
+        }
+
+        std::optional<SqliteTrackColumnIndex::Query> SqliteTrackColumnIndex::prepareQuery(const TrackQueryArgs &args) const
+        {
+            Query query;
+            for (const auto &order : args.sortBy)
+            {
+                const int column = findIndexedColumn(order.columnName);
+                if (column < 0)
+                    return std::nullopt;
+                // The SQL only compares text case-insensitively for String columns
+                if (column != TRACK_ID_COLUMN && IndexedColumns[column].isText && order.typeHint != ColumnDataTypeHint::String)
+                    return std::nullopt;
+                query.sortBy.push_back(&order);
+                query.sortColumns.push_back(column);
+            }
+
+            const auto &trackIds = m_columns.trackIds;
+            query.mask.resize(trackIds.size());
+            for (size_t row = 0; row < trackIds.size(); ++row)
+                query.mask[row] = trackIds[row] >= 0;
+
+            if (const auto fullTextQuery = SqliteStatementConstruction::toFullTextQuery(args.searchTerms); !fullTextQuery.empty())
+            {
+                if (!filterByMembership("SELECT rowid FROM TrackSearch WHERE TrackSearch MATCH ?;", fullTextQuery, 0, query.mask))
+                    return std::nullopt;
+            }
+            if (args.pathFilter.has_value() && !filterByPath(*args.pathFilter, query.mask))
+                return std::nullopt;
+            if (args.workingSetId && !filterByMembership("SELECT track_id FROM WorkingSetTracks WHERE ws_id = ?;", {}, args.workingSetId, query.mask))
+                return std::nullopt;
+            if (args.mixId && !filterByMembership("SELECT track_id FROM MixTracks WHERE mix_id = ?;", {}, args.mixId, query.mask))
+                return std::nullopt;
+            return query;
+        }
+
+        const std::vector<int64_t> &SqliteTrackColumnIndex::ranksOf(int column) const
+        {
+            auto &text = m_columns.text[IndexedColumns[column].slot];
+            if (!text.bRanksValid)
+            {
+                std::vector<uint32_t> codes(text.values.size() - 1);
+                std::iota(codes.begin(), codes.end(), 1);
+                std::sort(codes.begin(), codes.end(),
+                          [&text](uint32_t a, uint32_t b)
+                          {
+                              return noCaseLess(text.values[a], text.values[b]);
+                          });
+                text.ranks.assign(text.values.size(), 0); // NULL ranks first
+                int64_t rank = 0;
+                for (size_t i = 0; i < codes.size(); ++i)
+                {
+                    if (i == 0 || noCaseLess(text.values[codes[i - 1]], text.values[codes[i]]))
+                        ++rank;
+                    text.ranks[codes[i]] = rank;
+                }
+                text.bRanksValid = true;
+            }
+            return text.ranks;
+        }
+
+        std::vector<int64_t> SqliteTrackColumnIndex::sortKeys(int column) const
+        {
+            if (column == TRACK_ID_COLUMN)
+                return {m_columns.trackIds.begin(), m_columns.trackIds.end()};
+            const auto &indexed = IndexedColumns[column];
+            if (!indexed.isText)
+                return m_columns.numbers[indexed.slot];
+
+            const auto &ranks = ranksOf(column);
+            const auto &codes = m_columns.text[indexed.slot].codes;
+            std::vector<int64_t> keys(codes.size());
+            for (size_t row = 0; row < codes.size(); ++row)
+                keys[row] = ranks[codes[row]];
+            return keys;
+        }
+
+        const std::vector<SqliteTrackColumnIndex::Row> &SqliteTrackColumnIndex::permutationFor(int column) const
+        {
+            auto &permutation = m_columns.permutations[column];
+            if (!permutation.bValid)
+            {
+                const auto keys = sortKeys(column);
+                const auto &trackIds = m_columns.trackIds;
+                permutation.rows.resize(trackIds.size());
+                std::iota(permutation.rows.begin(), permutation.rows.end(), Row{0});
+                std::sort(permutation.rows.begin(), permutation.rows.end(),
+                          [&keys, &trackIds](Row a, Row b)
+                          {
+                              return keys[a] != keys[b] ? keys[a] < keys[b] : trackIds[a] < trackIds[b];
+                          });
+                permutation.bValid = true;
+            }
+            return permutation.rows;
+        }
+
+        std::optional<std::vector<TrackId>> SqliteTrackColumnIndex::getTrackIds(const TrackQueryArgs &args) const
+        {
+            const std::lock_guard<std::mutex> lock{m_mutex};
+            if (!m_bLoaded || !applyChanges())
+                return std::nullopt;
+            const auto query = prepareQuery(args);
+            if (!query)
+                return std::nullopt;
+
+            const auto &trackIds = m_columns.trackIds;
+            const auto &mask = query->mask;
+            std::vector<TrackId> results;
+            if (query->sortBy.size() <= 1)
+            {
+                // One column: walk its permutation, backwards for descending order
+                const auto &rows = permutationFor(query->sortBy.empty() ? TRACK_ID_COLUMN : query->sortColumns.front());
+                const auto emit = [&](Row row)
+                {
+                    if (mask[row])
+                        results.push_back(trackIds[row]);
+                };
+                if (!query->sortBy.empty() && query->sortBy.front()->descending)
+                    std::for_each(rows.rbegin(), rows.rend(), emit);
+                else
+                    std::for_each(rows.begin(), rows.end(), emit);
+                return results;
+            }
+
+            // Several columns: sort the matching rows by all of them, ties broken by track id as the SQL does
+            std::vector<Row> rows;
+            for (size_t row = 0; row < mask.size(); ++row)
+            {
+                if (mask[row])
+                    rows.push_back(static_cast<Row>(row));
+            }
+            std::vector<std::vector<int64_t>> keys;
+            for (const int column : query->sortColumns)
+                keys.push_back(sortKeys(column));
+            const bool bTrackIdsDescending = query->sortBy.back()->descending;
+            std::sort(rows.begin(), rows.end(),
+                      [&](Row a, Row b)
+                      {
+                          for (size_t i = 0; i < keys.size(); ++i)
+                          {
+                              if (keys[i][a] != keys[i][b])
+                                  return query->sortBy[i]->descending ? keys[i][a] > keys[i][b] : keys[i][a] < keys[i][b];
+                          }
+                          return bTrackIdsDescending ? trackIds[a] > trackIds[b] : trackIds[a] < trackIds[b];
+                      });
+            results.reserve(rows.size());
+            for (const Row row : rows)
+                results.push_back(trackIds[row]);
+            return results;
+        }
+
+        std::optional<int64_t> SqliteTrackColumnIndex::getTrackCount(const TrackQueryArgs &args) const
+        {
+            const std::lock_guard<std::mutex> lock{m_mutex};
+            if (!m_bLoaded || !applyChanges())
+                return std::nullopt;
+            const auto query = prepareQuery(args);
+            if (!query)
+                return std::nullopt;
+            return std::accumulate(query->mask.begin(), query->mask.end(), int64_t{0});
+        }
+
+    } // namespace database
+} // namespace jucyaudio
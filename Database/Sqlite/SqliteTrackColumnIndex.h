@@ -0,0 +1,140 @@
+#pragma once
+
+#include <Database/Includes/Constants.h>
+#include <Database/Includes/TrackQueryArgs.h>
+#include <Database/Sqlite/SqliteDatabase.h>
+#include <Database/Sqlite/SqliteStatement.h>
+#include <Utils/TaskExecutor.h>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace jucyaudio
+{
+    namespace database
+    {
+        /// @brief In-memory, column-wise copy of the Tracks columns the list views filter and sort by.
+        ///
+        /// Each column is a plain array indexed by row; text columns are dictionary encoded, with every distinct value
+        /// ranked in NOCASE order, so all of them sort as integers. A sort permutation per column is kept until one of
+        /// its values changes, and a query is a filter pass over the arrays followed by a walk over the permutation, so
+        /// sorting and filtering a large library takes milliseconds instead of a SQL sort.
+        ///
+        /// The copy is loaded in the background when started and kept current from the writer's commits to Tracks:
+        /// changed rows are reread before the next query. Until then, and for queries it cannot answer exactly like
+        /// the SQL would, the methods return nothing and the caller asks SQLite instead.
+        class SqliteTrackColumnIndex final
+        {
+        public:
+            explicit SqliteTrackColumnIndex(SqliteDatabase &db);
+            ~SqliteTrackColumnIndex();
+
+            SqliteTrackColumnIndex(const SqliteTrackColumnIndex &) = delete;
+            SqliteTrackColumnIndex &operator=(const SqliteTrackColumnIndex &) = delete;
+
+            /// @brief Starts watching Tracks and loads it on an I/O worker. The database must be open.
+            void start();
+            /// @brief Stops watching and drops the copy; waits for a load in progress to give up
+            void stop();
+
+            bool isStarted() const
+            {
+                return m_bStarted;
+            }
+
+            /// @brief Track ids of the query's rows in its order, as getTrackIds() on the database returns them
+            std::optional<std::vector<TrackId>> getTrackIds(const TrackQueryArgs &args) const;
+            /// @brief Number of rows the query has
+            std::optional<int64_t> getTrackCount(const TrackQueryArgs &args) const;
+
+        private:
+            typedef uint32_t Row;
+            static constexpr int64_t NULL_KEY = INT64_MIN; // sorts first, as SQLite sorts NULL
+
+            // Distinct values of a text column; code 0 is NULL. Ranks order the codes case-insensitively, equal under
+            // NOCASE giving equal ranks, and are recomputed once a new value came in.
+            struct TextColumn
+            {
+                // Lets codeOf be searched with a view of the row's text, so only a new value is copied
+                struct Hash
+                {
+                    using is_transparent = void;
+                    size_t operator()(std::string_view value) const
+                    {
+                        return std::hash<std::string_view>{}(value);
+                    }
+                };
+
+                std::vector<uint32_t> codes; // per row
+                std::vector<std::string> values{std::string{}};
+                std::unordered_map<std::string, uint32_t, Hash, std::equal_to<>> codeOf;
+                std::vector<int64_t> ranks;
+                bool bRanksValid{false};
+
+                uint32_t encode(std::string_view value);
+            };
+
+            // A sort permutation: every row, by the column ascending, then by track id ascending. Read backwards it is
+            // the descending order with track ids descending, which is what the SQL breaks ties with.
+            struct Permutation
+            {
+                std::vector<Row> rows;
+                bool bValid{false};
+            };
+
+            struct Columns
+            {
+                std::vector<TrackId> trackIds; // per row; -1 for rows deleted since loading
+                std::unordered_map<TrackId, Row> rowOf;
+                std::vector<TextColumn> text;
+                std::vector<std::vector<int64_t>> numbers;
+                std::vector<Permutation> permutations; // per indexed column, then one for track_id
+            };
+
+            struct Query
+            {
+                std::vector<uint8_t> mask; // per row: 1 if the row matches
+                std::vector<const SortOrderInfo *> sortBy;
+                std::vector<int> sortColumns; // index into IndexedColumns, or TRACK_ID_COLUMN
+            };
+
+            static Columns createColumns();
+            static bool readRow(Columns &columns, const SqliteStatement &stmt);
+            static void markDeleted(Columns &columns, TrackId trackId);
+
+            // Rereads the rows changed since the last call; false if that is not possible right now
+            bool applyChanges() const;
+            std::optional<Query> prepareQuery(const TrackQueryArgs &args) const;
+            bool filterByMembership(const std::string &sql, std::string_view parameter, int64_t id, std::vector<uint8_t> &mask) const;
+            bool filterByPath(const std::filesystem::path &path, std::vector<uint8_t> &mask) const;
+            const std::vector<int64_t> &ranksOf(int column) const;
+            std::vector<int64_t> sortKeys(int column) const;
+            const std::vector<Row> &permutationFor(int column) const;
+            void loadAll(const CancellationToken &cancel);
+
+            SqliteDatabase &m_db;
+            std::atomic<bool> m_bStarted{false};
+            CancellationToken m_loadCancel;
+            std::future<void> m_loadDone;
+
+            // The copy; queries sort and rank lazily, so all of it is guarded, reads included
+            mutable std::mutex m_mutex;
+            mutable Columns m_columns;
+            mutable bool m_bLoaded{false};
+
+            // Track ids committed since they were last read; filled by the writer
+            mutable std::mutex m_changedMutex;
+            mutable std::unordered_set<TrackId> m_changedTrackIds;
+        };
+
+    } // namespace database
+} // namespace jucyaudio
@@ -6,20 +6,136 @@
 #include <Database/Sqlite/SqliteTransaction.h>
 #include <Utils/AssortedUtils.h>
 #include <Utils/StringWriter.h>
+#include <algorithm>
 #include <cassert> // For assert
+#include <cctype>
+#include <format>
+#include <iterator>
+#include <nlohmann/json.hpp>
 #include <ranges>
 #include <spdlog/spdlog.h>
 
+using json = nlohmann::json;
+
 namespace
 {
     using namespace jucyaudio;
     using namespace database;
 
-    // Array of initial SQL statements for schema creation
-    const char *maintenanceSqlStatements[] = {"PRAGMA optimize;", "VACUUM;"};
+    std::string tempoMapToJson(const std::vector<TempoSegment> &segments)
+    {
+        json j = json::array();
+        for (const auto &segment : segments)
+        {
+            j.push_back(json{{"start_ms", segment.start.count()},
+                             {"end_ms", segment.end.count()},
+                             {"bpm", segment.bpm},
+                             {"confidence", segment.confidence}});
+        }
+        return j.dump();
+    }
+
+    std::vector<TempoSegment> tempoMapFromJson(std::string_view jsonString)
+    {
+        std::vector<TempoSegment> segments;
+        if (jsonString.empty())
+            return segments;
+        const json j = json::parse(jsonString.begin(), jsonString.end(), nullptr, false);
+        if (!j.is_array())
+        {
+            spdlog::warn("Ignoring malformed tempo map: {}", jsonString);
+            return segments;
+        }
+        for (const auto &segmentJson : j)
+        {
+            TempoSegment segment;
+            segment.start = Duration_t{segmentJson.value("start_ms", int64_t{0})};
+            segment.end = Duration_t{segmentJson.value("end_ms", int64_t{0})};
+            segment.bpm = segmentJson.value("bpm", 0.0);
+            segment.confidence = segmentJson.value("confidence", 0.0f);
+            segments.push_back(segment);
+        }
+        return segments;
+    }
+
+    // Rows ANALYZE samples per index: plenty for the query planner, and quick however large the library gets
+    constexpr int ANALYSIS_LIMIT = 1000;
+    // Free pages runMaintenanceTasks() gives back per step; it checks for cancellation in between
+    constexpr int64_t MAINTENANCE_VACUUM_STEP_PAGES = 1024;
+
+    // The keyword in upper case if the pragma takes it, otherwise the default (with a warning)
+    std::string pragmaKeyword(std::string_view pragma, std::string value, std::initializer_list<std::string_view> allowed, std::string_view fallback)
+    {
+        std::ranges::transform(value, value.begin(),
+                               [](unsigned char c)
+                               {
+                                   return static_cast<char>(std::toupper(c));
+                               });
+        if (std::ranges::find(allowed, value) != allowed.end())
+            return value;
+        spdlog::warn("Ignoring {}={}, using {}", pragma, value, fallback);
+        return std::string{fallback};
+    }
+
+    int validPageSize(int pageSize)
+    {
+        // A power of two from 512 to 65536
+        if (pageSize >= 512 && pageSize <= 65536 && (pageSize & (pageSize - 1)) == 0)
+            return pageSize;
+        spdlog::warn("Ignoring page_size={}, using {}", pageSize, StorageTuning{}.pageSize);
+        return StorageTuning{}.pageSize;
+    }
+
+    // The tuning's per-connection settings, which the readers need as well as the writer
+    std::string connectionPragmasFor(const StorageTuning &tuning)
+    {
+        const StorageTuning defaults;
+        const int64_t mmapBytes = int64_t{std::max(tuning.mmapSizeMiB, 0)} * 1024 * 1024;
+        const int cacheKiB = tuning.cacheSizeKiB > 0 ? tuning.cacheSizeKiB : defaults.cacheSizeKiB;
+        return std::format("PRAGMA mmap_size={}; PRAGMA cache_size=-{}; PRAGMA synchronous={}; PRAGMA temp_store={};", mmapBytes, cacheKiB,
+                           pragmaKeyword("synchronous", tuning.synchronous, {"OFF", "NORMAL", "FULL", "EXTRA"}, defaults.synchronous),
+                           pragmaKeyword("temp_store", tuning.tempStore, {"DEFAULT", "FILE", "MEMORY"}, defaults.tempStore));
+    }
+
+    // Link tables are only ever looked up by their key, so they store just that (WITHOUT ROWID) rather than a rowid
+    // table plus a primary key index holding the same columns again. Shared by the schema and the v2 migration.
+    const char *trackTagsDefinition = R"SQL((
+    track_id INTEGER NOT NULL,
+    tag_id INTEGER NOT NULL,
+    PRIMARY KEY (track_id, tag_id),
+    FOREIGN KEY (track_id) REFERENCES Tracks(track_id) ON DELETE CASCADE,
+    FOREIGN KEY (tag_id) REFERENCES Tags(tag_id) ON DELETE CASCADE
+) STRICT, WITHOUT ROWID;)SQL";
+
+    const char *workingSetTracksDefinition = R"SQL((
+    ws_id INTEGER NOT NULL,
+    track_id INTEGER NOT NULL,
+    PRIMARY KEY(ws_id, track_id),
+    FOREIGN KEY(ws_id) REFERENCES WorkingSets(ws_id) ON DELETE CASCADE,
+    FOREIGN KEY(track_id) REFERENCES Tracks(track_id) ON DELETE CASCADE
+) STRICT, WITHOUT ROWID;)SQL";
+
+    const char *mixTracksDefinition = R"SQL((
+    mix_id INTEGER NOT NULL,
+    track_id INTEGER NOT NULL,
+    order_in_mix INTEGER,
+    envelopePoints TEXT, -- JSON encoded envelope points
+    mix_start_time INTEGER,
+    mix_end_time INTEGER,
+    PRIMARY KEY(mix_id, track_id),
+    FOREIGN KEY(mix_id) REFERENCES Mixes(mix_id) ON DELETE CASCADE,
+    FOREIGN KEY(track_id) REFERENCES Tracks(track_id) ON DELETE CASCADE
+) STRICT, WITHOUT ROWID;)SQL";
+
+    const char *schemaInfoSql = R"SQL(
+CREATE TABLE IF NOT EXISTS SchemaInfo (
+    key TEXT PRIMARY KEY,
+    value TEXT
+);)SQL";
 
-    // Array of initial SQL statements for schema creation
-    const char *initialSqlStatements[] = {
+    // The current schema (CURRENT_SCHEMA_VERSION). A new database is created from it directly; on an existing one it
+    // runs after the migrations and only recreates what they dropped (indexes, the search view and triggers).
+    const std::string schemaSqlStatements[] = {
         "PRAGMA foreign_keys = ON;",
         R"SQL(
     CREATE TABLE IF NOT EXISTS Folders (
@@ -62,9 +178,12 @@ CREATE TABLE IF NOT EXISTS Tracks (
     internal_content_hash TEXT,
     user_notes TEXT,
     is_missing INTEGER DEFAULT 0,
+    loudness_lufs REAL,
+    loudness_range REAL,
+    true_peak_db REAL,
+    tempo_map_json TEXT,
     FOREIGN KEY (folder_id) REFERENCES Folders(folder_id) ON DELETE CASCADE
 );)SQL",
-        "CREATE INDEX IF NOT EXISTS idx_tracks_filepath ON Tracks (filepath);",
         "CREATE INDEX IF NOT EXISTS idx_tracks_folder_id ON Tracks (folder_id);",
         "CREATE INDEX IF NOT EXISTS idx_tracks_artist ON Tracks (artist_name "
         "COLLATE NOCASE);",
@@ -76,26 +195,21 @@ CREATE TABLE IF NOT EXISTS Tracks (
         "CREATE INDEX IF NOT EXISTS idx_tracks_rating ON Tracks (rating);",
         "CREATE INDEX IF NOT EXISTS idx_tracks_liked_status ON Tracks "
         "(liked_status);",
+        // The remaining columns the library list sorts by (see LibraryNode), so every list order is an index walk
+        "CREATE INDEX IF NOT EXISTS idx_tracks_filepath_nocase ON Tracks (filepath COLLATE NOCASE);",
+        "CREATE INDEX IF NOT EXISTS idx_tracks_duration ON Tracks (duration);",
+        "CREATE INDEX IF NOT EXISTS idx_tracks_intro_end ON Tracks (intro_end);",
+        "CREATE INDEX IF NOT EXISTS idx_tracks_outro_start ON Tracks (outro_start);",
+        "CREATE INDEX IF NOT EXISTS idx_tracks_last_modified_fs ON Tracks (last_modified_fs);",
         R"SQL(
 CREATE TABLE IF NOT EXISTS Tags (
     tag_id INTEGER PRIMARY KEY AUTOINCREMENT,
     name TEXT NOT NULL UNIQUE COLLATE NOCASE);
 )SQL",
-        R"SQL(
-CREATE TABLE IF NOT EXISTS TrackTags (
-    track_id INTEGER NOT NULL,
-    tag_id INTEGER NOT NULL,
-    PRIMARY KEY (track_id, tag_id),
-    FOREIGN KEY (track_id) REFERENCES Tracks(track_id) ON DELETE CASCADE,
-    FOREIGN KEY (tag_id) REFERENCES Tags(tag_id) ON DELETE CASCADE
-);)SQL",
+        std::string{"CREATE TABLE IF NOT EXISTS TrackTags "} + trackTagsDefinition,
         "CREATE INDEX IF NOT EXISTS idx_tracktags_tag_id ON TrackTags "
         "(tag_id);",
-        R"SQL(
-CREATE TABLE IF NOT EXISTS SchemaInfo (
-    key TEXT PRIMARY KEY,
-    value TEXT
-);)SQL",
+        schemaInfoSql,
 
         R"SQL(
 CREATE TABLE IF NOT EXISTS WorkingSets(
@@ -103,14 +217,7 @@ CREATE TABLE IF NOT EXISTS WorkingSets(
     name  TEXT NOT NULL UNIQUE COLLATE NOCASE,
     timestamp INTEGER);
 )SQL",
-        R"SQL(
-CREATE TABLE IF NOT EXISTS WorkingSetTracks(
-    ws_id INTEGER NOT NULL,
-    track_id INTEGER NOT NULL,
-    PRIMARY KEY(ws_id, track_id),
-    FOREIGN KEY(ws_id) REFERENCES WorkingSets(ws_id) ON DELETE CASCADE,
-    FOREIGN KEY(track_id) REFERENCES Tracks(track_id) ON DELETE CASCADE);
-)SQL",
+        std::string{"CREATE TABLE IF NOT EXISTS WorkingSetTracks "} + workingSetTracksDefinition,
         R"SQL(
 CREATE TABLE IF NOT EXISTS Mixes(
     mix_id INTEGER PRIMARY KEY AUTOINCREMENT,
@@ -120,20 +227,145 @@ CREATE TABLE IF NOT EXISTS Mixes(
     total_length INTEGER
 );)SQL",
 
+        std::string{"CREATE TABLE IF NOT EXISTS MixTracks "} + mixTracksDefinition,
+        // Outstanding background work; lease_until doubles as the retry time of failed attempts (ms since epoch)
         R"SQL(
-CREATE TABLE IF NOT EXISTS MixTracks(
-    mix_id INTEGER NOT NULL,
+CREATE TABLE IF NOT EXISTS Jobs(
+    job_id INTEGER PRIMARY KEY AUTOINCREMENT,
+    type INTEGER NOT NULL,
     track_id INTEGER NOT NULL,
-    order_in_mix INTEGER,
-    envelopePoints TEXT, -- JSON encoded envelope points
-    mix_start_time INTEGER,
-    mix_end_time INTEGER,
-    PRIMARY KEY(mix_id, track_id),
-    FOREIGN KEY(mix_id) REFERENCES Mixes(mix_id) ON DELETE CASCADE,
+    priority INTEGER NOT NULL DEFAULT 0,
+    attempts INTEGER NOT NULL DEFAULT 0,
+    last_error TEXT,
+    lease_until INTEGER NOT NULL DEFAULT 0,
+    failed INTEGER NOT NULL DEFAULT 0,
+    UNIQUE(type, track_id),
     FOREIGN KEY(track_id) REFERENCES Tracks(track_id) ON DELETE CASCADE
 );)SQL",
+        // Matches the lease order, so the next job is the first usable index entry
+        "CREATE INDEX IF NOT EXISTS idx_jobs_next ON Jobs (type, failed, priority DESC, job_id);",
+        // Full-text search. TrackSearch indexes TrackSearchSource without storing a copy of it, so the triggers below keep
+        // it in sync: FTS5 can only remove a row given the exact values it indexed, so each change first removes the row
+        // as it still is (BEFORE) and then adds it back as it has become (AFTER). The unicode61 tokenizer splits file
+        // paths into their components by itself.
+        R"SQL(
+CREATE VIEW IF NOT EXISTS TrackSearchSource AS
+SELECT track_id, title, artist_name, album_title, album_artist_name, filepath,
+    (SELECT group_concat(name, ' ') FROM (SELECT Tags.name FROM TrackTags JOIN Tags ON Tags.tag_id = TrackTags.tag_id
+                                          WHERE TrackTags.track_id = Tracks.track_id ORDER BY Tags.tag_id)) AS tags
+FROM Tracks;)SQL",
+        R"SQL(
+CREATE VIRTUAL TABLE IF NOT EXISTS TrackSearch USING fts5(
+    title, artist_name, album_title, album_artist_name, filepath, tags,
+    content='TrackSearchSource', content_rowid='track_id',
+    tokenize='unicode61 remove_diacritics 2', prefix='2 3');)SQL",
+        R"SQL(
+CREATE TRIGGER IF NOT EXISTS trg_tracks_search_insert AFTER INSERT ON Tracks BEGIN
+    INSERT INTO TrackSearch(rowid, title, artist_name, album_title, album_artist_name, filepath, tags)
+    SELECT track_id, title, artist_name, album_title, album_artist_name, filepath, tags FROM TrackSearchSource WHERE track_id = NEW.track_id;
+END;)SQL",
+        R"SQL(
+CREATE TRIGGER IF NOT EXISTS trg_tracks_search_delete BEFORE DELETE ON Tracks BEGIN
+    INSERT INTO TrackSearch(TrackSearch, rowid, title, artist_name, album_title, album_artist_name, filepath, tags)
+    SELECT 'delete', track_id, title, artist_name, album_title, album_artist_name, filepath, tags FROM TrackSearchSource WHERE track_id = OLD.track_id;
+END;)SQL",
+        R"SQL(
+CREATE TRIGGER IF NOT EXISTS trg_tracks_search_update_before BEFORE UPDATE OF title, artist_name, album_title, album_artist_name, filepath ON Tracks BEGIN
+    INSERT INTO TrackSearch(TrackSearch, rowid, title, artist_name, album_title, album_artist_name, filepath, tags)
+    SELECT 'delete', track_id, title, artist_name, album_title, album_artist_name, filepath, tags FROM TrackSearchSource WHERE track_id = OLD.track_id;
+END;)SQL",
+        R"SQL(
+CREATE TRIGGER IF NOT EXISTS trg_tracks_search_update_after AFTER UPDATE OF title, artist_name, album_title, album_artist_name, filepath ON Tracks BEGIN
+    INSERT INTO TrackSearch(rowid, title, artist_name, album_title, album_artist_name, filepath, tags)
+    SELECT track_id, title, artist_name, album_title, album_artist_name, filepath, tags FROM TrackSearchSource WHERE track_id = NEW.track_id;
+END;)SQL",
+        R"SQL(
+CREATE TRIGGER IF NOT EXISTS trg_tracktags_search_insert_before BEFORE INSERT ON TrackTags BEGIN
+    INSERT INTO TrackSearch(TrackSearch, rowid, title, artist_name, album_title, album_artist_name, filepath, tags)
+    SELECT 'delete', track_id, title, artist_name, album_title, album_artist_name, filepath, tags FROM TrackSearchSource WHERE track_id = NEW.track_id;
+END;)SQL",
+        R"SQL(
+CREATE TRIGGER IF NOT EXISTS trg_tracktags_search_insert_after AFTER INSERT ON TrackTags BEGIN
+    INSERT INTO TrackSearch(rowid, title, artist_name, album_title, album_artist_name, filepath, tags)
+    SELECT track_id, title, artist_name, album_title, album_artist_name, filepath, tags FROM TrackSearchSource WHERE track_id = NEW.track_id;
+END;)SQL",
+        R"SQL(
+CREATE TRIGGER IF NOT EXISTS trg_tracktags_search_delete_before BEFORE DELETE ON TrackTags BEGIN
+    INSERT INTO TrackSearch(TrackSearch, rowid, title, artist_name, album_title, album_artist_name, filepath, tags)
+    SELECT 'delete', track_id, title, artist_name, album_title, album_artist_name, filepath, tags FROM TrackSearchSource WHERE track_id = OLD.track_id;
+END;)SQL",
+        R"SQL(
+CREATE TRIGGER IF NOT EXISTS trg_tracktags_search_delete_after AFTER DELETE ON TrackTags BEGIN
+    INSERT INTO TrackSearch(rowid, title, artist_name, album_title, album_artist_name, filepath, tags)
+    SELECT track_id, title, artist_name, album_title, album_artist_name, filepath, tags FROM TrackSearchSource WHERE track_id = OLD.track_id;
+END;)SQL",
+        R"SQL(
+CREATE TRIGGER IF NOT EXISTS trg_tags_search_rename_before BEFORE UPDATE OF name ON Tags BEGIN
+    INSERT INTO TrackSearch(TrackSearch, rowid, title, artist_name, album_title, album_artist_name, filepath, tags)
+    SELECT 'delete', track_id, title, artist_name, album_title, album_artist_name, filepath, tags FROM TrackSearchSource
+    WHERE track_id IN (SELECT track_id FROM TrackTags WHERE tag_id = OLD.tag_id);
+END;)SQL",
+        R"SQL(
+CREATE TRIGGER IF NOT EXISTS trg_tags_search_rename_after AFTER UPDATE OF name ON Tags BEGIN
+    INSERT INTO TrackSearch(rowid, title, artist_name, album_title, album_artist_name, filepath, tags)
+    SELECT track_id, title, artist_name, album_title, album_artist_name, filepath, tags FROM TrackSearchSource
+    WHERE track_id IN (SELECT track_id FROM TrackTags WHERE tag_id = NEW.tag_id);
+END;)SQL",
+        // The cascade from Tags to TrackTags runs after the tag is gone, when the TrackTags triggers could no longer
+        // reproduce the indexed tag names; removing the links first keeps the tag visible to them
+        R"SQL(
+CREATE TRIGGER IF NOT EXISTS trg_tags_search_delete BEFORE DELETE ON Tags BEGIN
+    DELETE FROM TrackTags WHERE tag_id = OLD.tag_id;
+END;)SQL",
+        // A counter bumped by every change a track list could show: tracks coming or going, the columns lists display,
+        // sort or search by, tags, and working set and mix contents. Result sets read at one version are current for
+        // as long as it stays put.
+        "CREATE TABLE IF NOT EXISTS DataVersion (version INTEGER NOT NULL);",
+        "INSERT INTO DataVersion (version) SELECT 0 WHERE NOT EXISTS (SELECT 1 FROM DataVersion);",
+        "CREATE TRIGGER IF NOT EXISTS trg_tracks_version_insert AFTER INSERT ON Tracks"
+        " BEGIN UPDATE DataVersion SET version = version + 1; END;",
+        "CREATE TRIGGER IF NOT EXISTS trg_tracks_version_delete AFTER DELETE ON Tracks"
+        " BEGIN UPDATE DataVersion SET version = version + 1; END;",
+        "CREATE TRIGGER IF NOT EXISTS trg_tracks_version_update AFTER UPDATE OF title, artist_name, album_title, album_artist_name, filepath, duration, bpm, intro_end, outro_start,"
+        " last_modified_fs, rating, is_missing ON Tracks"
+        " BEGIN UPDATE DataVersion SET version = version + 1; END;",
+        "CREATE TRIGGER IF NOT EXISTS trg_tracktags_version_insert AFTER INSERT ON TrackTags"
+        " BEGIN UPDATE DataVersion SET version = version + 1; END;",
+        "CREATE TRIGGER IF NOT EXISTS trg_tracktags_version_delete AFTER DELETE ON TrackTags"
+        " BEGIN UPDATE DataVersion SET version = version + 1; END;",
+        "CREATE TRIGGER IF NOT EXISTS trg_tags_version_rename AFTER UPDATE OF name ON Tags"
+        " BEGIN UPDATE DataVersion SET version = version + 1; END;",
+        "CREATE TRIGGER IF NOT EXISTS trg_workingsettracks_version_insert AFTER INSERT ON WorkingSetTracks"
+        " BEGIN UPDATE DataVersion SET version = version + 1; END;",
+        "CREATE TRIGGER IF NOT EXISTS trg_workingsettracks_version_delete AFTER DELETE ON WorkingSetTracks"
+        " BEGIN UPDATE DataVersion SET version = version + 1; END;",
+        "CREATE TRIGGER IF NOT EXISTS trg_mixtracks_version_insert AFTER INSERT ON MixTracks"
+        " BEGIN UPDATE DataVersion SET version = version + 1; END;",
+        "CREATE TRIGGER IF NOT EXISTS trg_mixtracks_version_update AFTER UPDATE ON MixTracks"
+        " BEGIN UPDATE DataVersion SET version = version + 1; END;",
+        "CREATE TRIGGER IF NOT EXISTS trg_mixtracks_version_delete AFTER DELETE ON MixTracks"
+        " BEGIN UPDATE DataVersion SET version = version + 1; END;",
+    };
+
+    // A v1 link table and what goes into its v2 replacement, in the column order of the definition
+    struct RebuiltTable
+    {
+        const char *name;
+        const char *definition;
+        const char *copyColumns;
+    };
+
+    const RebuiltTable v2RebuiltTables[] = {
+        {"TrackTags", trackTagsDefinition, "track_id, tag_id"},
+        {"WorkingSetTracks", workingSetTracksDefinition, "ws_id, track_id"},
+        {"MixTracks", mixTracksDefinition,
+         "mix_id, track_id, CAST(order_in_mix AS INTEGER), CAST(envelopePoints AS TEXT), CAST(mix_start_time AS INTEGER), "
+         "CAST(mix_end_time AS INTEGER)"},
     };
 
+    // Rows copied per transaction while migrating, so a large library moves in short steps
+    constexpr int64_t MIGRATION_BATCH_ROWS = 20000;
+
     TrackInfo trackInfoFromStatement(const SqliteStatement &stmt)
     {
         TrackInfo info{};
@@ -141,23 +373,23 @@ CREATE TABLE IF NOT EXISTS MixTracks(
         info.trackId = stmt.getInt64(col++);
         info.folderId = stmt.getInt64(col++);
         if (!stmt.isNull(col))
-            info.filepath = pathFromString(stmt.getText(col));
+            info.filepath = pathFromString(stmt.getTextView(col));
         col++;
         info.last_modified_fs = timestampFromInt64(stmt.getInt64(col++));
         info.filesize_bytes = static_cast<std::uintmax_t>(stmt.getInt64(col++));
         info.date_added = timestampFromInt64(stmt.getInt64(col++));
         info.last_scanned = timestampFromInt64(stmt.getInt64(col++));
         if (!stmt.isNull(col))
-            info.title = stmt.getText(col);
+            info.title = stmt.getTextView(col);
         col++;
         if (!stmt.isNull(col))
-            info.artist_name = stmt.getText(col);
+            info.artist_name = stmt.getTextView(col);
         col++;
         if (!stmt.isNull(col))
-            info.album_title = stmt.getText(col);
+            info.album_title = stmt.getTextView(col);
         col++;
         if (!stmt.isNull(col))
-            info.album_artist_name = stmt.getText(col);
+            info.album_artist_name = stmt.getTextView(col);
         col++;
         info.track_number = stmt.getInt32(col++);
         info.disc_number = stmt.getInt32(col++);
@@ -167,7 +399,7 @@ CREATE TABLE IF NOT EXISTS MixTracks(
         info.channels = stmt.getInt32(col++);
         info.bitrate = stmt.getInt32(col++);
         if (!stmt.isNull(col))
-            info.codec_name = stmt.getText(col);
+            info.codec_name = stmt.getTextView(col);
         ++col;
         if (stmt.isNull(col))
             info.bpm = std::nullopt;
@@ -185,62 +417,328 @@ CREATE TABLE IF NOT EXISTS MixTracks(
             info.outro_start = durationFromInt64(stmt.getInt64(col));
         ++col;
         if (!stmt.isNull(col))
-            info.key_string = stmt.getText(col);
+            info.key_string = stmt.getTextView(col);
         col++;
         if (!stmt.isNull(col))
-            info.beat_locations_json = stmt.getText(col);
+            info.beat_locations_json = stmt.getTextView(col);
         col++;
         info.rating = stmt.getInt32(col++);
         info.liked_status = stmt.getInt32(col++);
         info.play_count = stmt.getInt32(col++);
         info.last_played = timestampFromInt64(stmt.getInt64(col++));
         if (!stmt.isNull(col))
-            info.internal_content_hash = stmt.getText(col);
+            info.internal_content_hash = stmt.getTextView(col);
         col++;
         if (!stmt.isNull(col))
-            info.user_notes = stmt.getText(col);
+            info.user_notes = stmt.getTextView(col);
         col++;
         info.is_missing = stmt.getInt32(col++) != 0;
+        if (!stmt.isNull(col))
+            info.loudness_lufs = stmt.getFloat(col);
+        ++col;
+        if (!stmt.isNull(col))
+            info.loudness_range = stmt.getFloat(col);
+        ++col;
+        if (!stmt.isNull(col))
+            info.true_peak_db = stmt.getFloat(col);
+        ++col;
+        if (!stmt.isNull(col))
+            info.tempo_map = tempoMapFromJson(stmt.getTextView(col));
+        ++col;
+        info.changedFields = 0; // matches the database
         return info;
     }
 
-    bool bindTrackInfoToStatement(SqliteStatement &stmt, const TrackInfo &info, bool forUpdate = false)
+    // Columns getTrackRowsById() can project, with where each goes in the row. Doubles as the whitelist for the column
+    // names that end up in the SQL.
+    struct TrackRowColumn
+    {
+        std::string_view sqlId;
+        void (*read)(const SqliteStatement &stmt, int col, TrackListRow &row);
+    };
+
+    const TrackRowColumn TrackRowColumns[] = {
+        {"filepath",
+         [](const SqliteStatement &stmt, int col, TrackListRow &row)
+         {
+             row.filepath = pathFromString(stmt.getTextView(col));
+         }},
+        {"last_modified_fs",
+         [](const SqliteStatement &stmt, int col, TrackListRow &row)
+         {
+             row.last_modified_fs = timestampFromInt64(stmt.getInt64(col));
+         }},
+        {"title",
+         [](const SqliteStatement &stmt, int col, TrackListRow &row)
+         {
+             row.title = stmt.getTextView(col);
+         }},
+        {"artist_name",
+         [](const SqliteStatement &stmt, int col, TrackListRow &row)
+         {
+             row.artist_name = stmt.getTextView(col);
+         }},
+        {"album_title",
+         [](const SqliteStatement &stmt, int col, TrackListRow &row)
+         {
+             row.album_title = stmt.getTextView(col);
+         }},
+        {"duration",
+         [](const SqliteStatement &stmt, int col, TrackListRow &row)
+         {
+             row.duration = durationFromInt64(stmt.getInt64(col));
+         }},
+        {"bpm",
+         [](const SqliteStatement &stmt, int col, TrackListRow &row)
+         {
+             row.bpm = stmt.getInt32(col);
+         }},
+        {"intro_end",
+         [](const SqliteStatement &stmt, int col, TrackListRow &row)
+         {
+             row.intro_end = durationFromInt64(stmt.getInt64(col));
+         }},
+        {"outro_start",
+         [](const SqliteStatement &stmt, int col, TrackListRow &row)
+         {
+             row.outro_start = durationFromInt64(stmt.getInt64(col));
+         }},
+    };
+
+    // Picks the whitelisted columns asked for (all of them if none are), each once and in whitelist order, and appends
+    // them to columnList
+    std::vector<const TrackRowColumn *> projectTrackRowColumns(const std::vector<std::string> &columns, std::string &columnList)
+    {
+        std::vector<const TrackRowColumn *> projection;
+        for (const auto &column : TrackRowColumns)
+        {
+            if (columns.empty() || std::find(columns.begin(), columns.end(), column.sqlId) != columns.end())
+            {
+                projection.push_back(&column);
+                columnList.append(", ");
+                columnList.append(column.sqlId);
+            }
+        }
+        return projection;
+    }
+
+    // Reads the projected columns, selected after the track id in column 0
+    void readTrackRow(const SqliteStatement &stmt, const std::vector<const TrackRowColumn *> &projection, TrackListRow &row)
+    {
+        for (int col = 1; col <= static_cast<int>(projection.size()); ++col)
+        {
+            if (!stmt.isNull(col))
+                projection[col - 1]->read(stmt, col, row);
+        }
+    }
+
+    // Ids as a JSON array, to bind a whole list as one parameter and read it back with json_each()
+    std::string toJsonArray(const std::vector<database::TrackId> &trackIds)
+    {
+        std::string json{"["};
+        for (const auto trackId : trackIds)
+        {
+            if (json.size() > 1)
+                json.push_back(',');
+            json.append(std::to_string(trackId));
+        }
+        json.push_back(']');
+        return json;
+    }
+
+    // The stored columns of Tracks in INSERT order, with the TrackInfo field each one holds. Text fields are bound
+    // borrowed: the TrackInfo outlives the statement in every caller of bindTrackInfoToStatement(); converted values
+    // are temporaries and bound as copies.
+    struct StoredTrackColumn
+    {
+        const char *name;
+        TrackField field;
+        bool (*bind)(SqliteStatement &stmt, const TrackInfo &info);
+    };
+
+    const StoredTrackColumn StoredTrackColumns[] = {
+        {"folder_id", TrackField::FolderId,
+         [](SqliteStatement &stmt, const TrackInfo &info)
+         {
+             return stmt.addParam(info.folderId);
+         }},
+        {"filepath", TrackField::Filepath,
+         [](SqliteStatement &stmt, const TrackInfo &info)
+         {
+             return stmt.addParam(pathToString(info.filepath));
+         }},
+        {"last_modified_fs", TrackField::LastModifiedFs,
+         [](SqliteStatement &stmt, const TrackInfo &info)
+         {
+             return stmt.addParam(timestampToInt64(info.last_modified_fs));
+         }},
+        {"filesize_bytes", TrackField::FilesizeBytes,
+         [](SqliteStatement &stmt, const TrackInfo &info)
+         {
+             return stmt.addParam(static_cast<int64_t>(info.filesize_bytes));
+         }},
+        {"date_added", TrackField::DateAdded,
+         [](SqliteStatement &stmt, const TrackInfo &info)
+         {
+             return stmt.addParam(timestampToInt64(info.date_added));
+         }},
+        {"last_scanned", TrackField::LastScanned,
+         [](SqliteStatement &stmt, const TrackInfo &info)
+         {
+             return stmt.addParam(timestampToInt64(info.last_scanned));
+         }},
+        {"title", TrackField::Title,
+         [](SqliteStatement &stmt, const TrackInfo &info)
+         {
+             return stmt.addBorrowedParam(info.title);
+         }},
+        {"artist_name", TrackField::ArtistName,
+         [](SqliteStatement &stmt, const TrackInfo &info)
+         {
+             return stmt.addBorrowedParam(info.artist_name);
+         }},
+        {"album_title", TrackField::AlbumTitle,
+         [](SqliteStatement &stmt, const TrackInfo &info)
+         {
+             return stmt.addBorrowedParam(info.album_title);
+         }},
+        {"album_artist_name", TrackField::AlbumArtistName,
+         [](SqliteStatement &stmt, const TrackInfo &info)
+         {
+             return stmt.addBorrowedParam(info.album_artist_name);
+         }},
+        {"track_number", TrackField::TrackNumber,
+         [](SqliteStatement &stmt, const TrackInfo &info)
+         {
+             return stmt.addParam(info.track_number);
+         }},
+        {"disc_number", TrackField::DiscNumber,
+         [](SqliteStatement &stmt, const TrackInfo &info)
+         {
+             return stmt.addParam(info.disc_number);
+         }},
+        {"year", TrackField::Year,
+         [](SqliteStatement &stmt, const TrackInfo &info)
+         {
+             return stmt.addParam(info.year);
+         }},
+        {"duration", TrackField::Duration,
+         [](SqliteStatement &stmt, const TrackInfo &info)
+         {
+             return stmt.addParam(durationToInt64(info.duration));
+         }},
+        {"samplerate", TrackField::Samplerate,
+         [](SqliteStatement &stmt, const TrackInfo &info)
+         {
+             return stmt.addParam(info.samplerate);
+         }},
+        {"channels", TrackField::Channels,
+         [](SqliteStatement &stmt, const TrackInfo &info)
+         {
+             return stmt.addParam(info.channels);
+         }},
+        {"bitrate", TrackField::Bitrate,
+         [](SqliteStatement &stmt, const TrackInfo &info)
+         {
+             return stmt.addParam(info.bitrate);
+         }},
+        {"codec_name", TrackField::CodecName,
+         [](SqliteStatement &stmt, const TrackInfo &info)
+         {
+             return stmt.addBorrowedParam(info.codec_name);
+         }},
+        {"bpm", TrackField::Bpm,
+         [](SqliteStatement &stmt, const TrackInfo &info)
+         {
+             return info.bpm.has_value() ? stmt.addParam((int64_t)info.bpm.value()) : stmt.addNullParam();
+         }},
+        {"intro_end", TrackField::IntroEnd,
+         [](SqliteStatement &stmt, const TrackInfo &info)
+         {
+             return info.intro_end.has_value() ? stmt.addParam(durationToInt64(info.intro_end.value())) : stmt.addNullParam();
+         }},
+        {"outro_start", TrackField::OutroStart,
+         [](SqliteStatement &stmt, const TrackInfo &info)
+         {
+             return info.outro_start.has_value() ? stmt.addParam(durationToInt64(info.outro_start.value())) : stmt.addNullParam();
+         }},
+        {"key_string", TrackField::KeyString,
+         [](SqliteStatement &stmt, const TrackInfo &info)
+         {
+             return stmt.addBorrowedParam(info.key_string);
+         }},
+        {"beat_locations_json", TrackField::BeatLocationsJson,
+         [](SqliteStatement &stmt, const TrackInfo &info)
+         {
+             return stmt.addBorrowedParam(info.beat_locations_json);
+         }},
+        {"rating", TrackField::Rating,
+         [](SqliteStatement &stmt, const TrackInfo &info)
+         {
+             return stmt.addParam(info.rating);
+         }},
+        {"liked_status", TrackField::LikedStatus,
+         [](SqliteStatement &stmt, const TrackInfo &info)
+         {
+             return stmt.addParam(info.liked_status);
+         }},
+        {"play_count", TrackField::PlayCount,
+         [](SqliteStatement &stmt, const TrackInfo &info)
+         {
+             return stmt.addParam(info.play_count);
+         }},
+        {"last_played", TrackField::LastPlayed,
+         [](SqliteStatement &stmt, const TrackInfo &info)
+         {
+             return stmt.addParam(timestampToInt64(info.last_played));
+         }},
+        {"internal_content_hash", TrackField::InternalContentHash,
+         [](SqliteStatement &stmt, const TrackInfo &info)
+         {
+             return stmt.addBorrowedParam(info.internal_content_hash);
+         }},
+        {"user_notes", TrackField::UserNotes,
+         [](SqliteStatement &stmt, const TrackInfo &info)
+         {
+             return stmt.addBorrowedParam(info.user_notes);
+         }},
+        {"is_missing", TrackField::IsMissing,
+         [](SqliteStatement &stmt, const TrackInfo &info)
+         {
+             return stmt.addParam(info.is_missing ? 1 : 0);
+         }},
+        {"loudness_lufs", TrackField::LoudnessLufs,
+         [](SqliteStatement &stmt, const TrackInfo &info)
+         {
+             return info.loudness_lufs.has_value() ? stmt.addParam(info.loudness_lufs.value()) : stmt.addNullParam();
+         }},
+        {"loudness_range", TrackField::LoudnessRange,
+         [](SqliteStatement &stmt, const TrackInfo &info)
+         {
+             return info.loudness_range.has_value() ? stmt.addParam(info.loudness_range.value()) : stmt.addNullParam();
+         }},
+        {"true_peak_db", TrackField::TruePeakDb,
+         [](SqliteStatement &stmt, const TrackInfo &info)
+         {
+             return info.true_peak_db.has_value() ? stmt.addParam(info.true_peak_db.value()) : stmt.addNullParam();
+         }},
+        {"tempo_map_json", TrackField::TempoMap,
+         [](SqliteStatement &stmt, const TrackInfo &info)
+         {
+             return info.tempo_map.empty() ? stmt.addNullParam() : stmt.addParam(tempoMapToJson(info.tempo_map));
+         }},
+    };
+
+    // Binds the columns of the given fields, in StoredTrackColumns order
+    bool bindTrackInfoToStatement(SqliteStatement &stmt, const TrackInfo &info, TrackFields fields = ALL_TRACK_FIELDS)
     {
         bool ok = true;
-        ok &= stmt.addParam(info.folderId);
-        ok &= stmt.addParam(pathToString(info.filepath));
-        ok &= stmt.addParam(timestampToInt64(info.last_modified_fs));
-        ok &= stmt.addParam(static_cast<int64_t>(info.filesize_bytes));
-        ok &= stmt.addParam(timestampToInt64(info.date_added));
-        ok &= stmt.addParam(timestampToInt64(info.last_scanned));
-        ok &= stmt.addParam(info.title);
-        ok &= stmt.addParam(info.artist_name);
-        ok &= stmt.addParam(info.album_title);
-        ok &= stmt.addParam(info.album_artist_name);
-        ok &= stmt.addParam(info.track_number);
-        ok &= stmt.addParam(info.disc_number);
-        ok &= stmt.addParam(info.year);
-        ok &= stmt.addParam(durationToInt64(info.duration));
-        ok &= stmt.addParam(info.samplerate);
-        ok &= stmt.addParam(info.channels);
-        ok &= stmt.addParam(info.bitrate);
-        ok &= stmt.addParam(info.codec_name);
-        ok &= info.bpm.has_value() ? stmt.addParam((int64_t)info.bpm.value()) : stmt.addNullParam();
-        ok &= info.intro_end.has_value() ? stmt.addParam(durationToInt64(info.intro_end.value())) : stmt.addNullParam();
-        ok &= info.outro_start.has_value() ? stmt.addParam(durationToInt64(info.outro_start.value())) : stmt.addNullParam();
-        ok &= stmt.addParam(info.key_string);
-        ok &= stmt.addParam(info.beat_locations_json);
-        ok &= stmt.addParam(info.rating);
-        ok &= stmt.addParam(info.liked_status);
-        ok &= stmt.addParam(info.play_count);
-        ok &= stmt.addParam(timestampToInt64(info.last_played));
-        ok &= stmt.addParam(info.internal_content_hash);
-        ok &= stmt.addParam(info.user_notes);
-        ok &= stmt.addParam(info.is_missing ? 1 : 0);
-
-        if (forUpdate)
-        {
-            ok &= stmt.addParam(info.trackId); // For the WHERE track_id = ?
+        for (const auto &column : StoredTrackColumns)
+        {
+            if (fields & static_cast<TrackFields>(column.field))
+            {
+                ok &= column.bind(stmt, info);
+            }
         }
         if (!ok)
         {
@@ -249,6 +747,26 @@ CREATE TABLE IF NOT EXISTS MixTracks(
         return ok;
     }
 
+    // "UPDATE Tracks SET a=?, b=? WHERE track_id = ?;" for the given fields
+    std::string buildTrackUpdateSql(TrackFields fields)
+    {
+        std::string sql{"UPDATE Tracks SET "};
+        bool first = true;
+        for (const auto &column : StoredTrackColumns)
+        {
+            if (fields & static_cast<TrackFields>(column.field))
+            {
+                if (!first)
+                    sql += ", ";
+                sql += column.name;
+                sql += "=?";
+                first = false;
+            }
+        }
+        sql += " WHERE track_id = ?;";
+        return sql;
+    }
+
 } // anonymous namespace
 
 namespace jucyaudio
@@ -262,6 +780,8 @@ namespace jucyaudio
               m_mixManager{m_db},
               m_workingSetManager{m_db},
               m_folderDatabase{m_db},
+              m_jobQueue{m_db},
+              m_columnIndex{m_db},
               m_databaseFilePath{},
               m_lastErrorMessage{},
               m_cachedTotalTrackCount{0},
@@ -320,6 +840,18 @@ namespace jucyaudio
             return m_workingSetManager;
         }
 
+        IJobQueue &SqliteTrackDatabase::getJobQueue()
+        {
+            assert(isOpen() && "Cannot get job queue when database is not open");
+            return m_jobQueue;
+        }
+
+        const IJobQueue &SqliteTrackDatabase::getJobQueue() const
+        {
+            assert(isOpen() && "Cannot get job queue when database is not open");
+            return m_jobQueue;
+        }
+
         std::string SqliteTrackDatabase::getLastError() const
         {
             return m_db.isValid() ? m_db.getLastError() : m_lastErrorMessage; // Prefer m_db's error if open
@@ -336,11 +868,40 @@ namespace jucyaudio
             {
                 spdlog::info("Closing SQLite database: {}", pathToString(m_databaseFilePath));
             }
+            m_columnIndex.stop();
             m_db.close();
             m_databaseFilePath.clear(); // Clear path only if close was
                                         // intentional by this class
         }
 
+        void SqliteTrackDatabase::setColumnIndexEnabled(bool enabled)
+        {
+            if (enabled && isOpen())
+                m_columnIndex.start();
+            else if (!enabled)
+                m_columnIndex.stop();
+        }
+
+        void SqliteTrackDatabase::setQueryProfiling(bool enabled, std::chrono::milliseconds slowQueryThreshold)
+        {
+            m_db.setQueryProfiling(enabled, slowQueryThreshold);
+        }
+
+        std::vector<QueryStats> SqliteTrackDatabase::getQueryStats() const
+        {
+            return m_db.getQueryProfiler().getStats();
+        }
+
+        void SqliteTrackDatabase::resetQueryStats()
+        {
+            m_db.getQueryProfiler().reset();
+        }
+
+        void SqliteTrackDatabase::setStorageTuning(const StorageTuning &tuning)
+        {
+            m_storageTuning = tuning;
+        }
+
         DbResult SqliteTrackDatabase::connect(const std::filesystem::path &databaseFilePath)
         {
             if (isOpen())
@@ -376,10 +937,30 @@ namespace jucyaudio
             }
             spdlog::info("SQLite database opened: {}", pathToString(databaseFilePath));
 
+            // Page size and auto-vacuum only take effect for a new database (existing ones are converted to incremental
+            // auto-vacuum by runMaintenanceTasks()), and there only before the first table is created
+            if (!m_db.execute(std::format("PRAGMA page_size={};", validPageSize(m_storageTuning.pageSize))))
+            {
+                spdlog::warn("Failed to set the page size (continuing). Error: {}", m_db.getLastError());
+            }
+            if (!m_db.execute("PRAGMA auto_vacuum=INCREMENTAL;"))
+            {
+                spdlog::warn("Failed to set incremental auto-vacuum (continuing). Error: {}", m_db.getLastError());
+            }
             if (!m_db.execute("PRAGMA journal_mode=WAL;"))
             {
                 spdlog::warn("Failed to set WAL mode (continuing). Error: {}", m_db.getLastError());
             }
+            if (!m_db.execute(std::format("PRAGMA wal_autocheckpoint={};", std::max(m_storageTuning.walAutoCheckpointPages, 0))))
+            {
+                spdlog::warn("Failed to set the WAL checkpoint size (continuing). Error: {}", m_db.getLastError());
+            }
+            const auto connectionPragmas = connectionPragmasFor(m_storageTuning);
+            if (!m_db.setConnectionPragmas(connectionPragmas))
+            {
+                spdlog::warn("Failed to apply storage settings (continuing). Error: {}", m_db.getLastError());
+            }
+            spdlog::info("SQLite storage settings: {}", connectionPragmas);
             if (!m_db.execute("PRAGMA foreign_keys=ON;"))
             {
                 m_lastErrorMessage = "Failed to enable foreign keys: " + m_db.getLastError();
@@ -396,24 +977,95 @@ namespace jucyaudio
             return DbResult::success();
         }
 
-        bool SqliteTrackDatabase::runMaintenanceTasks([[maybe_unused]] std::atomic<bool> &shouldCancel)
+        DatabaseSpaceReport SqliteTrackDatabase::getSpaceReport() const
+        {
+            DatabaseSpaceReport report;
+            if (!isOpen())
+                return report;
+            const auto readPragma = [this](const char *sql) -> int64_t
+            {
+                SqliteStatement stmt{m_db, sql};
+                return stmt.getNextResult() ? stmt.getInt64(0) : 0;
+            };
+            report.pageSize = readPragma("PRAGMA page_size;");
+            report.pageCount = readPragma("PRAGMA page_count;");
+            report.freePages = readPragma("PRAGMA freelist_count;");
+            report.incrementalVacuum = readPragma("PRAGMA auto_vacuum;") == 2; // 2 is INCREMENTAL
+            return report;
+        }
+
+        int64_t SqliteTrackDatabase::incrementalVacuum(int64_t maxPages)
+        {
+            if (!isOpen())
+                return -1;
+            const auto freeBefore = getSpaceReport().freePages;
+            if (!m_db.execute(std::format("PRAGMA incremental_vacuum({});", maxPages)))
+            {
+                m_lastErrorMessage = "Incremental vacuum failed: " + m_db.getLastError();
+                return -1;
+            }
+            return freeBefore - getSpaceReport().freePages;
+        }
+
+        bool SqliteTrackDatabase::optimizeStatistics()
+        {
+            if (!isOpen())
+                return false;
+            if (!m_db.execute(std::format("PRAGMA analysis_limit={}; PRAGMA optimize;", ANALYSIS_LIMIT)))
+            {
+                m_lastErrorMessage = "Updating statistics failed: " + m_db.getLastError();
+                return false;
+            }
+            return true;
+        }
+
+        bool SqliteTrackDatabase::runMaintenanceTasks(std::atomic<bool> &shouldCancel)
         {
             if (!isOpen())
             {
-                spdlog::error("DB not open for schema creation.");
+                spdlog::error("DB not open for maintenance.");
                 return false;
             }
-            for (const auto *sql : maintenanceSqlStatements)
+            const auto before = getSpaceReport();
+            spdlog::info("Database maintenance: {} of {} pages free ({:.1f}%)", before.freePages, before.pageCount, before.freeRatio() * 100.0);
+
+            if (!before.incrementalVacuum)
             {
-                if (!m_db.execute(sql))
+                // An existing database only switches to incremental auto-vacuum by being rebuilt, so this one VACUUM
+                // remains; from then on free pages are given back in steps, here and by the background maintenance
+                spdlog::info("Database maintenance: converting to incremental auto-vacuum");
+                if (!m_db.execute("PRAGMA auto_vacuum=INCREMENTAL;") || !m_db.execute("VACUUM;", &shouldCancel))
                 {
-                    m_lastErrorMessage = "Maintenance statement failed [" + std::string(sql) + "] Error: " + m_db.getLastError();
-                    spdlog::error("Maintenance task failed: {}", m_lastErrorMessage);
+                    if (!shouldCancel)
+                        m_lastErrorMessage = "VACUUM failed: " + m_db.getLastError();
                     return false;
                 }
             }
-            spdlog::info("Database schema verified/created successfully.");
-            return true;
+            else
+            {
+                while (!shouldCancel)
+                {
+                    const auto released = incrementalVacuum(MAINTENANCE_VACUUM_STEP_PAGES);
+                    if (released < 0)
+                        return false;
+                    if (released == 0)
+                        break;
+                }
+            }
+
+            if (!shouldCancel && !m_db.execute(std::format("PRAGMA analysis_limit={}; ANALYZE;", ANALYSIS_LIMIT), &shouldCancel))
+            {
+                if (!shouldCancel)
+                {
+                    m_lastErrorMessage = "ANALYZE failed: " + m_db.getLastError();
+                    return false;
+                }
+            }
+
+            const auto after = getSpaceReport();
+            spdlog::info("Database maintenance {}: {} of {} pages free ({:.1f}%)", shouldCancel ? "cancelled" : "done", after.freePages, after.pageCount,
+                         after.freeRatio() * 100.0);
+            return !shouldCancel;
         }
 
         DbResult SqliteTrackDatabase::createTablesIfNeeded()
@@ -424,36 +1076,44 @@ namespace jucyaudio
             }
 
             spdlog::info("Verifying/Creating database schema...");
-            for (const auto *sql : initialSqlStatements)
+            const bool bNewDatabase = !m_db.doesTableExist("Tracks");
+            const bool bNewSearchIndex = !m_db.doesTableExist("TrackSearch");
+            if (!bNewDatabase)
             {
-                if (!m_db.execute(sql))
+                DbResult migrationResult = runMigrations();
+                if (!migrationResult.isOk())
                 {
-                    m_lastErrorMessage = "Schema creation failed on SQL: [" + std::string(sql) + "] Error: " + m_db.getLastError();
-                    return DbResult::failure(DbResultStatus::ErrorDB, m_lastErrorMessage);
+                    return migrationResult;
                 }
             }
-
-            SqliteStatement stmt{m_db, "INSERT OR IGNORE INTO SchemaInfo (key, value) VALUES (?, ?);"};
-            if (!stmt.isValid())
+            for (const auto &sql : schemaSqlStatements)
             {
-                m_lastErrorMessage = "Failed to prepare schema version insert: " + m_db.getLastError();
-                return DbResult::failure(DbResultStatus::ErrorDB, m_lastErrorMessage);
+                if (!m_db.execute(sql))
+                {
+                    m_lastErrorMessage = "Schema creation failed on SQL: [" + sql + "] Error: " + m_db.getLastError();
+                    return DbResult::failure(DbResultStatus::ErrorDB, m_lastErrorMessage);
+                }
             }
-            stmt.addParam("schema_version");
-            stmt.addParam("1"); // Initial schema version
-            if (!stmt.execute())
+            if (bNewSearchIndex)
             {
-                m_lastErrorMessage = "Failed to insert initial schema version: " + m_db.getLastError();
-                return DbResult::failure(DbResultStatus::ErrorDB, m_lastErrorMessage);
+                // Tracks that existed before the search index did
+                spdlog::info("Building the full-text search index...");
+                if (!m_db.execute("INSERT INTO TrackSearch(TrackSearch) VALUES('rebuild');"))
+                {
+                    m_lastErrorMessage = "Failed to build the search index: " + m_db.getLastError();
+                    return DbResult::failure(DbResultStatus::ErrorDB, m_lastErrorMessage);
+                }
             }
-
-            // return runMigrations(); // Call migrations after basic schema is
-            // confirmed For now, assume runMigrations is simple
-            DbResult migrationResult = runMigrations();
-            if (!migrationResult.isOk())
+            if (bNewDatabase)
             {
-                return migrationResult;
+                DbResult versionResult = setDBSchemaVersion(CURRENT_SCHEMA_VERSION);
+                if (!versionResult.isOk())
+                {
+                    m_lastErrorMessage = versionResult.errorMessage;
+                    return versionResult;
+                }
             }
+            m_jobQueue.enqueueUnanalyzedTracks();
 
             spdlog::info("Database schema verified/created successfully.");
             return DbResult::success();
@@ -487,8 +1147,7 @@ namespace jucyaudio
         {
             if (!isOpen())
                 return DbResult::failure(DbResultStatus::ErrorConnection, "Database not open.");
-            SqliteStatement stmt{m_db, "UPDATE SchemaInfo SET value = ? WHERE "
-                                       "key = 'schema_version';"};
+            SqliteStatement stmt{m_db, "INSERT OR REPLACE INTO SchemaInfo (key, value) VALUES ('schema_version', ?);"};
             if (!stmt.isValid())
             {
                 return DbResult::failure(DbResultStatus::ErrorDB, "Prepare failed for setDBSchemaVersion: " + m_db.getLastError());
@@ -503,17 +1162,256 @@ namespace jucyaudio
 
         DbResult SqliteTrackDatabase::runMigrations()
         {
-            // ... (Full implementation from before if needed, or keep as stub)
-            // ...
-            spdlog::debug("Running DB migrations (currently a stub). Current "
-                          "schema version: {}",
-                          getDBSchemaVersion());
-            // Example:
-            // int currentVersion = getDBSchemaVersion();
-            // if (currentVersion < REQUIRED_SCHEMA_VERSION_2) { /* apply v2
-            // changes */ setDBSchemaVersion(2); } if (currentVersion <
-            // REQUIRED_SCHEMA_VERSION_3) { /* apply v3 changes */
-            // setDBSchemaVersion(3); }
+            // Databases from before schema versioning have no version recorded; their layout is v1
+            if (!m_db.execute(schemaInfoSql))
+            {
+                m_lastErrorMessage = "Failed to create SchemaInfo: " + m_db.getLastError();
+                return DbResult::failure(DbResultStatus::ErrorDB, m_lastErrorMessage);
+            }
+            const int version = std::max(getDBSchemaVersion(), 1);
+            spdlog::debug("Running DB migrations. Current schema version: {}", version);
+
+            // Columns added after the initial schema. CREATE TABLE IF NOT EXISTS does not touch existing databases,
+            // so append them here; ALTER TABLE ADD COLUMN places them at the end, matching the CREATE statement order.
+            struct AddedColumn
+            {
+                const char *name;
+                const char *declaration;
+            };
+            static const AddedColumn addedTrackColumns[] = {
+                {"loudness_lufs", "REAL"},
+                {"loudness_range", "REAL"},
+                {"true_peak_db", "REAL"},
+                {"tempo_map_json", "TEXT"},
+            };
+
+            std::vector<std::string> existingColumns;
+            {
+                SqliteStatement stmt{m_db, "PRAGMA table_info(Tracks);"};
+                while (stmt.getNextResult())
+                {
+                    existingColumns.emplace_back(stmt.getText(1));
+                }
+            }
+            for (const auto &column : addedTrackColumns)
+            {
+                if (std::find(existingColumns.begin(), existingColumns.end(), column.name) != existingColumns.end())
+                    continue;
+
+                const std::string sql = std::string{"ALTER TABLE Tracks ADD COLUMN "} + column.name + " " + column.declaration + ";";
+                if (!m_db.execute(sql))
+                {
+                    m_lastErrorMessage = "Migration failed on SQL: [" + sql + "] Error: " + m_db.getLastError();
+                    return DbResult::failure(DbResultStatus::ErrorDB, m_lastErrorMessage);
+                }
+                spdlog::info("Migration: added column Tracks.{}", column.name);
+            }
+
+            // Rebuilding tables takes long on a large library, so it is not done while connecting but by
+            // migrateSchema(), which the application runs with its progress on screen
+            m_bSchemaMigrationPending = version < CURRENT_SCHEMA_VERSION;
+            if (m_bSchemaMigrationPending)
+            {
+                spdlog::info("Database schema v{} needs migrating to v{}", version, CURRENT_SCHEMA_VERSION);
+            }
+            return DbResult::success();
+        }
+
+        DbResult SqliteTrackDatabase::migrateSchema(ProgressCallback progressCb, std::atomic<bool> &shouldCancel)
+        {
+            if (!isOpen())
+            {
+                return DbResult::failure(DbResultStatus::ErrorConnection, "DB not open for schema migration.");
+            }
+            const int version = std::max(getDBSchemaVersion(), 1);
+
+            // Each step brings the database to its version and records that in the transaction of its last change, so
+            // an interrupted step is simply run again on the next start
+            struct SchemaMigration
+            {
+                int version;
+                const char *description;
+                DbResult (SqliteTrackDatabase::*apply)(const ProgressCallback &progressCb, std::atomic<bool> &shouldCancel);
+            };
+            static const SchemaMigration migrations[] = {
+                {2, "link tables without rowid, no duplicate filepath index", &SqliteTrackDatabase::migrateToV2},
+            };
+            static_assert(std::size(migrations) == CURRENT_SCHEMA_VERSION - 1, "one migration per schema version after v1");
+
+            for (const auto &migration : migrations)
+            {
+                if (migration.version <= version)
+                    continue;
+
+                spdlog::info("Migrating the database to schema v{}: {}", migration.version, migration.description);
+                progressCb(0, std::format("Migrating to schema v{}: {}", migration.version, migration.description));
+                DbResult result = (this->*migration.apply)(progressCb, shouldCancel);
+                if (!result.isOk())
+                {
+                    m_lastErrorMessage = result.errorMessage;
+                    return result;
+                }
+            }
+
+            // Rebuilt tables come without their indexes, and the swap dropped the triggers and views on them
+            for (const auto &sql : schemaSqlStatements)
+            {
+                if (!m_db.execute(sql))
+                {
+                    m_lastErrorMessage = "Schema creation failed on SQL: [" + sql + "] Error: " + m_db.getLastError();
+                    return DbResult::failure(DbResultStatus::ErrorDB, m_lastErrorMessage);
+                }
+            }
+            m_bSchemaMigrationPending = false;
+            spdlog::info("Database migrated to schema v{}", CURRENT_SCHEMA_VERSION);
+            return DbResult::success();
+        }
+
+        DbResult SqliteTrackDatabase::copyTableInBatches(const std::string &from, const std::string &to, const std::string &columns,
+                                                         const std::function<void(int percent)> &onProgress, std::atomic<bool> &shouldCancel)
+        {
+            // The copy position is kept in SchemaInfo, so a migration cut short resumes instead of starting over
+            const std::string cursorKey = "migration_copied_" + from;
+            int64_t copied = 0;
+            {
+                SqliteStatement stmt{m_db, "SELECT value FROM SchemaInfo WHERE key = ?;"};
+                stmt.addParam(cursorKey);
+                if (stmt.getNextResult())
+                {
+                    copied = std::stoll(stmt.getText(0));
+                }
+            }
+            int64_t lastRowId = 0;
+            {
+                SqliteStatement stmt{m_db, "SELECT COALESCE(MAX(rowid), 0) FROM " + from + ";"};
+                if (!stmt.getNextResult())
+                {
+                    return DbResult::failure(DbResultStatus::ErrorDB, "Failed to size " + from + ": " + m_db.getLastError());
+                }
+                lastRowId = stmt.getInt64(0);
+            }
+
+            const std::string copySql = "INSERT OR IGNORE INTO " + to + " SELECT " + columns + " FROM " + from + " WHERE rowid > ? AND rowid <= ?;";
+            int reportedPercent = -1;
+            while (copied < lastRowId)
+            {
+                if (shouldCancel)
+                {
+                    return DbResult::failure(DbResultStatus::ErrorGeneric, "Migration cancelled while copying " + from + ".");
+                }
+                const int64_t upTo = std::min(copied + MIGRATION_BATCH_ROWS, lastRowId);
+                SqliteTransaction transaction{m_db};
+                if (!transaction || !transaction.execute(copySql, copied, upTo) ||
+                    !transaction.execute("INSERT OR REPLACE INTO SchemaInfo (key, value) VALUES (?, ?);", cursorKey, std::to_string(upTo)) ||
+                    !transaction.commit())
+                {
+                    return DbResult::failure(DbResultStatus::ErrorDB, "Failed to copy " + from + ": " + m_db.getLastError());
+                }
+                copied = upTo;
+
+                const int percent = static_cast<int>(copied * 100 / lastRowId);
+                onProgress(percent);
+                if (percent / 10 != reportedPercent / 10)
+                {
+                    spdlog::info("Migration: copied {}% of {}", percent, from);
+                    reportedPercent = percent;
+                }
+            }
+            return DbResult::success();
+        }
+
+        DbResult SqliteTrackDatabase::migrateToV2(const ProgressCallback &progressCb, std::atomic<bool> &shouldCancel)
+        {
+            // The application goes on with the old tables when the copy stops short, and the copy would miss what
+            // changes in them until the next attempt, so that one starts over. Only a copy cut short by the process
+            // ending is resumed, as nothing writes to the old tables before the next attempt.
+            const auto discardCopies = [this]()
+            {
+                for (const auto &table : v2RebuiltTables)
+                {
+                    m_db.execute(std::string{"DROP TABLE IF EXISTS "} + table.name + "_v2;");
+                }
+                m_db.execute("DELETE FROM SchemaInfo WHERE key LIKE 'migration_copied_%';");
+            };
+
+            const int tableCount = static_cast<int>(std::size(v2RebuiltTables));
+            for (int tableIndex = 0; tableIndex < tableCount; ++tableIndex)
+            {
+                const auto &table = v2RebuiltTables[tableIndex];
+                const std::string newName = std::string{table.name} + "_v2";
+                if (!m_db.execute("CREATE TABLE IF NOT EXISTS " + newName + " " + table.definition))
+                {
+                    DbResult result = DbResult::failure(DbResultStatus::ErrorDB, "Failed to create " + newName + ": " + m_db.getLastError());
+                    discardCopies();
+                    return result;
+                }
+                const auto onProgress = [&](int percent)
+                {
+                    progressCb((tableIndex * 100 + percent) / tableCount, std::format("Copying {}: {}%", table.name, percent));
+                };
+                DbResult result = copyTableInBatches(table.name, newName, table.copyColumns, onProgress, shouldCancel);
+                if (!result.isOk())
+                {
+                    discardCopies();
+                    return result;
+                }
+            }
+            progressCb(100, "Replacing the old tables...");
+            DbResult result = swapInV2Tables();
+            if (!result.isOk())
+            {
+                discardCopies();
+            }
+            return result;
+        }
+
+        DbResult SqliteTrackDatabase::swapInV2Tables()
+        {
+            // Swap the tables in one go. Renaming checks every view and trigger against the schema, and the search
+            // ones refer to TrackTags, so they are dropped here and recreated with the rest of the schema afterwards.
+            SqliteTransaction transaction{m_db};
+            if (!transaction)
+            {
+                return DbResult::failure(DbResultStatus::ErrorDB, "Failed to begin the v2 migration: " + m_db.getLastError());
+            }
+            std::vector<std::string> triggers;
+            {
+                SqliteStatement stmt{m_db, "SELECT name FROM sqlite_master WHERE type = 'trigger';"};
+                while (stmt.getNextResult())
+                {
+                    triggers.emplace_back(stmt.getText(0));
+                }
+            }
+            std::vector<std::string> swapSql;
+            for (const auto &trigger : triggers)
+            {
+                swapSql.emplace_back("DROP TRIGGER IF EXISTS " + trigger + ";");
+            }
+            swapSql.emplace_back("DROP VIEW IF EXISTS TrackSearchSource;");
+            for (const auto &table : v2RebuiltTables)
+            {
+                swapSql.emplace_back(std::string{"DROP TABLE "} + table.name + ";");
+                swapSql.emplace_back(std::string{"ALTER TABLE "} + table.name + "_v2 RENAME TO " + table.name + ";");
+            }
+            // Duplicates the index behind filepath's UNIQUE constraint
+            swapSql.emplace_back("DROP INDEX IF EXISTS idx_tracks_filepath;");
+            swapSql.emplace_back("DELETE FROM SchemaInfo WHERE key LIKE 'migration_copied_%';");
+            for (const auto &sql : swapSql)
+            {
+                if (!transaction.execute(sql))
+                {
+                    return DbResult::failure(DbResultStatus::ErrorDB, "Migration to v2 failed on [" + sql + "]: " + m_db.getLastError());
+                }
+            }
+            DbResult versionResult = setDBSchemaVersion(2);
+            if (!versionResult.isOk())
+            {
+                return versionResult;
+            }
+            if (!transaction.commit())
+            {
+                return DbResult::failure(DbResultStatus::ErrorDB, "Failed to commit the v2 migration: " + m_db.getLastError());
+            }
             return DbResult::success();
         }
 
@@ -547,12 +1445,13 @@ namespace jucyaudio
                                 duration, samplerate, channels, bitrate, codec_name,
                                 bpm, intro_end, outro_start, key_string, beat_locations_json,
                                 rating, liked_status, play_count, last_played,
-                                internal_content_hash, user_notes, is_missing) 
-            VALUES (?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?);
-        )SQL"; // 28 placeholders, is_missing defaults to 0 on insert
+                                internal_content_hash, user_notes, is_missing,
+                                loudness_lufs, loudness_range, true_peak_db, tempo_map_json) 
+            VALUES (?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?);
+        )SQL"; // 34 placeholders
 
                 SqliteStatement stmt{m_db, sql};
-                if (stmt.isValid() && bindTrackInfoToStatement(stmt, trackInfo, false) && stmt.execute())
+                if (stmt.isValid() && bindTrackInfoToStatement(stmt, trackInfo) && stmt.execute())
                 {
                     trackInfo.trackId = m_db.getLastInsertRowId();
                     spdlog::debug("Inserted track ID: {}, Path: {}", trackInfo.trackId, pathToString(trackInfo.filepath));
@@ -560,20 +1459,15 @@ namespace jucyaudio
                 }
                 m_cachedTotalTrackCount = false;
             }
+            else if (trackInfo.changedFields == 0)
+            {
+                success = true; // a rescan of an unchanged file, at most the tags differ
+            }
             else
-            {  // UPDATE
-                const std::string sql = R"SQL(
-            UPDATE Tracks SET folder_id=?, filepath=?, last_modified_fs=?, filesize_bytes=?, date_added=?, last_scanned=?,
-                              title=?, artist_name=?, album_title=?, album_artist_name=?, track_number=?, disc_number=?, year=?, 
-                              duration=?, samplerate=?, channels=?, bitrate=?, codec_name=?,
-                              bpm=?, intro_end=?, outro_start=?, key_string=?, beat_locations_json=?,
-                              rating=?, liked_status=?, play_count=?, last_played=?,
-                              internal_content_hash=?, user_notes=?, is_missing=?
-            WHERE track_id = ?;
-        )SQL"; // 28 fields + 1 for track_id in WHERE
-
-                SqliteStatement stmt{m_db, sql};
-                if (stmt.isValid() && bindTrackInfoToStatement(stmt, trackInfo, true) && stmt.execute())
+            {  // UPDATE of just the changed columns; a rescan typically only moves last_scanned
+                SqliteStatement stmt{m_db, buildTrackUpdateSql(trackInfo.changedFields)};
+                if (stmt.isValid() && bindTrackInfoToStatement(stmt, trackInfo, trackInfo.changedFields) &&
+                    stmt.addParam(static_cast<int64_t>(trackInfo.trackId)) && stmt.execute())
                 {
                     spdlog::debug("Updated track ID: {}", trackInfo.trackId);
                     success = true;
@@ -592,6 +1486,7 @@ namespace jucyaudio
                     m_db.execute("ROLLBACK;");
                     return DbResult::failure(DbResultStatus::ErrorDB, m_lastErrorMessage);
                 }
+                trackInfo.changedFields = 0;
                 return DbResult::success();
             }
             else
@@ -633,36 +1528,25 @@ namespace jucyaudio
             return std::nullopt;
         }
 
-        std::optional<TrackInfo> SqliteTrackDatabase::getNextTrackForBpmAnalysis() const
+        std::vector<TrackId> SqliteTrackDatabase::getTrackIdsNeedingAnalysis(const TrackQueryArgs &args) const
         {
             if (!isOpen())
-            {
-                return std::nullopt;
-            }
-            m_lastErrorMessage.clear(); // mutable m_lastErrorMessage
-
-            // --- PRIORITY 1: Un-analyzed tracks that are part of ANY mix project ---
-            std::string sql_priority1 = R"SQL(
-                SELECT T.* FROM Tracks T
-                JOIN MixTracks MT ON T.track_id = MT.track_id
-                WHERE T.bpm IS NULL OR T.bpm <= 0
-                LIMIT 1;
-            )SQL";
+                return {};
+            m_lastErrorMessage.clear();
 
-            SqliteStatement stmt1{m_db, sql_priority1};
-            if (stmt1.getNextResult())
+            std::vector<TrackId> trackIds;
+            SqliteStatement stmt{m_db};
+            SqliteStatementConstruction stmtConstruction{stmt};
+            if (!stmtConstruction.createSelectTrackIdsNeedingAnalysisStatement(args))
             {
-                return trackInfoFromStatement(stmt1); // Found a high-priority track
+                m_lastErrorMessage = "Failed to create analysis selection statement: " + m_db.getLastError();
+                return trackIds;
             }
-
-            // --- PRIORITY 2: Any other un-analyzed track ---
-            std::string sql_priority2 = "SELECT * FROM Tracks WHERE bpm IS NULL OR bpm <= 0 LIMIT 1;";
-            SqliteStatement stmt2{m_db, sql_priority2};
-            if (stmt2.getNextResult())
+            while (stmt.getNextResult())
             {
-                return trackInfoFromStatement(stmt2); // Found a regular-priority track
+                trackIds.emplace_back(stmt.getInt64(0));
             }
-            return std::nullopt;
+            return trackIds;
         }
 
         std::optional<TrackInfo> SqliteTrackDatabase::getTrackByFilepath(const std::filesystem::path &filepath) const
@@ -736,7 +1620,8 @@ namespace jucyaudio
                 return DbResult::failure(DbResultStatus::ErrorConnection, "DB not open for update.");
             }
             m_lastErrorMessage.clear();
-            std::string sql = "UPDATE Tracks SET bpm=?, intro_end=?, outro_start=? WHERE track_id = ?;";
+            std::string sql = "UPDATE Tracks SET bpm=?, intro_end=?, outro_start=?, loudness_lufs=?, loudness_range=?, true_peak_db=?, "
+                              "tempo_map_json=? WHERE track_id = ?;";
             SqliteStatement stmt{m_db, sql};
 
             if (!stmt.isValid())
@@ -761,6 +1646,26 @@ namespace jucyaudio
             {
                 stmt.addNullParam(); // Use null if no intro end
             }
+            if (am.hasLoudness)
+            {
+                stmt.addParam(am.integratedLoudness);
+                stmt.addParam(am.loudnessRange);
+                stmt.addParam(am.truePeak);
+            }
+            else
+            {
+                stmt.addNullParam();
+                stmt.addNullParam();
+                stmt.addNullParam();
+            }
+            if (am.tempoMap.empty())
+            {
+                stmt.addNullParam();
+            }
+            else
+            {
+                stmt.addParam(tempoMapToJson(am.tempoMap));
+            }
             stmt.addParam(trackId);
 
             if (stmt.execute())
@@ -902,35 +1807,156 @@ namespace jucyaudio
             return results;
         }
 
-        int64_t nextUniqueId()
+        std::vector<TrackListRow> SqliteTrackDatabase::getTrackRowsById(const std::vector<TrackId> &trackIds, const std::vector<std::string> &columns) const
+        {
+            if (!isOpen() || trackIds.empty())
+                return {};
+            m_lastErrorMessage.clear();
+
+            // Walking the id list and looking each track up keeps the list's order, and the LEFT JOIN its length
+            std::string columnList{"Tracks.track_id"};
+            const auto projection = projectTrackRowColumns(columns, columnList);
+            SqliteStatement stmt{m_db, "SELECT " + columnList + " FROM json_each(?) AS ids LEFT JOIN Tracks ON Tracks.track_id = ids.value ORDER BY ids.key;"};
+            if (!stmt.isValid())
+            {
+                m_lastErrorMessage = m_db.getLastError();
+                return {};
+            }
+            stmt.addParam(toJsonArray(trackIds));
+
+            std::vector<TrackListRow> results;
+            results.reserve(trackIds.size());
+            while (stmt.getNextResult())
+            {
+                TrackListRow &row = results.emplace_back();
+                if (!stmt.isNull(0))
+                {
+                    row.trackId = stmt.getInt64(0);
+                    readTrackRow(stmt, projection, row);
+                }
+            }
+            return results;
+        }
+
+        std::vector<TrackInfo> SqliteTrackDatabase::getTracksById(const std::vector<TrackId> &trackIds) const
         {
-            static std::atomic<int64_t> counter{0};
-            return counter.fetch_add(1, std::memory_order_relaxed);
+            if (!isOpen() || trackIds.empty())
+                return {};
+            m_lastErrorMessage.clear();
+
+            SqliteStatement stmt{m_db, "SELECT Tracks.* FROM json_each(?) AS ids LEFT JOIN Tracks ON Tracks.track_id = ids.value ORDER BY ids.key;"};
+            if (!stmt.isValid())
+            {
+                m_lastErrorMessage = m_db.getLastError();
+                return {};
+            }
+            stmt.addParam(toJsonArray(trackIds));
+
+            std::vector<TrackInfo> results;
+            results.reserve(trackIds.size());
+            while (stmt.getNextResult())
+            {
+                if (stmt.isNull(0))
+                    results.emplace_back(); // deleted since the ids were read; trackId stays -1
+                else
+                    results.emplace_back(trackInfoFromStatement(stmt));
+            }
+            readAllTagTracks(results);
+            return results;
         }
 
-        std::string generateTempTableName(const std::string &base = "temp_table_")
+        int64_t SqliteTrackDatabase::getDataVersion() const
         {
-            return base + "_" + std::to_string(nextUniqueId());
+            if (!isOpen())
+                return -1;
+            SqliteStatement stmt{m_db, "SELECT version FROM DataVersion;"};
+            return stmt.getNextResult() ? stmt.getInt64(0) : -1;
+        }
+
+        std::vector<TrackId> SqliteTrackDatabase::getTrackIds(const TrackQueryArgs &args) const
+        {
+            if (!isOpen())
+                return {};
+            m_lastErrorMessage.clear();
+
+            if (m_columnIndex.isStarted())
+            {
+                if (auto trackIds = m_columnIndex.getTrackIds(args))
+                    return std::move(*trackIds);
+            }
+
+            TrackQueryArgs allRows{args};
+            allRows.usePaging = false;
+
+            std::vector<TrackId> results;
+            SqliteStatement stmt{m_db};
+            SqliteStatementConstruction stmtConstruction{stmt};
+            if (!stmtConstruction.createSelectStatement(allRows, "track_id"))
+            {
+                m_lastErrorMessage = "Failed to create select statement: " + m_db.getLastError();
+                return results;
+            }
+            while (stmt.getNextResult())
+            {
+                results.push_back(stmt.getInt64(0));
+            }
+            return results;
+        }
+
+        std::string SqliteTrackDatabase::explainTrackQuery(const TrackQueryArgs &args, bool idsOnly) const
+        {
+            if (!isOpen())
+                return {};
+            m_lastErrorMessage.clear();
+
+            // The statement getTracks() or getTrackIds() builds for args; the column index is left aside
+            TrackQueryArgs queryArgs{args};
+            if (idsOnly)
+            {
+                queryArgs.usePaging = false;
+            }
+            SqliteStatement stmt{m_db};
+            SqliteStatementConstruction stmtConstruction{stmt};
+            if (!stmtConstruction.createExplainSelectStatement(queryArgs, idsOnly ? "track_id" : "*"))
+            {
+                m_lastErrorMessage = "Failed to create explain statement: " + m_db.getLastError();
+                return {};
+            }
+
+            // Rows are (id, parent, notused, detail); children come after their parent
+            std::unordered_map<int, int> depthOf;
+            std::string plan;
+            while (stmt.getNextResult())
+            {
+                const auto parentDepth = depthOf.find(stmt.getInt32(1));
+                const int depth = parentDepth != depthOf.end() ? parentDepth->second + 1 : 0;
+                depthOf[stmt.getInt32(0)] = depth;
+                if (!plan.empty())
+                    plan += '\n';
+                plan += std::string(2 * static_cast<size_t>(depth), ' ') + stmt.getText(3);
+            }
+            return plan;
         }
 
         void SqliteTrackDatabase::readAllTagTracks(std::vector<TrackInfo> &tracks) const
         {
-            const auto tempTableName{generateTempTableName()};
-            m_db.execute("BEGIN TRANSACTION;");
-            m_db.execute("DROP TABLE IF EXISTS " + tempTableName + ";");
-            m_db.execute("CREATE TEMP TABLE " + tempTableName + " (track_id INTEGER PRIMARY KEY);");
+            // The page's ids go in as one JSON array parameter, so a whole page costs a single (cached) statement
+            std::vector<TrackId> trackIds;
             std::unordered_map<TrackId, TrackInfo *> trackMap;
+            trackMap.reserve(tracks.size());
             for (auto &track : tracks)
             {
-                if (track.trackId != -1) // Only insert valid track IDs
+                if (track.trackId != -1) // Only look up valid track IDs
                 {
-                    m_db.execute("INSERT INTO " + tempTableName + " (track_id) VALUES (" + std::to_string(track.trackId) + ");");
+                    trackIds.push_back(track.trackId);
                     trackMap[track.trackId] = &track; // Store pointer to TrackInfo
                 }
             }
-            SqliteStatement stmt{m_db, "SELECT track_id, tag_id FROM TrackTags WHERE "
-                                       "track_id IN (SELECT track_id FROM " +
-                                           tempTableName + ");"};
+            if (trackMap.empty())
+                return;
+
+            SqliteStatement stmt{m_db, "SELECT track_id, tag_id FROM TrackTags WHERE track_id IN (SELECT value FROM json_each(?));"};
+            stmt.addParam(toJsonArray(trackIds));
             while (stmt.getNextResult())
             {
                 if (!stmt.isNull(0))
@@ -944,8 +1970,6 @@ namespace jucyaudio
                     }
                 }
             }
-            m_db.execute("DROP TABLE " + tempTableName + ";");
-            m_db.execute("COMMIT;");
         }
 
         int SqliteTrackDatabase::getTotalTrackCount(const TrackQueryArgs &args) const
@@ -953,6 +1977,11 @@ namespace jucyaudio
             if (!isOpen())
                 return -1; // Indicate error
             m_lastErrorMessage.clear();
+            if (m_columnIndex.isStarted())
+            {
+                if (const auto count = m_columnIndex.getTrackCount(args))
+                    return static_cast<int>(*count);
+            }
             SqliteStatement stmt{m_db};
             SqliteStatementConstruction stmtConstruction{stmt};
             if (!stmtConstruction.createCountStatement(args))
@@ -974,32 +2003,54 @@ namespace jucyaudio
         // --- Tag Management Implementations ---
         bool SqliteTrackDatabase::updateTrackTagsFromInsideTransaction(TrackId trackId, const std::vector<TagId> &tagIds)
         {
-            SqliteStatement stmt_delete{m_db, "DELETE FROM TrackTags WHERE track_id = ?;"};
-            if (!stmt_delete.isValid())
-            {
-                m_lastErrorMessage = m_db.getLastError();
-                return false;
-            }
+            // Only touch the links that actually change: every TrackTags write also reindexes the track for search
+            std::vector<TagId> wanted{tagIds};
+            std::sort(wanted.begin(), wanted.end());
+            wanted.erase(std::unique(wanted.begin(), wanted.end()), wanted.end());
+            std::vector<TagId> stored{getTrackTags(trackId)};
+            std::sort(stored.begin(), stored.end());
+
+            std::vector<TagId> removed, added;
+            std::set_difference(stored.begin(), stored.end(), wanted.begin(), wanted.end(), std::back_inserter(removed));
+            std::set_difference(wanted.begin(), wanted.end(), stored.begin(), stored.end(), std::back_inserter(added));
 
-            stmt_delete.addParam(trackId);
-            if (!stmt_delete.execute())
+            if (!removed.empty())
             {
-                return false;
+                SqliteStatement stmt_delete{m_db, "DELETE FROM TrackTags WHERE track_id = ? AND tag_id = ?;"};
+                if (!stmt_delete.isValid())
+                {
+                    m_lastErrorMessage = m_db.getLastError();
+                    return false;
+                }
+                for (const auto tagId : removed)
+                {
+                    stmt_delete.reset();
+                    stmt_delete.addParam(trackId);
+                    stmt_delete.addParam(tagId);
+                    if (!stmt_delete.execute())
+                    {
+                        return false;
+                    }
+                }
             }
 
-            for (const auto tagId : tagIds)
+            if (!added.empty())
             {
-                // Insert new tag associations
+                // Preparing the statement once for all of them
                 SqliteStatement stmt_insert{m_db, "INSERT INTO TrackTags (track_id, tag_id) VALUES (?, ?);"};
                 if (!stmt_insert.isValid())
                 {
                     return false;
                 }
-                stmt_insert.addParam(trackId);
-                stmt_insert.addParam(tagId);
-                if (!stmt_insert.execute())
+                for (const auto tagId : added)
                 {
-                    return false;
+                    stmt_insert.reset();
+                    stmt_insert.addParam(trackId);
+                    stmt_insert.addParam(tagId);
+                    if (!stmt_insert.execute())
+                    {
+                        return false;
+                    }
                 }
             }
             return true;
@@ -4,8 +4,10 @@
 #include <Database/Sqlite/SqliteDatabase.h>
 #include <Database/Sqlite/SqliteStatement.h>
 #include <Database/Sqlite/SqliteTagManager.h>
+#include <Database/Sqlite/SqliteTrackColumnIndex.h>
 #include <Database/Sqlite/SqliteMixManager.h>
 #include <Database/Sqlite/SqliteFolderDatabase.h>
+#include <Database/Sqlite/SqliteJobQueue.h>
 #include <Database/Sqlite/SqliteWorkingSetManager.h>
 #include <Database/Sqlite/sqlite3.h>
 #include <filesystem>
@@ -31,12 +33,25 @@ namespace jucyaudio
             SqliteTrackDatabase &operator=(SqliteTrackDatabase &&) = delete;
 
             // --- ITrackDatabase Interface Implementation ---
+            void setStorageTuning(const StorageTuning &tuning) override;
             DbResult connect(const std::filesystem::path &databaseFilePath) override;
             void close() override;
             bool isOpen() const override;
             std::string getLastError() const override; // Gets from lastErrorMessage
             bool runMaintenanceTasks(std::atomic<bool> &shouldCancel) override;
+            DatabaseSpaceReport getSpaceReport() const override;
+            int64_t incrementalVacuum(int64_t maxPages) override;
+            bool optimizeStatistics() override;
+            void setColumnIndexEnabled(bool enabled) override;
+            void setQueryProfiling(bool enabled, std::chrono::milliseconds slowQueryThreshold) override;
+            std::vector<QueryStats> getQueryStats() const override;
+            void resetQueryStats() override;
             DbResult createTablesIfNeeded() override;
+            bool needsSchemaMigration() const override
+            {
+                return m_bSchemaMigrationPending;
+            }
+            DbResult migrateSchema(ProgressCallback progressCb, std::atomic<bool> &shouldCancel) override;
             // int getCurrentSchemaVersion() override; // Implementation for schema versioning
             // DbResult upgradeSchemaTo(int targetVersion) override;
 
@@ -46,6 +61,11 @@ namespace jucyaudio
             std::optional<TrackInfo> getTrackByFilepath(const std::filesystem::path &filepath) const override;
 
             std::vector<TrackInfo> getTracks(const TrackQueryArgs &args) const override;
+            std::vector<TrackId> getTrackIds(const TrackQueryArgs &args) const override;
+            std::vector<TrackListRow> getTrackRowsById(const std::vector<TrackId> &trackIds, const std::vector<std::string> &columns) const override;
+            std::vector<TrackInfo> getTracksById(const std::vector<TrackId> &trackIds) const override;
+            int64_t getDataVersion() const override;
+            std::string explainTrackQuery(const TrackQueryArgs &args, bool idsOnly) const override;
             int getTotalTrackCount(const TrackQueryArgs &baseFilters) const override;
             int getTotalTrackCount() const // Without filters, but with cache
             {
@@ -66,9 +86,7 @@ namespace jucyaudio
 
             IFolderDatabase &getFolderDatabase() const override;
 
-            // Finds one track that has no BPM data and returns its info.
-            // Returns std::nullopt if no such tracks are found.
-            std::optional<TrackInfo> getNextTrackForBpmAnalysis() const override;
+            std::vector<TrackId> getTrackIdsNeedingAnalysis(const TrackQueryArgs &args) const override;
 
             DbResult updateTrackBpm(TrackId trackId, const AudioMetadata& am) override;
 
@@ -81,6 +99,9 @@ namespace jucyaudio
             IWorkingSetManager &getWorkingSetManager() override;
             const IWorkingSetManager &getWorkingSetManager() const override;
 
+            IJobQueue &getJobQueue() override;
+            const IJobQueue &getJobQueue() const override;
+
             DbResult updateTrackTags(TrackId trackId, const std::vector<TagId>& tagIds) override;
             std::vector<TagId> getTrackTags(TrackId trackId) const override;
             std::vector<TagId> getAllTags() const override;
@@ -98,16 +119,29 @@ namespace jucyaudio
             mutable SqliteMixManager m_mixManager;
             mutable SqliteWorkingSetManager m_workingSetManager; // Working set manager instance
             mutable SqliteFolderDatabase m_folderDatabase; // Folder database instance
+            mutable SqliteJobQueue m_jobQueue;             // Background job queue
+            mutable SqliteTrackColumnIndex m_columnIndex;  // Answers getTrackIds() and counts when enabled
             std::filesystem::path m_databaseFilePath; // Store the path
+            StorageTuning m_storageTuning;            // Applied by connect()
             mutable std::string m_lastErrorMessage;   // For getLastError()
 
             mutable int m_cachedTotalTrackCount{0}; // Cache for total track count
             mutable bool m_cachedTotalTrackCountValid{false}; // Flag to check if cache is valid
 
             // Schema versioning helpers
+            static constexpr int CURRENT_SCHEMA_VERSION = 2;
+
             int getDBSchemaVersion();
             DbResult setDBSchemaVersion(int version);
-            DbResult runMigrations(); // Calls specific migration steps
+            bool m_bSchemaMigrationPending{false}; // set by runMigrations(), cleared by migrateSchema()
+
+            DbResult runMigrations(); // The quick steps; rebuilding tables is left to migrateSchema()
+            DbResult migrateToV2(const ProgressCallback &progressCb, std::atomic<bool> &shouldCancel);
+            DbResult swapInV2Tables(); // Replaces the v1 link tables by their copies, in one transaction
+            /// @brief Copies a rowid table into another in short transactions, resuming where an earlier run stopped.
+            /// Reports the percentage copied after each transaction and stops between them once shouldCancel is set.
+            DbResult copyTableInBatches(const std::string &from, const std::string &to, const std::string &columns,
+                                        const std::function<void(int percent)> &onProgress, std::atomic<bool> &shouldCancel);
         };
 
     } // namespace database
@@ -3,6 +3,8 @@
 
 #include <spdlog/spdlog.h>
 
+#include <Database/BackgroundMetrics.h>
+#include <Database/BackgroundService.h>
 #include <Database/Nodes/RootNode.h>
 #include <Database/Sqlite/SqliteTrackDatabase.h>
 #include <Database/TrackLibrary.h>
@@ -47,7 +49,8 @@ namespace jucyaudio
         }
 
         bool TrackLibrary::initialise(
-            const std::filesystem::path &databaseFilePath)
+            const std::filesystem::path &databaseFilePath,
+            const StorageTuning &storageTuning)
         {
             if (m_isInitialised)
             {
@@ -59,6 +62,7 @@ namespace jucyaudio
                          databaseFilePath.string());
 
             m_database = new SqliteTrackDatabase{};
+            m_database->setStorageTuning(storageTuning);
 
             DbResult connectResult = m_database->connect(databaseFilePath);
             if (!connectResult.isOk())
@@ -71,6 +75,7 @@ namespace jucyaudio
                 return false;
             }
             m_scanner = new TrackScanner{*m_database}; // Scanner needs the DB
+            theBackgroundMetrics.refreshQueueDepths(m_database->getJobQueue());
 
             m_isInitialised = true;
             spdlog::info("TrackLibrary initialised successfully.");
@@ -95,6 +100,7 @@ namespace jucyaudio
                 delete m_database;
                 m_database = nullptr;
             }
+            m_analysisQueue.clear();
             m_isInitialised = false;
             spdlog::info("TrackLibrary shut down.");
         }
@@ -115,5 +121,41 @@ namespace jucyaudio
                                    progressCb, completionCb, shouldCancel);
         }
 
+        void TrackLibrary::boostAnalysisPriority(const TrackQueryArgs &args, AnalysisPriority priority)
+        {
+            if (!m_isInitialised || !m_database)
+            {
+                setLastError("TrackLibrary not initialised.");
+                return;
+            }
+            const auto trackIds{m_database->getTrackIdsNeedingAnalysis(args)};
+            if (trackIds.empty())
+                return;
+
+            spdlog::debug("Boosting {} track(s) to analysis priority {}", trackIds.size(), static_cast<int>(priority));
+            m_analysisQueue.boost(trackIds, priority);
+            theBackgroundTaskService.notify();
+        }
+
+        std::optional<JobInfo> TrackLibrary::leaseNextAnalysisJob()
+        {
+            if (!m_isInitialised || !m_database)
+                return std::nullopt;
+
+            // Long enough for a full decode of a long mix on a throttled core; a crashed worker's job comes back after it
+            constexpr std::chrono::seconds leaseDuration{10 * 60};
+
+            // Boosted entries may have been analyzed (or given up on) since they were queued
+            auto &jobQueue{m_database->getJobQueue()};
+            while (const auto trackId{m_analysisQueue.pop()})
+            {
+                if (auto job{jobQueue.leaseForTrack(JobType::Analysis, *trackId, leaseDuration)})
+                {
+                    return job;
+                }
+            }
+            return jobQueue.leaseNext(JobType::Analysis, leaseDuration);
+        }
+
     } // namespace database
 } // namespace jucyaudio
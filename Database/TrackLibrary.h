@@ -1,5 +1,6 @@
 #pragma once
 
+#include <Database/AnalysisQueue.h>
 #include <Database/Includes/ILongRunningTask.h>
 #include <Database/Includes/IMixManager.h>
 #include <Database/Includes/INavigationNode.h>
@@ -40,7 +41,7 @@ namespace jucyaudio
             // Initialization
             // Takes the path where the SQLite database file should be located/created.
             // Returns true on success, false on failure.
-            bool initialise(const std::filesystem::path &databaseFilePath);
+            bool initialise(const std::filesystem::path &databaseFilePath, const StorageTuning &storageTuning = {});
             void shutdown(); // Closes DB, cleans up resources
             bool isInitialised() const
             {
@@ -95,6 +96,11 @@ namespace jucyaudio
                 return m_database->getWorkingSetManager();
             }
 
+            IJobQueue &getJobQueue() const
+            {
+                return m_database->getJobQueue();
+            }
+
 
             
             int getTotalTrackCount(const TrackQueryArgs &baseFilters = TrackQueryArgs{}) const
@@ -107,6 +113,43 @@ namespace jucyaudio
                 return m_database->getTotalTrackCount(baseFilters);
             }
 
+            void setColumnIndexEnabled(bool enabled)
+            {
+                if (m_isInitialised && m_database)
+                {
+                    m_database->setColumnIndexEnabled(enabled);
+                }
+            }
+
+            void setQueryProfiling(bool enabled, std::chrono::milliseconds slowQueryThreshold)
+            {
+                if (m_isInitialised && m_database)
+                {
+                    m_database->setQueryProfiling(enabled, slowQueryThreshold);
+                }
+            }
+
+            bool needsSchemaMigration() const
+            {
+                return m_isInitialised && m_database && m_database->needsSchemaMigration();
+            }
+
+            bool migrateSchema(ProgressCallback progressCb, std::atomic<bool> &shouldCancel)
+            {
+                if (!m_isInitialised || !m_database)
+                {
+                    setLastError("TrackLibrary not initialised.");
+                    return false;
+                }
+                DbResult result = m_database->migrateSchema(std::move(progressCb), shouldCancel);
+                if (!result.isOk())
+                {
+                    setLastError(result.errorMessage);
+                    return false;
+                }
+                return true;
+            }
+
             bool runMaintenanceTasks(std::atomic<bool> &shouldCancel)
             {
                 if (!m_isInitialised || !m_database)
@@ -114,7 +157,12 @@ namespace jucyaudio
                     setLastError("TrackLibrary not initialised.");
                     return false;
                 }
-                return m_database->runMaintenanceTasks(shouldCancel);
+                if (!m_database->runMaintenanceTasks(shouldCancel))
+                {
+                    setLastError(m_database->getLastError());
+                    return false;
+                }
+                return true;
             }
 
             std::optional<TrackInfo> getTrackById(TrackId trackId) const
@@ -137,6 +185,53 @@ namespace jucyaudio
                 return m_database->getTracks(args);
             }
 
+            std::vector<TrackId> getTrackIds(const TrackQueryArgs &args) const
+            {
+                if (!m_isInitialised || !m_database)
+                {
+                    setLastError("TrackLibrary not initialised.");
+                    return std::vector<TrackId>{};
+                }
+                return m_database->getTrackIds(args);
+            }
+
+            std::vector<TrackListRow> getTrackRowsById(const std::vector<TrackId> &trackIds, const std::vector<std::string> &columns) const
+            {
+                if (!m_isInitialised || !m_database)
+                {
+                    setLastError("TrackLibrary not initialised.");
+                    return std::vector<TrackListRow>{};
+                }
+                return m_database->getTrackRowsById(trackIds, columns);
+            }
+
+            std::vector<TrackInfo> getTracksById(const std::vector<TrackId> &trackIds) const
+            {
+                if (!m_isInitialised || !m_database)
+                {
+                    setLastError("TrackLibrary not initialised.");
+                    return std::vector<TrackInfo>{};
+                }
+                return m_database->getTracksById(trackIds);
+            }
+
+            int64_t getDataVersion() const
+            {
+                if (!m_isInitialised || !m_database)
+                {
+                    return -1;
+                }
+                return m_database->getDataVersion();
+            }
+
+            /// @brief Promotes all unanalyzed tracks matching args to the front of the background analysis queue
+            /// and wakes the background service, so what the user is looking at gets analyzed first.
+            void boostAnalysisPriority(const TrackQueryArgs &args, AnalysisPriority priority);
+
+            /// @brief Leases the next analysis job: boosted tracks first, then the job queue's own order. The caller
+            /// completes, fails or releases it via getJobQueue(). Returns std::nullopt if nothing needs analysis.
+            std::optional<JobInfo> leaseNextAnalysisJob();
+
         private:
             bool setLastError(std::string_view errorMessage) const
             {
@@ -151,6 +246,7 @@ namespace jucyaudio
             bool m_isInitialised{false};
             mutable std::string m_lastErrorMessage; // For getLastError()
             INavigationNode *const m_rootNavNode;   // Raw pointer
+            AnalysisQueue m_analysisQueue;
         };
 
         extern TrackLibrary theTrackLibrary;
@@ -1,3 +1,5 @@
+#include <Database/BackgroundMetrics.h>
+#include <Database/BackgroundService.h>
 #include <Database/Includes/TrackInfo.h>
 #include <Database/Scanners/AubioScanner.h>
 #include <Database/Scanners/Id3TagScanner.h>
@@ -60,6 +62,7 @@ namespace jucyaudio
             std::unordered_map<FolderId, FolderScanStats> folderStatsMap;
 
             int filesProcessedThisSession = 0;
+            int analysisJobsQueued = 0;
 
             // Signal start with indeterminate progress. The UI should show a spinner/pulsing bar.
             if (m_progressCb)
@@ -112,6 +115,7 @@ namespace jucyaudio
                     std::optional<TrackInfo> existingTrackOpt = m_db.getTrackByFilepath(filePath);
                     TrackInfo currentTrackInfo{};
                     bool needsFullAnalysis = true;
+                    bool contentChanged = true;
 
                     // Get file metadata robustly from the juce::File object.
                     const auto fsLastModified = Timestamp_t(std::chrono::system_clock::from_time_t(file.getLastModificationTime().toMilliseconds() / 1000));
@@ -129,7 +133,8 @@ namespace jucyaudio
                             std::chrono::duration_cast<std::chrono::seconds>(currentTrackInfo.last_modified_fs.time_since_epoch()).count();
                         auto fs_last_modified_seconds = file.getLastModificationTime().toMilliseconds() / 1000;
 
-                        if (!m_forceRescanAll && db_last_modified_seconds == fs_last_modified_seconds && currentTrackInfo.filesize_bytes == fsFileSize)
+                        contentChanged = db_last_modified_seconds != fs_last_modified_seconds || currentTrackInfo.filesize_bytes != fsFileSize;
+                        if (!m_forceRescanAll && !contentChanged)
                         {
                             needsFullAnalysis = false;
                             spdlog::debug("Skipping full analysis for unchanged file: {}", pathToString(filePath));
@@ -159,12 +164,29 @@ namespace jucyaudio
                         }
                     }
                     currentTrackInfo.last_scanned = std::chrono::system_clock::now();
+                    if (existingTrackOpt)
+                    {
+                        // Write back only what the scan changed
+                        currentTrackInfo.markChangedSince(*existingTrackOpt);
+                    }
 
                     DbResult saveResult = m_db.saveTrackInfo(currentTrackInfo);
                     if (!saveResult.isOk())
                     {
                         spdlog::error("Failed to save track info for {}: {}", pathToString(filePath), saveResult.errorMessage);
                     }
+                    else if (contentChanged || !currentTrackInfo.bpm.has_value() || *currentTrackInfo.bpm <= 0)
+                    {
+                        // New, changed or never analyzed: queue it now rather than have the background task search for it
+                        if (m_db.getJobQueue().enqueue(JobType::Analysis, currentTrackInfo.trackId))
+                        {
+                            ++analysisJobsQueued;
+                        }
+                        else
+                        {
+                            spdlog::error("Failed to queue analysis for {}", pathToString(filePath));
+                        }
+                    }
                 }
             }
 
@@ -197,7 +219,12 @@ namespace jucyaudio
             if (m_progressCb)
                 m_progressCb(100, std::format("Scan complete. Processed {} files.", filesProcessedThisSession));
 
-            spdlog::info("Scan loop finished. Processed {} files.", filesProcessedThisSession);
+            spdlog::info("Scan loop finished. Processed {} files, queued {} for analysis.", filesProcessedThisSession, analysisJobsQueued);
+            if (analysisJobsQueued > 0)
+            {
+                theBackgroundMetrics.refreshQueueDepths(m_db.getJobQueue());
+                theBackgroundTaskService.notify();
+            }
             return true;
         }
     } // namespace database
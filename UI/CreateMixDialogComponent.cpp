@@ -17,7 +17,8 @@ namespace jucyaudio
     {
         CreateMixTask::CreateMixTask(const database::MixInfo& mixInfo, const audio::IMixExporter &mixExporter,
                                      const std::filesystem::path &targetExportPath)
-            : database::ILongRunningTask{std::format("Creating Mix {} with {:L} tracks", mixInfo.name, mixInfo.numberOfTracks), false},
+            : database::ILongRunningTask{std::format("Creating Mix {} with {:L} tracks", mixInfo.name, mixInfo.numberOfTracks), false,
+                                          TaskLane::Cpu}, // decoding and encoding dominate an export
               m_mixId{mixInfo.mixId},
               m_targetExportPath{targetExportPath},
               m_mixExporter{mixExporter}
@@ -73,6 +73,13 @@ namespace jucyaudio
             m_tableListBox.getHeader().removeAllColumns();
             if (columns::get(m_currentNode, m_currentDataColumns))
             {
+                std::vector<const DataColumn *> visibleColumns;
+                for (const auto &dataColumn : m_currentDataColumns)
+                {
+                    visibleColumns.push_back(dataColumn.column);
+                }
+                m_currentNode->setVisibleColumns(visibleColumns);
+
                 int columnIdCounter = 1;
                 for (const auto &dataColumn : m_currentDataColumns)
                 {
@@ -243,7 +250,7 @@ namespace jucyaudio
             {
                 const auto &columnToSortBy = m_currentDataColumns[dataColumnIndex];
                 std::vector<database::SortOrderInfo> sortOrders;
-                sortOrders.push_back({columnToSortBy.column->sqlId, isForwards});
+                sortOrders.push_back({columnToSortBy.column->sqlId, isForwards, columnToSortBy.column->typeHint});
 
                 if (m_currentNode->setSortOrder(sortOrders))
                 {
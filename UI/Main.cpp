@@ -1,6 +1,8 @@
 #include <Config/toml_backend.h>
+#include <Database/TrackLibrary.h>
 #include <UI/MainComponent.h>
 #include <UI/Settings.h>
+#include <Utils/TaskExecutor.h>
 #include <juce_audio_utils/juce_audio_utils.h>
 #include <juce_gui_basics/juce_gui_basics.h>
 #include <spdlog/sinks/basic_file_sink.h>
@@ -61,7 +63,12 @@ namespace jucyaudio
             {
                 // Add your application's shutdown code here..
 
-                mainWindow = nullptr; // (deletes our window)
+                mainWindow = nullptr; // (deletes our window, which stops the background task service)
+
+                // Everything that submits work to the executor is stopped first, so the executor is shut down last and
+                // the order in which the globals are destroyed no longer matters
+                database::theTrackLibrary.shutdown();
+                theTaskExecutor.shutdown();
             }
 
             //==============================================================================
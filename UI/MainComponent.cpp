@@ -1,6 +1,11 @@
+#include <Audio/LoudnessMeter.h>
 #include <Config/toml_backend.h>
 #include <Database/BackgroundService.h>
+#include <Database/BackgroundTasks/AnalysisBenchmark.h>
 #include <Database/BackgroundTasks/BpmAnalysis.h>
+#include <Database/BackgroundTasks/DatabaseMaintenance.h>
+#include <Database/BackgroundTasks/QueryPlanCheck.h>
+#include <Database/BackgroundTasks/StorageBenchmark.h>
 #include <Database/Nodes/MixNode.h>
 #include <Database/Nodes/RootNode.h>
 #include <UI/ColumnConfiguratorDialog.h>
@@ -36,6 +41,19 @@ namespace jucyaudio
             return MainViewType::DataView; // Default to DataView if no specific type matches
         }
 
+        database::StorageTuning storageTuningFromSettings()
+        {
+            const auto &storage = config::theSettings.database.storage;
+            database::StorageTuning tuning;
+            tuning.mmapSizeMiB = storage.mmapSizeMiB.get();
+            tuning.cacheSizeKiB = storage.cacheSizeKiB.get();
+            tuning.synchronous = storage.synchronous.get();
+            tuning.tempStore = storage.tempStore.get();
+            tuning.pageSize = storage.pageSize.get();
+            tuning.walAutoCheckpointPages = storage.walAutoCheckpointPages.get();
+            return tuning;
+        }
+
         MainComponent::MainComponent(juce::ApplicationCommandManager &commandManager)
             : MenuPresenter{commandManager},
               m_commandManager{commandManager},
@@ -58,11 +76,14 @@ namespace jucyaudio
             juce::File dbJuceFile{appDataDir.getChildFile("jucyaudio_library_dev.sqlite")};
             std::filesystem::path dbPath{dbJuceFile.getFullPathName().toStdString()};
 
-            if (theTrackLibrary.initialise(dbPath))
+            if (theTrackLibrary.initialise(dbPath, storageTuningFromSettings()))
             {
                 spdlog::info("TrackLibrary initialised successfully by "
                              "MainComponent for DB: {}",
                              dbPath.string());
+                theTrackLibrary.setColumnIndexEnabled(config::theSettings.database.inMemoryColumnIndex.get());
+                theTrackLibrary.setQueryProfiling(config::theSettings.database.queryProfiling.get(),
+                                                  std::chrono::milliseconds{config::theSettings.database.slowQueryMs.get()});
             }
             else
             {
@@ -272,8 +293,35 @@ namespace jucyaudio
             }
             menuManager.addSubMenu("View", "Theme", themeItems);
 
+            menuManager.registerMenu("Diagnostics", {{"Query Profile...", "...",
+                                                      [&]()
+                                                      {
+                                                          onShowQueryProfile();
+                                                      }},
+                                                     {"Reset Query Profile", "...",
+                                                      [&]()
+                                                      {
+                                                          onResetQueryProfile();
+                                                      }},
+                                                     {"Check Query Plans...", "...",
+                                                      [&]()
+                                                      {
+                                                          onRunQueryPlanCheck();
+                                                      }}});
+
             menuManager.registerMenu("Help",
                                      {
+                                         {"Run Analysis Benchmark...", "...",
+                                          [&]()
+                                          {
+                                              onRunAnalysisBenchmark();
+                                          }},
+                                         {"Run Storage Benchmark...", "...",
+                                          [&]()
+                                          {
+                                              onRunStorageBenchmark();
+                                          }},
+                                         {"-"},
                                          {"About...", "...",
                                           [&]()
                                           {
@@ -297,6 +345,21 @@ namespace jucyaudio
             setAudioChannels(0, 2); // Output only
 
             // Setup the background service (assuming it's a member m_backgroundService)
+            database::theBackgroundTaskService.setCpuBudget(config::theSettings.analysisSettings.cpuBudgetPercent.get());
+            if (theTrackLibrary.needsSchemaMigration())
+            {
+                // An older library is migrated with its progress on screen, once the window is up; background work
+                // waits until it is done
+                database::theBackgroundTaskService.pause();
+                juce::MessageManager::callAsync(
+                    [safeThis = juce::Component::SafePointer<MainComponent>{this}]()
+                    {
+                        if (safeThis)
+                        {
+                            safeThis->runSchemaMigration();
+                        }
+                    });
+            }
             database::theBackgroundTaskService.start();
 
             // Create and register our new BPM analysis task.
@@ -304,6 +367,10 @@ namespace jucyaudio
             auto *bpmTask = new database::background_tasks::BpmAnalysis{};
             database::theBackgroundTaskService.registerTask(bpmTask);
             bpmTask->release(REFCOUNT_DEBUG_ARGS);
+
+            auto *maintenanceTask = new database::background_tasks::DatabaseMaintenance{};
+            database::theBackgroundTaskService.registerTask(maintenanceTask);
+            maintenanceTask->release(REFCOUNT_DEBUG_ARGS);
         }
 
         MainComponent::~MainComponent()
@@ -615,6 +682,13 @@ namespace jucyaudio
                 {
                     m_dataViewComponent.setCurrentNode(m_currentSelectedDataNode); // DataView updates its content source
                     m_dataViewComponent.refreshView();                             // Tell DataView to redraw
+
+                    // Working sets and mixes shown in the table get analyzed before the rest of the library
+                    const auto *queryArgs{m_currentSelectedDataNode->getQueryArgs()};
+                    if (queryArgs && (queryArgs->workingSetId || queryArgs->mixId))
+                    {
+                        theTrackLibrary.boostAnalysisPriority(*queryArgs, AnalysisPriority::VisibleInTable);
+                    }
                 }
             }
             else
@@ -744,6 +818,9 @@ namespace jucyaudio
                 m_mainPlaybackAndStatusPanel.setStatusMessage(
                     getSafeDisplayText("Playing: " + audioFile.getFileName() + " from " + juce::String(startPosition, 1) + "s"), false);
 
+                const auto track{theTrackLibrary.getTrackDatabase()->getTrackByFilepath(jucePathToFs(audioFile.getFullPathName()))};
+                m_playbackController.setNormalizationGain(track ? audio::loudnessNormalizationGain(*track) : 1.0f);
+
                 if (!m_playbackController.loadAndPlayFileFromPosition(audioFile, startPosition))
                 {
                     m_mainPlaybackAndStatusPanel.setStatusMessage(getSafeDisplayText("Error playing: " + audioFile.getFileName()), true);
@@ -866,6 +943,7 @@ namespace jucyaudio
             {
                 // uncomment this line, and you get the exceptio
                 m_mainPlaybackAndStatusPanel.setStatusMessage(getSafeDisplayText("Playing: " + audioFile.getFileName()), false);
+                m_playbackController.setNormalizationGain(audio::loudnessNormalizationGain(*track));
                 if (!m_playbackController.loadAndPlayFile(audioFile))
                 {
                     m_mainPlaybackAndStatusPanel.setStatusMessage(getSafeDisplayText("Error playing: " + audioFile.getFileName()), true);
@@ -1368,6 +1446,88 @@ namespace jucyaudio
             return true;
         }
 
+        bool MainComponent::onShowQueryProfile()
+        {
+            const auto *trackDatabase = theTrackLibrary.getTrackDatabase();
+            if (!trackDatabase)
+            {
+                m_mainPlaybackAndStatusPanel.setStatusMessage("No library database open.", true);
+                return false;
+            }
+            if (!config::theSettings.database.queryProfiling.get())
+            {
+                m_mainPlaybackAndStatusPanel.setStatusMessage("Query profiling is turned off in the settings (Database/QueryProfiling).", true);
+            }
+
+            auto stats = trackDatabase->getQueryStats();
+            juce::AlertWindow::showOkCancelBox(juce::AlertWindow::InfoIcon, "Query Profile", describeQueryStats(stats, 15), "Export JSON...", "Close",
+                                               this,
+                                               juce::ModalCallbackFunction::create(
+                                                   [this, stats = std::move(stats)](int result)
+                                                   {
+                                                       if (result != 0)
+                                                       {
+                                                           onExportQueryProfile(stats);
+                                                       }
+                                                   }));
+            return true;
+        }
+
+        bool MainComponent::onRunQueryPlanCheck()
+        {
+            const auto *trackDatabase = theTrackLibrary.getTrackDatabase();
+            if (!trackDatabase)
+            {
+                m_mainPlaybackAndStatusPanel.setStatusMessage("No library database open.", true);
+                return false;
+            }
+
+            auto *task = new background_tasks::QueryPlanCheck{*trackDatabase};
+            TaskDialog::launch("Query Plan Check", task, {}, this);
+            task->release(REFCOUNT_DEBUG_ARGS);
+            return true;
+        }
+
+        void MainComponent::onExportQueryProfile(std::vector<database::QueryStats> stats)
+        {
+            m_activeFileChooser = std::make_unique<juce::FileChooser>(
+                "Export Query Profile As...", juce::File::getSpecialLocation(juce::File::userDocumentsDirectory).getChildFile("query_profile.json"),
+                "*.json", true, false, this);
+
+            const int chooserFlags =
+                juce::FileBrowserComponent::saveMode | juce::FileBrowserComponent::canSelectFiles | juce::FileBrowserComponent::warnAboutOverwriting;
+            m_activeFileChooser->launchAsync(chooserFlags,
+                                             [this, stats = std::move(stats)](const juce::FileChooser &chooser)
+                                             {
+                                                 const juce::File chosenFile = chooser.getResult();
+                                                 m_activeFileChooser.reset();
+                                                 if (chosenFile == juce::File{})
+                                                 {
+                                                     return;
+                                                 }
+                                                 if (chosenFile.replaceWithText(queryStatsToJson(stats)))
+                                                 {
+                                                     m_mainPlaybackAndStatusPanel.setStatusMessage("Query profile exported to " +
+                                                                                                   chosenFile.getFullPathName());
+                                                 }
+                                                 else
+                                                 {
+                                                     m_mainPlaybackAndStatusPanel.setStatusMessage("Cannot write " + chosenFile.getFullPathName(), true);
+                                                 }
+                                             });
+        }
+
+        bool MainComponent::onResetQueryProfile()
+        {
+            if (auto *trackDatabase = theTrackLibrary.getTrackDatabase())
+            {
+                trackDatabase->resetQueryStats();
+                m_mainPlaybackAndStatusPanel.setStatusMessage("Query profile reset.");
+                return true;
+            }
+            return false;
+        }
+
         bool MainComponent::onShowConfigureColumnsDialog()
         {
             using namespace config;
@@ -1461,14 +1621,28 @@ namespace jucyaudio
             {
             public:
                 DatabaseMaintenanceTask()
-                    : ILongRunningTask{"Performing Database Maintenance", false}
+                    : ILongRunningTask{"Performing Database Maintenance", true}
                 {
                 }
 
-                void run([[maybe_unused]] ProgressCallback progressCb, CompletionCallback completionCb, std::atomic<bool> &shouldCancel) override
+                void run(ProgressCallback progressCb, CompletionCallback completionCb, std::atomic<bool> &shouldCancel) override
                 {
-                    theTrackLibrary.runMaintenanceTasks(shouldCancel);
-                    completionCb(true, "Database maintenance completed successfully.");
+                    progressCb(-1, "Releasing free space and updating statistics...");
+                    const bool success = theTrackLibrary.runMaintenanceTasks(shouldCancel);
+                    if (shouldCancel)
+                    {
+                        completionCb(false, "Database maintenance cancelled.");
+                        return;
+                    }
+                    if (!success)
+                    {
+                        completionCb(false, "Database maintenance failed: " + theTrackLibrary.getLastError());
+                        return;
+                    }
+                    const auto report = theTrackLibrary.getTrackDatabase()->getSpaceReport();
+                    completionCb(true, std::format("Database maintenance completed successfully.\nFile size: {:.1f} MB, free: {:.1f} MB ({:.1f}%)",
+                                                   report.fileBytes() / (1024.0 * 1024.0), report.freeBytes() / (1024.0 * 1024.0),
+                                                   report.freeRatio() * 100.0));
                 }
             };
 
@@ -1478,5 +1652,72 @@ namespace jucyaudio
             return true;
         }
 
+        void MainComponent::runSchemaMigration()
+        {
+            class SchemaMigrationTask final : public ILongRunningTask
+            {
+            public:
+                SchemaMigrationTask()
+                    : ILongRunningTask{"Migrating the Library Database", true}
+                {
+                }
+
+                void run(ProgressCallback progressCb, CompletionCallback completionCb, std::atomic<bool> &shouldCancel) override
+                {
+                    progressCb(0, "Updating the library database to the current layout...");
+                    const bool success = theTrackLibrary.migrateSchema(progressCb, shouldCancel);
+                    // Paused while the tables were rebuilt; goes on with whichever layout the database has now
+                    theBackgroundTaskService.resume();
+                    if (success)
+                    {
+                        completionCb(true, "The library database was migrated successfully.");
+                    }
+                    else if (shouldCancel)
+                    {
+                        completionCb(false, "Migration cancelled. The library works as before and is migrated on the next start.");
+                    }
+                    else
+                    {
+                        completionCb(false, "Migration failed: " + theTrackLibrary.getLastError() +
+                                                "\nThe library works as before and is migrated on the next start.");
+                    }
+                }
+            };
+
+            auto *task = new SchemaMigrationTask{};
+            TaskDialog::launch("Library Database Migration", task, {}, this);
+            task->release(REFCOUNT_DEBUG_ARGS);
+        }
+
+        bool MainComponent::onRunAnalysisBenchmark()
+        {
+            // Results live next to the library database so baselines survive between runs
+            juce::File appDataDir{juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory).getChildFile("jucyaudioApp_Dev")};
+            if (!appDataDir.exists())
+            {
+                appDataDir.createDirectory();
+            }
+
+            auto *task = new background_tasks::AnalysisBenchmark{jucePathToFs(appDataDir.getFullPathName())};
+            TaskDialog::launch("Analysis Benchmark", task, {}, this);
+            task->release(REFCOUNT_DEBUG_ARGS);
+            return true;
+        }
+
+        bool MainComponent::onRunStorageBenchmark()
+        {
+            // The scratch database and the results go next to the library database, on the same disk
+            juce::File appDataDir{juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory).getChildFile("jucyaudioApp_Dev")};
+            if (!appDataDir.exists())
+            {
+                appDataDir.createDirectory();
+            }
+
+            auto *task = new background_tasks::StorageBenchmark{jucePathToFs(appDataDir.getFullPathName()), storageTuningFromSettings()};
+            TaskDialog::launch("Storage Benchmark", task, {}, this);
+            task->release(REFCOUNT_DEBUG_ARGS);
+            return true;
+        }
+
     } // namespace ui
 } // namespace jucyaudio
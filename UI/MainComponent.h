@@ -90,6 +90,13 @@ namespace jucyaudio
             // menu management --------------------------------
             bool onShowScanDialog();
             bool onShowMaintenanceDialog();
+            void runSchemaMigration();
+            bool onRunAnalysisBenchmark();
+            bool onRunStorageBenchmark();
+            bool onShowQueryProfile();
+            void onExportQueryProfile(std::vector<database::QueryStats> stats);
+            bool onResetQueryProfile();
+            bool onRunQueryPlanCheck();
             bool onShowConfigureColumnsDialog();
             bool onShowAboutDialog();
             bool onApplyThemeByIndex(size_t themeIndex);
@@ -1,10 +1,79 @@
 #include <UI/MainPlaybackAndStatusComponent.h>
 #include <UI/MainComponent.h>
+#include <Utils/AssortedUtils.h>
+#include <Utils/TaskExecutor.h>
+#include <Utils/UiUtils.h>
+#include <cctype>
+#include <format>
+#include <fstream>
+#include <map>
 
 namespace jucyaudio
 {
     namespace ui
     {
+        namespace
+        {
+            constexpr int METRICS_REFRESH_MS = 1000;
+            constexpr int METRICS_DUMP_TICKS = 10; // background_metrics.json is rewritten every 10 s
+
+            std::string formatEta(std::chrono::seconds eta)
+            {
+                const auto seconds = eta.count();
+                if (seconds < 60)
+                    return std::format("{}s", seconds);
+                if (seconds < 3600)
+                    return std::format("{}m", seconds / 60);
+                return std::format("{}h {:02}m", seconds / 3600, (seconds % 3600) / 60);
+            }
+
+            // e.g. "Analysis: 1,234 queued, 0.80/s (1m), 0.72/s (5m), ETA 28m, 3 failed | cpu 42%  background 97%  io 3%"
+            juce::String describeMetrics(const database::BackgroundMetricsSnapshot &snapshot)
+            {
+                std::string text;
+                for (const auto &metrics : snapshot.jobTypes)
+                {
+                    std::string name = database::getJobTypeName(metrics.type);
+                    name[0] = static_cast<char>(std::toupper(name[0]));
+                    text += std::format("{}: {:L} queued, {:.2f}/s (1m), {:.2f}/s (5m)", name, metrics.queueDepth, metrics.itemsPerSecond1m,
+                                        metrics.itemsPerSecond5m);
+                    if (metrics.eta)
+                        text += ", ETA " + formatEta(*metrics.eta);
+                    if (metrics.failedJobs > 0)
+                        text += std::format(", {:L} failed", metrics.failedJobs);
+                    text += " | ";
+                }
+
+                // One figure per pool keeps the line short; the tooltip has every worker
+                std::map<std::string, std::pair<double, int>> pools;
+                for (const auto &worker : snapshot.workers)
+                {
+                    auto &pool = pools[worker.pool];
+                    pool.first += worker.utilization;
+                    ++pool.second;
+                }
+                for (const auto &[name, pool] : pools)
+                {
+                    text += std::format("{} {:.0f}%  ", name, 100.0 * pool.first / pool.second);
+                }
+                return juce::String{text}.trimEnd();
+            }
+
+            juce::String describeWorkers(const database::BackgroundMetricsSnapshot &snapshot)
+            {
+                std::string text;
+                for (const auto &metrics : snapshot.jobTypes)
+                {
+                    text += std::format("{}: {:L} completed, {:L} failed attempts this session\n", database::getJobTypeName(metrics.type), metrics.completed,
+                                        metrics.failures);
+                }
+                for (const auto &worker : snapshot.workers)
+                {
+                    text += std::format("\n{} worker {}: {:.0f}%{}", worker.pool, worker.index, 100.0 * worker.utilization, worker.busy ? " (busy)" : "");
+                }
+                return juce::String{text};
+            }
+        } // namespace
 
         MainPlaybackAndStatusComponent::MainPlaybackAndStatusComponent(MainComponent &owner)
             : m_ownerMainComponent{owner},
@@ -19,13 +88,58 @@ namespace jucyaudio
             m_statusLabel.setJustificationType(juce::Justification::centredLeft);
             m_statusLabel.setColour(juce::Label::textColourId, juce::Colours::lightgrey); // Example initial color
             addAndMakeVisible(m_statusLabel);
+
+            m_backgroundMetricsLabel.setJustificationType(juce::Justification::centredRight);
+            m_backgroundMetricsLabel.setColour(juce::Label::textColourId, juce::Colours::grey);
+            m_backgroundMetricsLabel.setMinimumHorizontalScale(0.7f);
+            addAndMakeVisible(m_backgroundMetricsLabel);
+
+            // Monitoring scripts read the same metrics from the application data folder
+            const juce::File appDataDir{juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory).getChildFile("jucyaudioApp_Dev")};
+            m_metricsDumpFile = jucePathToFs(appDataDir.getChildFile("background_metrics.json").getFullPathName());
+
+            m_lastMetrics = database::theBackgroundMetrics.snapshot();
+            startTimer(METRICS_REFRESH_MS);
         }
 
         MainPlaybackAndStatusComponent::~MainPlaybackAndStatusComponent()
         {
+            stopTimer();
             // Child components (m_playbackToolbar, m_statusLabel) are destroyed automatically
         }
 
+        void MainPlaybackAndStatusComponent::timerCallback()
+        {
+            // Only atomics are read here, so a busy background worker never stalls the UI
+            auto metrics = database::theBackgroundMetrics.snapshot(&m_lastMetrics);
+            m_backgroundMetricsLabel.setText(describeMetrics(metrics), juce::dontSendNotification);
+            m_backgroundMetricsLabel.setTooltip(describeWorkers(metrics));
+
+            if (++m_ticksSinceMetricsDump >= METRICS_DUMP_TICKS)
+            {
+                m_ticksSinceMetricsDump = 0;
+                // Write to a temporary file and rename, so a script never reads half a document
+                theTaskExecutor.submit(TaskLane::Io, TaskPriority::Background,
+                                       [json = database::BackgroundMetrics::toJson(metrics), path = m_metricsDumpFile]()
+                                       {
+                                           auto temporary = path;
+                                           temporary += ".tmp";
+                                           {
+                                               std::ofstream out{temporary};
+                                               out << json;
+                                               if (!out)
+                                               {
+                                                   spdlog::warn("Cannot write background metrics to {}", pathToString(temporary));
+                                                   return;
+                                               }
+                                           }
+                                           std::error_code ec;
+                                           std::filesystem::rename(temporary, path, ec);
+                                       });
+            }
+            m_lastMetrics = std::move(metrics);
+        }
+
         void MainPlaybackAndStatusComponent::paint(juce::Graphics &g)
         {
             // Fill background for the entire panel
@@ -64,14 +178,17 @@ namespace jucyaudio
             // Playback toolbar at the top of this panel's area
             m_playbackToolbar.setBounds(bounds.removeFromTop(toolbarHeight).reduced(padding, 0));
 
-            // Status label below it, if there's space
+            // Status label below it, if there's space; the background metrics share its row on the right
             if (statusLabelHeight > 0)
             {
-                m_statusLabel.setBounds(bounds.reduced(padding));
+                auto statusRow = bounds.reduced(padding);
+                m_backgroundMetricsLabel.setBounds(statusRow.removeFromRight(statusRow.getWidth() * 3 / 5));
+                m_statusLabel.setBounds(statusRow);
             }
             else
             {
                 m_statusLabel.setBounds({}); // Collapse if no space
+                m_backgroundMetricsLabel.setBounds({});
             }
 
             /*
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <Database/BackgroundMetrics.h>
 #include <UI/PlaybackToolbarComponent.h>
 #include <juce_gui_basics/juce_gui_basics.h>
 #include <juce_graphics/juce_graphics.h>
@@ -12,7 +13,8 @@ namespace jucyaudio
         class MainComponent;
         // PlaybackController is not directly needed by MainPlaybackAndStatusComponent's interface now
 
-        class MainPlaybackAndStatusComponent : public juce::Component
+        class MainPlaybackAndStatusComponent : public juce::Component,
+                                               private juce::Timer
         {
         public:
             explicit MainPlaybackAndStatusComponent(MainComponent &owner);
@@ -34,9 +36,16 @@ namespace jucyaudio
             }
 
         private:
+            // Refreshes the background metrics line; every few ticks also writes them to m_metricsDumpFile
+            void timerCallback() override;
+
             MainComponent &m_ownerMainComponent;
             PlaybackToolbarComponent& m_playbackToolbar; 
             juce::Label m_statusLabel;
+            juce::Label m_backgroundMetricsLabel;
+            database::BackgroundMetricsSnapshot m_lastMetrics;
+            std::filesystem::path m_metricsDumpFile;
+            int m_ticksSinceMetricsDump{0};
 
             JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MainPlaybackAndStatusComponent)
         };
@@ -66,6 +66,12 @@ namespace jucyaudio
             m_mixProjectLoader.loadMix(mixId);
             m_timeline.populateFrom(m_mixProjectLoader);
             spdlog::info("Mix loaded with {} tracks", m_mixProjectLoader.getMixTracks().size());
+
+            // Tracks in the open mix jump ahead of the rest of the library in the analysis queue
+            database::TrackQueryArgs args;
+            args.mixId = mixId;
+            args.usePaging = false;
+            database::theTrackLibrary.boostAnalysisPriority(args, database::AnalysisPriority::OpenInEditor);
         }
 
         void MixEditorComponent::resized()
@@ -3,6 +3,7 @@
 #include <UI/MixTrackComponent.h>
 #include <UI/TimelineComponent.h>
 #include <Utils/AssortedUtils.h>
+#include <algorithm>
 #include <spdlog/spdlog.h>
 
 namespace jucyaudio
@@ -17,6 +18,16 @@ namespace jucyaudio
         {
             // Setup the info label
             juce::String bpmText = trackInfo.bpm.has_value() ? juce::String(trackInfo.bpm.value() / 100.0, 1) + " BPM" : "--- BPM";
+            if (trackInfo.tempo_map.size() > 1)
+            {
+                // Tempo drifts: show the range so beat-matching around the transition points is not a surprise
+                const auto [minSegment, maxSegment] = std::minmax_element(trackInfo.tempo_map.begin(), trackInfo.tempo_map.end(),
+                                                                          [](const auto &a, const auto &b)
+                                                                          {
+                                                                              return a.bpm < b.bpm;
+                                                                          });
+                bpmText += ", " + juce::String(minSegment->bpm, 1) + "-" + juce::String(maxSegment->bpm, 1);
+            }
 
             juce::String infoText = juce::String(trackInfo.title) + " (" + bpmText + ")";
             m_infoLabel.setText(infoText, juce::dontSendNotification);
@@ -356,7 +356,14 @@ namespace jucyaudio
 
         void PlaybackController::setGain(float newGain)
         {
-            m_audioTransportSource.setGain(newGain);
+            m_userGain = newGain;
+            m_audioTransportSource.setGain(m_userGain * m_normalizationGain);
+        }
+
+        void PlaybackController::setNormalizationGain(float newGain)
+        {
+            m_normalizationGain = newGain;
+            m_audioTransportSource.setGain(m_userGain * m_normalizationGain);
         }
 
         bool PlaybackController::isPlaying() const
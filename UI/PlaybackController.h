@@ -46,6 +46,7 @@ namespace jucyaudio
 
             void seek(double positionSeconds);
             void setGain(float newGain); // 0.0 to 1.0 (or higher)
+            void setNormalizationGain(float newGain); // per-track loudness normalization, multiplied with the user gain
 
             // --- State Query Methods ---
             bool isPlaying() const;
@@ -82,6 +83,8 @@ namespace jucyaudio
             int m_deviceBlockSize{0};
             bool m_isDevicePrepared{false};
             juce::File m_currentFile; // Keep track of the currently loaded file
+            float m_userGain{1.0f};
+            float m_normalizationGain{1.0f};
             State m_currentState{State::Stopped};
             PlaybackToolbarComponent &m_playbackToolbar;
 
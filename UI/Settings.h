@@ -46,9 +46,45 @@ namespace jucyaudio
                 }
 
                 TypedValue<std::string> filename{this, "Filename", ""};
+                // Sort and filter the track lists from an in-memory copy of their columns, loaded at startup
+                TypedValue<bool> inMemoryColumnIndex{this, "InMemoryColumnIndex", true};
+                // Per-statement cost statistics (Diagnostics menu), off by default since it traces every statement;
+                // statements taking at least SlowQueryMs are logged with their query plan, 0 logs none
+                TypedValue<bool> queryProfiling{this, "QueryProfiling", false};
+                TypedValue<int> slowQueryMs{this, "SlowQueryMs", 100};
+
+                // SQLite storage tuning, applied when the library is opened; the defaults are SQLite's own. The storage
+                // benchmark (Help menu) measures the candidates on this machine.
+                struct StorageSettings : public Section
+                {
+                    StorageSettings(Section *parent)
+                        : Section{parent, "Storage"}
+                    {
+                    }
+
+                    TypedValue<int> mmapSizeMiB{this, "MmapSizeMiB", 0};
+                    TypedValue<int> cacheSizeKiB{this, "CacheSizeKiB", 2000};
+                    TypedValue<std::string> synchronous{this, "Synchronous", "FULL"};       // OFF, NORMAL, FULL, EXTRA
+                    TypedValue<std::string> tempStore{this, "TempStore", "DEFAULT"};         // DEFAULT, FILE, MEMORY
+                    TypedValue<int> pageSize{this, "PageSize", 4096};                        // new databases only
+                    TypedValue<int> walAutoCheckpointPages{this, "WalAutoCheckpointPages", 1000};
+
+                } storage{this};
 
             } database{this};
 
+            struct AnalysisSettings : public Section
+            {
+                AnalysisSettings(Section *parent)
+                    : Section{parent, "Analysis"}
+                {
+                }
+
+                // Share of one core background analysis may use, 1-100; it also runs at idle thread priority
+                TypedValue<int> cpuBudgetPercent{this, "CpuBudgetPercent", 50};
+
+            } analysisSettings{this};
+
             struct UiSettings : public Section
             {
                 UiSettings(Section *parent)
@@ -80,31 +80,28 @@ namespace jucyaudio
             stopTimer(); // Stop any JUCE timers associated with this component
 
             // Signal cancellation to the running task if it's still considered running
-            // from the UI's perspective OR if the thread is joinable (meaning it might still be finishing up).
-            if (m_taskIsRunning.load() || m_taskThread.joinable())
+            // from the UI's perspective OR if it was submitted (it might still be finishing up).
+            if (m_taskIsRunning.load() || m_taskDone.valid())
             {
-                m_shouldCancel = true;
+                m_cancellation.cancel();
                 spdlog::info("TaskDialog: Signalled cancel to thread for task: {}", m_task ? m_task->m_taskName : "UNKNOWN_OR_NULL");
             }
 
-            if (m_taskThread.joinable())
+            // A job that has not started is claimed here, so it will not run: there is nothing to wait for, and waiting
+            // for its turn in the lane would block the message thread behind whatever the lane is busy with
+            if (m_taskDone.valid() && !m_jobClaimed->exchange(true))
             {
-                spdlog::info("TaskDialog: Attempting to join task thread for: {}", m_task ? m_task->m_taskName : "UNKNOWN_OR_NULL");
-                try
-                {
-                    m_taskThread.join(); // Wait for the thread to complete
-                    spdlog::info("TaskDialog: Task thread joined successfully for: {}", m_task ? m_task->m_taskName : "UNKNOWN_OR_NULL");
-                }
-                catch (const std::system_error &e)
-                {
-                    spdlog::error("TaskDialog: Exception while joining task thread: {}", e.what());
-                    // Potentially detach if join fails and app needs to close, but this can be risky.
-                    // If join throws, it often means the thread wasn't joinable (e.g., already finished and joined, or detached).
-                }
+                spdlog::info("TaskDialog: Task had not started, dropping it: {}", m_task ? m_task->m_taskName : "UNKNOWN_OR_NULL");
+            }
+            else if (m_taskDone.valid())
+            {
+                spdlog::info("TaskDialog: Waiting for task to finish: {}", m_task ? m_task->m_taskName : "UNKNOWN_OR_NULL");
+                m_taskDone.wait();
+                spdlog::info("TaskDialog: Task finished for: {}", m_task ? m_task->m_taskName : "UNKNOWN_OR_NULL");
             }
             else
             {
-                spdlog::info("TaskDialog: Task thread was not joinable for: {}", m_task ? m_task->m_taskName : "UNKNOWN_OR_NULL");
+                spdlog::info("TaskDialog: Task was never started for: {}", m_task ? m_task->m_taskName : "UNKNOWN_OR_NULL");
             }
 
             if (m_task)
@@ -151,13 +148,20 @@ namespace jucyaudio
         void TaskDialog::startTask()
         {
             // ... (initial setup) ...
-            m_taskIsRunning = true; // Set this before starting thread
-
-            m_taskThread = std::thread(
-                [this, taskPtr = m_task]
+            m_taskIsRunning = true; // Set this before submitting the task
+
+            // Dialog tasks are what the user is waiting for, so they go ahead of anything else in their lane. The job
+            // and the dialog race to claim it: a job claimed by the dialog (cancelled or closed before it started)
+            // returns without touching the dialog, which completes itself. The executor skips it on m_cancellation.
+            m_taskDone = theTaskExecutor.submit(
+                m_task->m_lane, TaskPriority::Interactive,
+                [this, taskPtr = m_task, claimed = m_jobClaimed]
                 {
+                    if (claimed->exchange(true))
+                        return;
+
                     bool cb_called_by_task = false;
-                    std::atomic<bool> *shouldCancelPtr = &m_shouldCancel; // Capture pointer to atomic
+                    std::atomic<bool> *shouldCancelPtr = &m_cancellation.flag(); // Capture pointer to atomic
 
                     // Create a ComponentSafePointer to 'this' for safer async calls if needed AFTER run()
                     // However, completion should ideally be the last thing.
@@ -237,9 +241,8 @@ namespace jucyaudio
                     {
                         spdlog::warn("TaskDialog: Task '{}' finished run() without calling completion callback. Triggering fallback.", taskPtr->m_taskName);
 
-                        // Capture the CURRENT state of m_shouldCancel by value for this async call.
-                        // m_shouldCancel is a member std::atomic<bool>.
-                        bool was_cancelled_at_this_point = m_shouldCancel.load(); // Read the atomic's value
+                        // Capture the CURRENT state of the cancellation flag by value for this async call.
+                        bool was_cancelled_at_this_point = m_cancellation.isCancelled(); // Read the atomic's value
 
                         juce::MessageManager::callAsync(
                             [this, cancelled_flag = was_cancelled_at_this_point, task_name_capture = taskPtr->m_taskName]() { // Capture by value
@@ -254,7 +257,8 @@ namespace jucyaudio
 
                     // Signal that the thread's main work is done. The UI thread will handle m_taskIsRunning.
                     // No more direct manipulation of 'this' members from here.
-                });
+                },
+                m_cancellation);
         }
 
         void TaskDialog::handleProgressUpdate(int progressPercent, const std::string& statusMessage)
@@ -353,7 +357,13 @@ namespace jucyaudio
                 spdlog::info("TaskDialog: buttonClicked called");
                 if (m_taskIsRunning.load() && !m_taskHasCompleted.load() && m_task && m_task->m_isCancellable)
                 {
-                    m_shouldCancel = true;
+                    m_cancellation.cancel();
+                    if (!m_jobClaimed->exchange(true))
+                    {
+                        // Still queued behind other work in its lane: it will not run, so nothing else completes it
+                        handleTaskCompleted(false, "Cancelled before it started.");
+                        return;
+                    }
                     m_actionButton.setEnabled(false);
                     m_statusLabel.setText("Cancelling...", juce::dontSendNotification);
                 }
@@ -3,10 +3,12 @@
 #include <juce_gui_basics/juce_gui_basics.h>
 #include <juce_graphics/juce_graphics.h>
 #include <Database/Includes/ILongRunningTask.h> // Your updated, IRefCounted interface
+#include <Utils/TaskExecutor.h>
 #include <atomic>
 #include <functional> // For std::function
+#include <future>
+#include <memory>
 #include <optional>
-#include <thread>
 
 namespace jucyaudio
 {
@@ -52,14 +54,16 @@ namespace jucyaudio
             juce::TextButton m_actionButton;
 
             // Task execution state
-            std::atomic<bool> m_shouldCancel{false};
+            CancellationToken m_cancellation;
             std::atomic<bool> m_taskIsRunning{false};
             std::atomic<bool> m_taskHasCompleted{false};
             std::atomic<bool> m_finalTaskSuccessState{false};
             bool m_isProgressBarDeterminate{false};
 
-            // Threading
-            std::thread m_taskThread;
+            // Threading: the task runs on theTaskExecutor; this becomes ready when it has returned
+            std::future<void> m_taskDone;
+            // Set by whichever comes first: the job starting, or the dialog giving up on it before that
+            std::shared_ptr<std::atomic<bool>> m_jobClaimed = std::make_shared<std::atomic<bool>>(false);
 
             JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TaskDialog)
         };
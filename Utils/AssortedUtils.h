@@ -113,7 +113,7 @@ namespace jucyaudio
      * @return UTF-8 string representation
      * @note Assumes input string contains valid UTF-8 data
      */
-    inline std::u8string u8FromString(const std::string &str)
+    inline std::u8string u8FromString(std::string_view str)
     {
         return std::u8string(reinterpret_cast<const char8_t *>(str.data()), str.size());
     }
@@ -141,7 +141,7 @@ namespace jucyaudio
      * @return std::filesystem::path object
      * @note Handles UTF-8 encoding properly for cross-platform compatibility
      */
-    inline std::filesystem::path pathFromString(const std::string &str)
+    inline std::filesystem::path pathFromString(std::string_view str)
     {
         return std::filesystem::path{u8FromString(str)};
     }
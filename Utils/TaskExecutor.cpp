@@ -0,0 +1,281 @@
+/*
+ * This file is part of jucyaudio.
+ * Copyright (C) 2025 Gerson Kurz <not@p-nand-q.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <Utils/TaskExecutor.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <pthread.h>
+#include <sys/qos.h>
+#elif defined(__linux__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace jucyaudio
+{
+    TaskExecutor theTaskExecutor;
+
+    namespace
+    {
+        int64_t steadyNanos()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        // Set for the lifetime of a worker thread, so jobs submitted from a CPU worker land in its own queue
+        thread_local const void *t_workerPool = nullptr;
+        thread_local size_t t_workerQueue = 0;
+
+        // Background work should never compete with playback or the UI. This is one-way on Linux (an unprivileged
+        // thread cannot raise its nice value again), which is why background jobs get workers of their own.
+        void lowerCurrentThreadPriority()
+        {
+#if defined(_WIN32)
+            if (!SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN))
+            {
+                spdlog::warn("TaskExecutor: cannot lower thread priority ({})", GetLastError());
+            }
+#elif defined(__APPLE__)
+            pthread_set_qos_class_self_np(QOS_CLASS_BACKGROUND, 0);
+#elif defined(__linux__)
+            // On Linux nice values are per thread
+            if (setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 19) != 0)
+            {
+                spdlog::warn("TaskExecutor: cannot lower thread priority");
+            }
+#endif
+        }
+    } // namespace
+
+    TaskExecutor::~TaskExecutor()
+    {
+        shutdown();
+    }
+
+    void TaskExecutor::startWorkers()
+    {
+        // Leave one core for the UI and the audio callback
+        const size_t cores = std::max(1u, std::thread::hardware_concurrency());
+        const size_t cpuWorkers = std::max<size_t>(1, cores - 1);
+
+        startPool(m_cpuPool, cpuWorkers, true);
+        startPool(m_backgroundPool, 1, false);
+        startPool(m_ioPool, IO_WORKER_COUNT, false);
+        spdlog::info("TaskExecutor: started {} CPU, 1 background and {} I/O workers", cpuWorkers, IO_WORKER_COUNT);
+    }
+
+    void TaskExecutor::startPool(Pool &pool, size_t workerCount, bool queuePerWorker)
+    {
+        const size_t queueCount = queuePerWorker ? workerCount : 1;
+        for (size_t i = 0; i < queueCount; ++i)
+        {
+            pool.queues.push_back(std::make_unique<JobQueue>());
+        }
+        pool.stats = std::make_unique<WorkerStats[]>(workerCount);
+        pool.statsCount.store(workerCount, std::memory_order_release);
+        for (size_t i = 0; i < workerCount; ++i)
+        {
+            pool.threads.emplace_back(&TaskExecutor::workerLoop, this, std::ref(pool), queuePerWorker ? i : 0, i);
+        }
+    }
+
+    TaskExecutor::Pool &TaskExecutor::poolFor(TaskLane lane, TaskPriority priority)
+    {
+        if (lane == TaskLane::Io)
+            return m_ioPool;
+        return priority == TaskPriority::Background ? m_backgroundPool : m_cpuPool;
+    }
+
+    std::future<void> TaskExecutor::submit(TaskLane lane, TaskPriority priority, Job job, CancellationToken token)
+    {
+        auto done = std::make_shared<std::promise<void>>();
+        auto future = done->get_future();
+
+        // Checked and pushed under the lock shutdown() sets m_stopping under: a job is either queued before shutdown()
+        // drains the queues, or completed right here
+        const std::lock_guard<std::mutex> submitLock(m_submitMutex);
+        if (m_stopping)
+        {
+            done->set_value();
+            return future;
+        }
+        std::call_once(m_started,
+                       [this]()
+                       {
+                           startWorkers();
+                       });
+
+        Pool &pool = poolFor(lane, priority);
+        // A CPU worker submitting follow-up work keeps it local; everyone else spreads jobs round-robin and lets idle
+        // workers steal
+        const size_t queueIndex =
+            (t_workerPool == &pool) ? t_workerQueue : pool.nextQueue.fetch_add(1, std::memory_order_relaxed) % pool.queues.size();
+        {
+            JobQueue &queue = *pool.queues[queueIndex];
+            const std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.byPriority[static_cast<size_t>(priority)].push_back({std::move(job), std::move(token), std::move(done)});
+        }
+        {
+            const std::lock_guard<std::mutex> lock(pool.sleepMutex);
+            ++pool.pending;
+        }
+        pool.wake.notify_one();
+        return future;
+    }
+
+    bool TaskExecutor::takeJob(Pool &pool, size_t ownQueue, PendingJob &job)
+    {
+        const size_t queueCount = pool.queues.size();
+        for (size_t p = PRIORITY_COUNT; p-- > 0;)
+        {
+            // Own queue newest-first (its data is still warm in this core's cache), other queues oldest-first
+            for (size_t k = 0; k < queueCount; ++k)
+            {
+                JobQueue &queue = *pool.queues[(ownQueue + k) % queueCount];
+                const std::lock_guard<std::mutex> lock(queue.mutex);
+                auto &jobs = queue.byPriority[p];
+                if (jobs.empty())
+                    continue;
+
+                const bool ownWorkStealingQueue = (k == 0) && queueCount > 1;
+                if (ownWorkStealingQueue)
+                {
+                    job = std::move(jobs.back());
+                    jobs.pop_back();
+                }
+                else
+                {
+                    job = std::move(jobs.front());
+                    jobs.pop_front();
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void TaskExecutor::workerLoop(Pool &pool, size_t ownQueue, size_t workerIndex)
+    {
+        WorkerStats &stats = pool.stats[workerIndex];
+        t_workerPool = &pool;
+        t_workerQueue = ownQueue;
+        if (pool.lowPriority)
+        {
+            lowerCurrentThreadPriority();
+        }
+
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(pool.sleepMutex);
+                pool.wake.wait(lock,
+                               [this, &pool]()
+                               {
+                                   return m_stopping.load() || pool.pending > 0;
+                               });
+                if (m_stopping)
+                    break;
+                --pool.pending;
+            }
+
+            // pending counts jobs in any of the pool's queues, so one is there to take
+            PendingJob job;
+            if (!takeJob(pool, ownQueue, job))
+                continue;
+
+            if (!job.token.isCancelled())
+            {
+                const int64_t started = steadyNanos();
+                stats.busySinceNanos.store(started, std::memory_order_relaxed);
+                try
+                {
+                    job.job();
+                }
+                catch (const std::exception &e)
+                {
+                    spdlog::error("TaskExecutor: {} job threw an exception: {}", pool.name, e.what());
+                }
+                catch (...)
+                {
+                    spdlog::error("TaskExecutor: {} job threw an unknown exception", pool.name);
+                }
+                // Clear the running mark first: a reader in between undercounts for an instant instead of counting twice
+                stats.busySinceNanos.store(0, std::memory_order_relaxed);
+                stats.busyNanos.fetch_add(steadyNanos() - started, std::memory_order_relaxed);
+            }
+            job.done->set_value();
+        }
+    }
+
+    std::vector<WorkerLoad> TaskExecutor::getWorkerLoads() const
+    {
+        std::vector<WorkerLoad> loads;
+        const int64_t now = steadyNanos();
+        for (const Pool *pool : {&m_cpuPool, &m_backgroundPool, &m_ioPool})
+        {
+            const size_t count = pool->statsCount.load(std::memory_order_acquire);
+            for (size_t i = 0; i < count; ++i)
+            {
+                const WorkerStats &stats = pool->stats[i];
+                const int64_t busySince = stats.busySinceNanos.load(std::memory_order_relaxed);
+                int64_t busy = stats.busyNanos.load(std::memory_order_relaxed);
+                if (busySince != 0)
+                    busy += std::max<int64_t>(0, now - busySince);
+                loads.push_back({pool->name, i, std::chrono::nanoseconds{busy}, busySince != 0});
+            }
+        }
+        return loads;
+    }
+
+    void TaskExecutor::shutdown()
+    {
+        {
+            const std::lock_guard<std::mutex> submitLock(m_submitMutex);
+            if (m_stopping.exchange(true))
+                return;
+        }
+
+        for (Pool *pool : {&m_cpuPool, &m_backgroundPool, &m_ioPool})
+        {
+            {
+                const std::lock_guard<std::mutex> lock(pool->sleepMutex);
+            }
+            pool->wake.notify_all();
+            for (auto &thread : pool->threads)
+            {
+                if (thread.joinable())
+                    thread.join();
+            }
+            // Anyone waiting on a dropped job must not hang
+            for (auto &queue : pool->queues)
+            {
+                for (auto &jobs : queue->byPriority)
+                {
+                    for (auto &job : jobs)
+                        job.done->set_value();
+                    jobs.clear();
+                }
+            }
+        }
+    }
+} // namespace jucyaudio
@@ -0,0 +1,196 @@
+/*
+ * This file is part of jucyaudio.
+ * Copyright (C) 2025 Gerson Kurz <not@p-nand-q.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @file TaskExecutor.h
+ * @brief Process-wide thread pool shared by scanning, analysis, export and the other long-running jobs
+ *
+ * All subsystems submit to theTaskExecutor instead of starting their own threads, so running a scan, the
+ * background analysis and an export at the same time cannot oversubscribe the machine:
+ *
+ * - TaskLane::Cpu jobs run on one worker per core minus one (left for the UI and the audio callback). Each
+ *   worker owns a deque per priority; it pops its own newest job and steals the oldest job of a busy worker
+ *   when it runs dry.
+ * - TaskPriority::Background CPU jobs never compete with that: they go to a single worker that runs at
+ *   idle OS priority, so at most one core of idle time goes to background analysis.
+ * - TaskLane::Io jobs (file system walks, database maintenance) run on a small separate set of workers,
+ *   because they spend most of their time blocked and would otherwise hold CPU workers hostage.
+ *
+ * Within a lane, higher priorities always run first.
+ */
+
+namespace jucyaudio
+{
+    enum class TaskLane
+    {
+        Cpu,
+        Io,
+    };
+
+    enum class TaskPriority
+    {
+        Background = 0,
+        Normal = 1,
+        Interactive = 2,
+    };
+
+    /**
+     * @brief Shared cancellation flag. Copies refer to the same flag.
+     *
+     * A job whose token is cancelled before it starts is skipped; a running job polls isCancelled() (or hands
+     * flag() to APIs that take a std::atomic<bool>&) and stops on its own.
+     */
+    class CancellationToken
+    {
+    public:
+        CancellationToken()
+            : m_flag{std::make_shared<std::atomic<bool>>(false)}
+        {
+        }
+
+        void cancel() const
+        {
+            *m_flag = true;
+        }
+
+        bool isCancelled() const
+        {
+            return m_flag->load();
+        }
+
+        std::atomic<bool> &flag() const
+        {
+            return *m_flag;
+        }
+
+    private:
+        std::shared_ptr<std::atomic<bool>> m_flag;
+    };
+
+    /// @brief How much one worker thread has worked so far; see TaskExecutor::getWorkerLoads().
+    struct WorkerLoad
+    {
+        const char *pool;                  ///< "cpu", "background" or "io"
+        size_t index;                      ///< Worker number within the pool
+        std::chrono::nanoseconds busyTime; ///< Total time spent running jobs, including the current one
+        bool busy;                         ///< Running a job right now
+    };
+
+    class TaskExecutor final
+    {
+    public:
+        using Job = std::function<void()>;
+
+        TaskExecutor() = default;
+        ~TaskExecutor();
+
+        TaskExecutor(const TaskExecutor &) = delete;
+        TaskExecutor &operator=(const TaskExecutor &) = delete;
+
+        /**
+         * @brief Queues a job. Workers are started on first use.
+         * @return A future that becomes ready when the job has finished, was skipped because its token was
+         *         cancelled, or was dropped by shutdown(). Exceptions thrown by the job are logged, not propagated.
+         */
+        std::future<void> submit(TaskLane lane, TaskPriority priority, Job job, CancellationToken token = {});
+
+        /// @brief Stops all workers after their current job; queued jobs are dropped (their futures still complete),
+        /// and so is anything submitted afterwards. The application calls this on exit, after everything that submits
+        /// work has stopped, so the destructor of the global instance has nothing left to do.
+        void shutdown();
+
+        /// @brief Busy time of every worker, for utilization displays. Lock-free, so the UI thread can poll it;
+        /// utilization is the busyTime difference between two calls divided by the time between them. Empty until
+        /// the first job was submitted.
+        std::vector<WorkerLoad> getWorkerLoads() const;
+
+    private:
+        static constexpr size_t PRIORITY_COUNT = 3;
+        static constexpr size_t IO_WORKER_COUNT = 2;
+
+        struct PendingJob
+        {
+            Job job;
+            CancellationToken token;
+            std::shared_ptr<std::promise<void>> done;
+        };
+
+        struct JobQueue
+        {
+            std::mutex mutex;
+            std::array<std::deque<PendingJob>, PRIORITY_COUNT> byPriority;
+        };
+
+        // Written only by its own worker; steady-clock nanoseconds
+        struct WorkerStats
+        {
+            std::atomic<int64_t> busyNanos{0};
+            std::atomic<int64_t> busySinceNanos{0}; // start of the running job, 0 while idle
+        };
+
+        // A set of workers with their queues: the CPU pool has one queue per worker and steals between them, the
+        // background and I/O pools share a single queue.
+        struct Pool
+        {
+            explicit Pool(const char *poolName, bool bLowPriority = false)
+                : name{poolName},
+                  lowPriority{bLowPriority}
+            {
+            }
+
+            const char *name;
+            bool lowPriority;
+            std::vector<std::unique_ptr<JobQueue>> queues;
+            std::vector<std::thread> threads;
+            std::mutex sleepMutex;
+            std::condition_variable wake;
+            size_t pending{0}; // jobs queued but not yet taken, guarded by sleepMutex
+            std::atomic<size_t> nextQueue{0};
+            std::unique_ptr<WorkerStats[]> stats;
+            std::atomic<size_t> statsCount{0}; // set once stats exists, so readers on other threads may use it
+        };
+
+        void startWorkers();
+        void startPool(Pool &pool, size_t workerCount, bool queuePerWorker);
+        void workerLoop(Pool &pool, size_t ownQueue, size_t workerIndex);
+        bool takeJob(Pool &pool, size_t ownQueue, PendingJob &job);
+        Pool &poolFor(TaskLane lane, TaskPriority priority);
+
+        std::once_flag m_started;
+        std::mutex m_submitMutex; // orders submit() against shutdown() setting m_stopping
+        std::atomic<bool> m_stopping{false};
+        Pool m_cpuPool{"cpu"};
+        Pool m_backgroundPool{"background", true};
+        Pool m_ioPool{"io"};
+    };
+
+    extern TaskExecutor theTaskExecutor;
+} // namespace jucyaudio